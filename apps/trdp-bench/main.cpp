@@ -0,0 +1,560 @@
+#include "trdp/config.hpp"
+#include "trdp/dataset.hpp"
+#include "trdp/logging.hpp"
+#include "trdp/pd.hpp"
+#include "trdp/tau.hpp"
+#include "trdp/wire.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace trdp;
+
+namespace
+{
+
+#ifndef TRDP_BENCH_BUILD_TYPE
+#define TRDP_BENCH_BUILD_TYPE ""
+#endif
+
+struct ElementSpec
+{
+    const char *type;
+    uint32_t size;      // STRING/BYTES/UTF16 length, 0 for the type's natural size
+    uint32_t arraySize; // 1 for scalars
+};
+
+/** A synthetic dataset; each one becomes a PD telegram that is both published and subscribed. */
+struct Scenario
+{
+    std::string name;
+    std::vector<ElementSpec> elements;
+};
+
+struct Result
+{
+    std::string benchmark;
+    std::string scenario;
+    std::size_t elements{0};
+    std::size_t bytesPerOp{0}; // payload bytes handled per operation, 0 where it does not apply
+    uint64_t iterations{0};    // per repetition
+    double nsMedian{0};
+    double nsMin{0};
+    double nsMax{0};
+};
+
+struct Options
+{
+    std::string format = "text";
+    std::string output;
+    std::string filter;
+    double minTimeMs = 50.0;
+    int repetitions = 5;
+};
+
+/** Keeps the compiler from discarding work whose result is only written to memory. */
+inline void keep(const void *pointer)
+{
+    asm volatile("" : : "r"(pointer) : "memory");
+}
+
+// Scalar types cycled through by the mixed scenarios (4 bytes per element on average).
+constexpr std::array<const char *, 14> kScalarTypes{"BOOL8",  "UINT8",  "INT8",   "CHAR8",      "UINT16",
+                                                    "INT16",  "UINT32", "INT32",  "REAL32",     "TIMEDATE32",
+                                                    "UINT64", "INT64",  "REAL64", "TIMEDATE64"};
+
+Scenario mixedScenario(const std::string &name, std::size_t count, std::size_t typeCount)
+{
+    Scenario scenario{name, {}};
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        scenario.elements.push_back({kScalarTypes[i % typeCount], 0, 1});
+    }
+    return scenario;
+}
+
+std::vector<Scenario> scenarios()
+{
+    return {
+        mixedScenario("int-16", 16, 8), // integers and booleans only
+        mixedScenario("mixed-64", 64, kScalarTypes.size()),
+        mixedScenario("mixed-256", 256, kScalarTypes.size()),
+        {"arrays", {{"UINT16", 0, 128}, {"REAL32", 0, 64}, {"UINT8", 0, 256}, {"INT32", 0, 32}}},
+        {"strings",
+         {{"STRING", 32, 1},
+          {"STRING", 32, 1},
+          {"STRING", 32, 1},
+          {"STRING", 32, 1},
+          {"BYTES", 128, 1},
+          {"UTF16", 64, 1},
+          {"UINT32", 0, 1}}},
+    };
+}
+
+std::string sampleValue(TrdpType type)
+{
+    switch (type)
+    {
+    case TrdpType::BOOL1:
+        return "true";
+    case TrdpType::CHAR8:
+        return "T";
+    case TrdpType::INT8:
+        return "-7";
+    case TrdpType::UINT8:
+        return "42";
+    case TrdpType::INT16:
+        return "-1234";
+    case TrdpType::UINT16:
+        return "4321";
+    case TrdpType::INT32:
+        return "-123456";
+    case TrdpType::UINT32:
+    case TrdpType::TIMEDATE32:
+        return "1700000000";
+    case TrdpType::INT64:
+        return "-123456789012";
+    case TrdpType::UINT64:
+    case TrdpType::TIMEDATE64:
+        return "1700000000123456";
+    case TrdpType::REAL32:
+        return "3.25";
+    case TrdpType::REAL64:
+        return "-2.5e10";
+    case TrdpType::STRING:
+    case TrdpType::UTF16:
+    case TrdpType::BYTES:
+        return "train-door-3";
+    }
+    return "0";
+}
+
+uint32_t comIdOf(std::size_t scenario)
+{
+    return 60001u + static_cast<uint32_t>(scenario);
+}
+
+/** Device XML with one dataset and one source-less PD telegram per scenario. */
+std::string renderDeviceXml(const std::vector<Scenario> &all)
+{
+    std::ostringstream xml;
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<device host-name=\"trdp-bench\" type=\"bench\">\n"
+        << "  <bus-interface-list>\n    <bus-interface network-id=\"1\" name=\"eth0\" host-ip=\"192.0.2.1\">\n"
+        << "      <pd-com-parameter marshall=\"on\" port=\"17224\" qos=\"5\" ttl=\"64\" timeout-value=\"100000\" />\n";
+    for (std::size_t i = 0; i < all.size(); ++i)
+    {
+        xml << "      <telegram name=\"" << all[i].name << "\" com-id=\"" << comIdOf(i) << "\" data-set-id=\""
+            << comIdOf(i) << "\" com-parameter-id=\"1\">\n"
+            << "        <pd-parameter cycle=\"100000\" timeout=\"1000000\" marshall=\"on\" />\n"
+            << "        <destination id=\"1\" uri=\"239.0.0.1\" />\n      </telegram>\n";
+    }
+    xml << "    </bus-interface>\n  </bus-interface-list>\n"
+        << "  <com-parameter-list>\n    <com-parameter id=\"1\" qos=\"5\" ttl=\"64\" />\n  </com-parameter-list>\n"
+        << "  <data-set-list>\n";
+    for (std::size_t i = 0; i < all.size(); ++i)
+    {
+        xml << "    <data-set name=\"" << all[i].name << "\" id=\"" << comIdOf(i) << "\">\n";
+        for (std::size_t e = 0; e < all[i].elements.size(); ++e)
+        {
+            const auto &spec = all[i].elements[e];
+            xml << "      <element name=\"e" << e << "\" type=\"" << spec.type << "\"";
+            if (spec.size != 0)
+            {
+                xml << " size=\"" << spec.size << "\"";
+            }
+            if (spec.arraySize != 1)
+            {
+                xml << " array-size=\"" << spec.arraySize << "\"";
+            }
+            xml << " />\n";
+        }
+        xml << "    </data-set>\n";
+    }
+    xml << "  </data-set-list>\n</device>\n";
+    return xml.str();
+}
+
+/** The loader reads files, so the synthetic XML goes through a temporary one. */
+std::optional<TrdpConfig> loadSyntheticConfig(const std::vector<Scenario> &all)
+{
+    char path[] = "/tmp/trdp-bench-XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        error("trdp-bench: cannot create a temporary device XML");
+        return std::nullopt;
+    }
+    const auto xml = renderDeviceXml(all);
+    const bool written = write(fd, xml.data(), xml.size()) == static_cast<ssize_t>(xml.size());
+    close(fd);
+    std::optional<TrdpConfig> config;
+    if (written)
+    {
+        config = XmlConfigLoader().loadFromDeviceConfig(path, "", "", "");
+    }
+    unlink(path);
+    return config;
+}
+
+template <typename Fn>
+Result measure(const Options &options, Fn &&operation)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto run = [&](uint64_t iterations) {
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            operation();
+        }
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    };
+
+    // Grow the iteration count until one repetition lasts minTimeMs; this also warms caches.
+    uint64_t iterations = 1;
+    const double targetNs = options.minTimeMs * 1e6;
+    for (double elapsed = run(iterations); elapsed < targetNs; elapsed = run(iterations))
+    {
+        const double scale = elapsed > 0 ? targetNs / elapsed * 1.2 : 10.0;
+        iterations = std::max<uint64_t>(iterations + 1, static_cast<uint64_t>(static_cast<double>(iterations) *
+                                                                              std::min(scale, 10.0)));
+    }
+
+    std::vector<double> samples;
+    for (int r = 0; r < options.repetitions; ++r)
+    {
+        samples.push_back(run(iterations) / static_cast<double>(iterations));
+    }
+    std::sort(samples.begin(), samples.end());
+    Result result;
+    result.iterations = iterations;
+    result.nsMin = samples.front();
+    result.nsMax = samples.back();
+    result.nsMedian = samples[samples.size() / 2];
+    return result;
+}
+
+std::size_t findTelegram(const std::vector<PdPublishTelegram> &telegrams, uint32_t comId)
+{
+    for (std::size_t i = 0; i < telegrams.size(); ++i)
+    {
+        if (telegrams[i].comId == comId)
+        {
+            return i;
+        }
+    }
+    return telegrams.size();
+}
+
+std::size_t findTelegram(const std::vector<PdSubscribeTelegram> &telegrams, uint32_t comId)
+{
+    for (std::size_t i = 0; i < telegrams.size(); ++i)
+    {
+        if (telegrams[i].comId == comId)
+        {
+            return i;
+        }
+    }
+    return telegrams.size();
+}
+
+class BenchRunner
+{
+public:
+    BenchRunner(TrdpConfig &config, const Options &options) : config_(config), pd_(config), options_(options) {}
+
+    void runScenario(const Scenario &scenario, uint32_t comId)
+    {
+        const auto *dataset = config_.datasetRegistry.find(static_cast<uint16_t>(comId));
+        const auto pubIndex = findTelegram(config_.pdPublish, comId);
+        const auto subIndex = findTelegram(config_.pdSubscribe, comId);
+        if (dataset == nullptr || pubIndex == config_.pdPublish.size() || subIndex == config_.pdSubscribe.size())
+        {
+            error("trdp-bench: scenario ", scenario.name, " did not load as a publish and subscribe telegram");
+            return;
+        }
+        const auto hostSize = dataset->payloadSize();
+        const auto elementCount = dataset->elements.size();
+        auto &values = config_.pdPublish[pubIndex].values;
+
+        std::vector<std::string> samples;
+        for (auto &value : values)
+        {
+            samples.push_back(sampleValue(value.element.type));
+            assignValue(value, samples.back());
+        }
+
+        // Inputs for the decode benchmarks, prepared up front so each one measures the same
+        // payload whichever benchmarks --filter selects.
+        std::vector<uint8_t> host(hostSize);
+        packDatasetToPayload(*dataset, values, host.data(), host.size());
+        std::array<uint8_t, kPdMaxDataSize> network{};
+        std::size_t networkSize = 0;
+        pd_.buildPublishPayload(pubIndex, network.data(), network.size(), networkSize);
+
+        std::size_t next = 0;
+        add("assignValue", scenario, elementCount, 0, [&]() {
+            auto &value = values[next];
+            assignValue(value, samples[next]);
+            keep(value.rawValue.data());
+            next = next + 1 == values.size() ? 0 : next + 1;
+        });
+
+        std::vector<uint8_t> packed(hostSize);
+        add("packDatasetToPayload", scenario, elementCount, hostSize, [&]() {
+            packDatasetToPayload(*dataset, values, packed.data(), packed.size());
+            keep(packed.data());
+        });
+
+        ElementValues unpacked;
+        add("unpackPayloadToDataset", scenario, elementCount, hostSize, [&]() {
+            unpackPayloadToDataset(*dataset, host.data(), host.size(), unpacked);
+            keep(unpacked.data());
+        });
+
+        std::array<uint8_t, kPdMaxDataSize> built{};
+        add("PdEngine::buildPublishPayload", scenario, elementCount, hostSize, [&]() {
+            std::size_t size = 0;
+            pd_.buildPublishPayload(pubIndex, built.data(), built.size(), size);
+            keep(built.data());
+        });
+
+        add("PdEngine::updateSubscribeValues", scenario, elementCount, networkSize, [&]() {
+            pd_.updateSubscribeValues(subIndex, network.data(), networkSize);
+            keep(config_.pdSubscribe[subIndex].lastValues.data());
+        });
+
+        const auto *binding = config_.tauMarshaller ? config_.tauMarshaller->binding(comId) : nullptr;
+        if (binding == nullptr)
+        {
+            return;
+        }
+        std::vector<uint8_t> marshalled(std::max<std::size_t>(kPdMaxDataSize, hostSize * 2));
+        std::size_t marshalledSize = marshalled.size();
+        config_.tauMarshaller->marshall(*binding, host.data(), host.size(), marshalled.data(), marshalledSize);
+        add("TauMarshaller::marshall", scenario, elementCount, hostSize, [&]() {
+            std::size_t size = marshalled.size();
+            config_.tauMarshaller->marshall(*binding, host.data(), host.size(), marshalled.data(), size);
+            keep(marshalled.data());
+        });
+        std::vector<uint8_t> roundTrip(std::max<std::size_t>(kPdMaxDataSize, hostSize * 2));
+        add("TauMarshaller::unmarshall", scenario, elementCount, marshalledSize, [&]() {
+            std::size_t size = roundTrip.size();
+            config_.tauMarshaller->unmarshall(*binding, marshalled.data(), marshalledSize, roundTrip.data(), size);
+            keep(roundTrip.data());
+        });
+    }
+
+    const std::vector<Result> &results() const { return results_; }
+
+private:
+    template <typename Fn>
+    void add(const char *benchmark, const Scenario &scenario, std::size_t elements, std::size_t bytes, Fn &&fn)
+    {
+        const auto id = std::string(benchmark) + "/" + scenario.name;
+        if (!options_.filter.empty() && id.find(options_.filter) == std::string::npos)
+        {
+            return;
+        }
+        auto result = measure(options_, fn);
+        result.benchmark = benchmark;
+        result.scenario = scenario.name;
+        result.elements = elements;
+        result.bytesPerOp = bytes;
+        results_.push_back(result);
+        std::cerr << "  " << id << std::endl; // progress, kept off the results stream
+    }
+
+    TrdpConfig &config_;
+    PdEngine pd_;
+    const Options &options_;
+    std::vector<Result> results_;
+};
+
+double megabytesPerSecond(const Result &result)
+{
+    return result.bytesPerOp == 0 ? 0.0 : static_cast<double>(result.bytesPerOp) / result.nsMedian * 1e3;
+}
+
+std::string isoTime()
+{
+    const auto now = std::time(nullptr);
+    std::tm utc{};
+    gmtime_r(&now, &utc);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return text;
+}
+
+std::string buildType()
+{
+    return std::string(TRDP_BENCH_BUILD_TYPE).empty() ? "unspecified" : TRDP_BENCH_BUILD_TYPE;
+}
+
+bool tauAvailable(const TrdpConfig &config)
+{
+    return config.tauMarshaller != nullptr;
+}
+
+void writeText(std::ostream &os, const std::vector<Result> &results, const TrdpConfig &config)
+{
+    os << "build type " << buildType() << ", tau marshalling "
+       << (tauAvailable(config) ? "available" : "not available (built without TRDP)") << "\n";
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-34s %-10s %5s %6s %12s %12s %12s %10s\n", "benchmark", "dataset", "elems",
+                  "bytes", "ns/op", "min", "max", "MB/s");
+    os << line;
+    for (const auto &r : results)
+    {
+        std::snprintf(line, sizeof(line), "%-34s %-10s %5zu %6zu %12.1f %12.1f %12.1f %10.1f\n", r.benchmark.c_str(),
+                      r.scenario.c_str(), r.elements, r.bytesPerOp, r.nsMedian, r.nsMin, r.nsMax, megabytesPerSecond(r));
+        os << line;
+    }
+}
+
+void writeJson(std::ostream &os, const std::vector<Result> &results, const TrdpConfig &config, const Options &options)
+{
+    // Names are fixed ASCII identifiers, so nothing needs escaping.
+    os << "{\n  \"context\": {\"date\": \"" << isoTime() << "\", \"build_type\": \"" << buildType()
+       << "\", \"tau_marshaller\": " << (tauAvailable(config) ? "true" : "false")
+       << ", \"repetitions\": " << options.repetitions << ", \"min_time_ms\": " << options.minTimeMs << "},\n"
+       << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto &r = results[i];
+        char numbers[192];
+        std::snprintf(numbers, sizeof(numbers),
+                      "\"iterations\": %llu, \"ns_per_op\": %.2f, \"ns_min\": %.2f, \"ns_max\": %.2f, "
+                      "\"mb_per_s\": %.2f",
+                      static_cast<unsigned long long>(r.iterations), r.nsMedian, r.nsMin, r.nsMax, megabytesPerSecond(r));
+        os << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << r.benchmark << "/" << r.scenario
+           << "\", \"benchmark\": \"" << r.benchmark << "\", \"dataset\": \"" << r.scenario
+           << "\", \"elements\": " << r.elements << ", \"bytes_per_op\": " << r.bytesPerOp << ", " << numbers << "}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+void writeCsv(std::ostream &os, const std::vector<Result> &results)
+{
+    os << "benchmark,dataset,elements,bytes_per_op,iterations,ns_per_op,ns_min,ns_max,mb_per_s\n";
+    for (const auto &r : results)
+    {
+        char line[192];
+        std::snprintf(line, sizeof(line), "%s,%s,%zu,%zu,%llu,%.2f,%.2f,%.2f,%.2f\n", r.benchmark.c_str(),
+                      r.scenario.c_str(), r.elements, r.bytesPerOp, static_cast<unsigned long long>(r.iterations),
+                      r.nsMedian, r.nsMin, r.nsMax, megabytesPerSecond(r));
+        os << line;
+    }
+}
+
+void printUsage()
+{
+    std::cerr << "Usage: trdp-bench [--format text|json|csv] [--output file] [--filter substring]\n"
+              << "                  [--min-time-ms N] [--repetitions N] [--list]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    bool listOnly = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc)
+        {
+            options.format = argv[++i];
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            options.output = argv[++i];
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--min-time-ms" && i + 1 < argc)
+        {
+            options.minTimeMs = std::max(0.1, std::strtod(argv[++i], nullptr));
+        }
+        else if (arg == "--repetitions" && i + 1 < argc)
+        {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--list")
+        {
+            listOnly = true;
+        }
+        else
+        {
+            printUsage();
+            return 2;
+        }
+    }
+    if (options.format != "text" && options.format != "json" && options.format != "csv")
+    {
+        printUsage();
+        return 2;
+    }
+
+    const auto all = scenarios();
+    if (listOnly)
+    {
+        for (const auto &scenario : all)
+        {
+            std::cout << scenario.name << ": " << scenario.elements.size() << " elements" << std::endl;
+        }
+        return 0;
+    }
+
+    // Log lines share stdout with the results, and the loader's progress is not of interest here.
+    setLogLevel(LogLevel::Error);
+    auto config = loadSyntheticConfig(all);
+    if (!config)
+    {
+        error("trdp-bench: failed to load the synthetic datasets");
+        return 1;
+    }
+
+    BenchRunner runner(*config, options);
+    for (std::size_t i = 0; i < all.size(); ++i)
+    {
+        runner.runScenario(all[i], comIdOf(i));
+    }
+
+    std::ofstream file;
+    if (!options.output.empty())
+    {
+        file.open(options.output, std::ios::trunc);
+        if (!file)
+        {
+            error("trdp-bench: cannot write ", options.output);
+            return 1;
+        }
+    }
+    std::ostream &os = options.output.empty() ? std::cout : file;
+    if (options.format == "json")
+    {
+        writeJson(os, runner.results(), *config, options);
+    }
+    else if (options.format == "csv")
+    {
+        writeCsv(os, runner.results());
+    }
+    else
+    {
+        writeText(os, runner.results(), *config);
+    }
+    return 0;
+}
@@ -0,0 +1,619 @@
+#include "trdp/config.hpp"
+#include "trdp/dataset.hpp"
+#include "trdp/logging.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace trdp;
+
+namespace
+{
+
+enum class WireKind
+{
+    Raw,
+    Be16,
+    Be32,
+    Be64,
+    Real32,
+    Real64,
+    TimeDate64
+};
+
+struct FieldLayout
+{
+    std::string name;
+    std::string cppType;
+    WireKind kind{WireKind::Raw};
+    std::size_t offset{0};
+    std::size_t unitSize{1};
+    std::size_t count{1};
+    const DatasetElementDef *element{nullptr};
+};
+
+struct DatasetLayout
+{
+    const DatasetDef *dataset{nullptr};
+    std::string typeName;
+    std::vector<FieldLayout> fields;
+    std::size_t size{0};
+};
+
+// C++17 keywords and alternative tokens; a name equal to one gets a trailing '_'.
+const std::set<std::string> kKeywords{
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
+    "char", "char16_t", "char32_t", "class", "compl", "const", "constexpr", "const_cast", "continue",
+    "decltype", "default", "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "export",
+    "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace",
+    "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or", "or_eq", "private", "protected", "public",
+    "register", "reinterpret_cast", "return", "short", "signed", "sizeof", "static", "static_assert",
+    "static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef",
+    "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while",
+    "xor", "xor_eq"};
+
+// Types the generated structs use; a field or dataset of that name would hide them.
+const std::set<std::string> kFieldTypeNames{"int8_t",  "uint8_t",  "int16_t", "uint16_t",
+                                            "int32_t", "uint32_t", "int64_t", "uint64_t"};
+
+// Members every generated struct declares besides the fields.
+const std::set<std::string> kReservedMembers{"kSize", "kDatasetId"};
+
+// Names the generated header and source declare next to the dataset structs.
+const std::set<std::string> kReservedTypeNames{"telegrams",     "pack",          "unpack",        "marshall",
+                                               "unmarshall",    "verifyLayouts", "verifyDataset", "ExpectedElement",
+                                               "trdp",          "std"};
+
+/** Append '_' until name is none of reserved. */
+std::string avoidReserved(std::string name, const std::set<std::string> &reserved)
+{
+    while (reserved.count(name) != 0)
+    {
+        name.push_back('_');
+    }
+    return name;
+}
+
+std::string sanitize(const std::string &name, const std::string &fallback)
+{
+    std::string out;
+    for (const char c : name)
+    {
+        out.push_back(std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+    }
+    if (out.empty())
+    {
+        out = fallback;
+    }
+    if (std::isdigit(static_cast<unsigned char>(out.front())))
+    {
+        out.insert(out.begin(), '_');
+    }
+    return avoidReserved(out, kKeywords);
+}
+
+std::string uniqueName(const std::string &base, std::set<std::string> &used)
+{
+    std::string name = base;
+    for (int suffix = 2; used.count(name) != 0; ++suffix)
+    {
+        name = base + "_" + std::to_string(suffix);
+    }
+    used.insert(name);
+    return name;
+}
+
+void classify(const DatasetElementDef &element, FieldLayout &field)
+{
+    const auto unit = defaultElementSize(element.type);
+    const auto total = expectedSize(element) * std::max<std::size_t>(1, element.arrayLength);
+    const bool customSize = element.length != 0 && unit != 0 && element.length != unit;
+
+    auto setRaw = [&](const char *type) {
+        field.cppType = type;
+        field.kind = WireKind::Raw;
+        field.unitSize = 1;
+        field.count = total;
+    };
+
+    if (customSize)
+    {
+        setRaw("uint8_t");
+        return;
+    }
+
+    field.unitSize = unit;
+    field.count = unit != 0 ? total / unit : total;
+    switch (element.type)
+    {
+    case TrdpType::BOOL1:
+    case TrdpType::UINT8:
+        field.cppType = "uint8_t";
+        break;
+    case TrdpType::CHAR8:
+        field.cppType = "char";
+        break;
+    case TrdpType::INT8:
+        field.cppType = "int8_t";
+        break;
+    case TrdpType::INT16:
+        field.cppType = "int16_t";
+        field.kind = WireKind::Be16;
+        break;
+    case TrdpType::UINT16:
+        field.cppType = "uint16_t";
+        field.kind = WireKind::Be16;
+        break;
+    case TrdpType::INT32:
+        field.cppType = "int32_t";
+        field.kind = WireKind::Be32;
+        break;
+    case TrdpType::UINT32:
+    case TrdpType::TIMEDATE32:
+        field.cppType = "uint32_t";
+        field.kind = WireKind::Be32;
+        break;
+    case TrdpType::INT64:
+        field.cppType = "int64_t";
+        field.kind = WireKind::Be64;
+        break;
+    case TrdpType::UINT64:
+        field.cppType = "uint64_t";
+        field.kind = WireKind::Be64;
+        break;
+    case TrdpType::REAL32:
+        field.cppType = "float";
+        field.kind = WireKind::Real32;
+        break;
+    case TrdpType::REAL64:
+        field.cppType = "double";
+        field.kind = WireKind::Real64;
+        break;
+    case TrdpType::TIMEDATE64:
+        field.cppType = "trdp::codec::TimeDate64";
+        field.kind = WireKind::TimeDate64;
+        break;
+    case TrdpType::STRING:
+        setRaw("char");
+        break;
+    case TrdpType::BYTES:
+        setRaw("uint8_t");
+        break;
+    case TrdpType::UTF16:
+        if (total % 2u == 0u)
+        {
+            field.cppType = "char16_t";
+            field.kind = WireKind::Be16;
+            field.unitSize = 2;
+            field.count = total / 2u;
+        }
+        else
+        {
+            setRaw("uint8_t");
+        }
+        break;
+    }
+}
+
+bool buildLayout(const DatasetDef &dataset, std::set<std::string> &usedTypeNames, DatasetLayout &layout)
+{
+    layout.dataset = &dataset;
+    auto typeName = sanitize(dataset.name, "Dataset" + std::to_string(dataset.datasetId));
+    typeName = avoidReserved(avoidReserved(typeName, kReservedTypeNames), kFieldTypeNames);
+    layout.typeName = uniqueName(typeName, usedTypeNames);
+
+    std::set<std::string> usedFields;
+    std::size_t cursor = 0;
+    std::vector<const DatasetElementDef *> ordered;
+    for (const auto &element : dataset.elements)
+    {
+        ordered.push_back(&element);
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const auto *a, const auto *b) { return a->offset < b->offset; });
+
+    for (const auto *element : ordered)
+    {
+        const auto total = expectedSize(*element) * std::max<std::size_t>(1, element->arrayLength);
+        if (total == 0)
+        {
+            continue;
+        }
+        if (element->offset < cursor)
+        {
+            error("Dataset '", dataset.name, "' has overlapping element '", element->name, "'");
+            return false;
+        }
+        if (element->offset > cursor)
+        {
+            FieldLayout gap;
+            gap.name = uniqueName("reserved_" + std::to_string(cursor), usedFields);
+            gap.cppType = "uint8_t";
+            gap.offset = cursor;
+            gap.count = element->offset - cursor;
+            layout.fields.push_back(gap);
+        }
+
+        FieldLayout field;
+        auto fieldName = sanitize(element->name, "element");
+        fieldName = avoidReserved(avoidReserved(fieldName, kReservedMembers), kFieldTypeNames);
+        field.name = uniqueName(fieldName, usedFields);
+        field.offset = element->offset;
+        field.element = element;
+        classify(*element, field);
+        layout.fields.push_back(field);
+        cursor = element->offset + total;
+    }
+    layout.size = cursor;
+    return true;
+}
+
+std::string declarator(const FieldLayout &field)
+{
+    if (field.count == 1 && field.element != nullptr && field.element->arrayLength <= 1 &&
+        field.element->type != TrdpType::STRING && field.element->type != TrdpType::BYTES)
+    {
+        return field.cppType + " " + field.name + ";";
+    }
+    return field.cppType + " " + field.name + "[" + std::to_string(field.count) + "];";
+}
+
+bool isArray(const FieldLayout &field)
+{
+    return declarator(field).find('[') != std::string::npos;
+}
+
+void emitMarshallField(std::ostream &os, const FieldLayout &field)
+{
+    const bool array = isArray(field);
+    const std::string ref = array ? "in." + field.name + "[i]" : "in." + field.name;
+    const std::string at =
+        "out + " + std::to_string(field.offset) + (array ? " + i * " + std::to_string(field.unitSize) : "");
+
+    std::string stmt;
+    switch (field.kind)
+    {
+    case WireKind::Raw:
+        os << "    std::memcpy(out + " << field.offset << ", " << (array ? "in." + field.name : "&in." + field.name)
+           << ", " << field.count * field.unitSize << ");\n";
+        return;
+    case WireKind::Be16:
+        stmt = "trdp::codec::storeBe16(" + at + ", static_cast<uint16_t>(" + ref + "));";
+        break;
+    case WireKind::Be32:
+        stmt = "trdp::codec::storeBe32(" + at + ", static_cast<uint32_t>(" + ref + "));";
+        break;
+    case WireKind::Be64:
+        stmt = "trdp::codec::storeBe64(" + at + ", static_cast<uint64_t>(" + ref + "));";
+        break;
+    case WireKind::Real32:
+        stmt = "trdp::codec::storeBe32(" + at + ", trdp::codec::bitCast<uint32_t>(" + ref + "));";
+        break;
+    case WireKind::Real64:
+        stmt = "trdp::codec::storeBe64(" + at + ", trdp::codec::bitCast<uint64_t>(" + ref + "));";
+        break;
+    case WireKind::TimeDate64:
+        stmt = "trdp::codec::storeBe32(" + at + ", " + ref + ".seconds);\n" + std::string(array ? "        " : "    ") +
+               "trdp::codec::storeBe32(" + at + " + 4, static_cast<uint32_t>(" + ref + ".microseconds));";
+        break;
+    }
+
+    if (array)
+    {
+        os << "    for (std::size_t i = 0; i < " << field.count << "; ++i)\n    {\n        " << stmt << "\n    }\n";
+    }
+    else
+    {
+        os << "    " << stmt << "\n";
+    }
+}
+
+void emitUnmarshallField(std::ostream &os, const FieldLayout &field)
+{
+    const bool array = isArray(field);
+    const std::string ref = array ? "out." + field.name + "[i]" : "out." + field.name;
+    const std::string at =
+        "in + " + std::to_string(field.offset) + (array ? " + i * " + std::to_string(field.unitSize) : "");
+
+    std::string stmt;
+    switch (field.kind)
+    {
+    case WireKind::Raw:
+        os << "    std::memcpy(" << (array ? "out." + field.name : "&out." + field.name) << ", in + " << field.offset
+           << ", " << field.count * field.unitSize << ");\n";
+        return;
+    case WireKind::Be16:
+        stmt = ref + " = static_cast<" + field.cppType + ">(trdp::codec::loadBe16(" + at + "));";
+        break;
+    case WireKind::Be32:
+        stmt = ref + " = static_cast<" + field.cppType + ">(trdp::codec::loadBe32(" + at + "));";
+        break;
+    case WireKind::Be64:
+        stmt = ref + " = static_cast<" + field.cppType + ">(trdp::codec::loadBe64(" + at + "));";
+        break;
+    case WireKind::Real32:
+        stmt = ref + " = trdp::codec::bitCast<float>(trdp::codec::loadBe32(" + at + "));";
+        break;
+    case WireKind::Real64:
+        stmt = ref + " = trdp::codec::bitCast<double>(trdp::codec::loadBe64(" + at + "));";
+        break;
+    case WireKind::TimeDate64:
+        stmt = ref + ".seconds = trdp::codec::loadBe32(" + at + ");\n" + std::string(array ? "        " : "    ") + ref +
+               ".microseconds = static_cast<int32_t>(trdp::codec::loadBe32(" + at + " + 4));";
+        break;
+    }
+
+    if (array)
+    {
+        os << "    for (std::size_t i = 0; i < " << field.count << "; ++i)\n    {\n        " << stmt << "\n    }\n";
+    }
+    else
+    {
+        os << "    " << stmt << "\n";
+    }
+}
+
+struct TelegramAlias
+{
+    uint32_t comId;
+    uint16_t datasetId;
+};
+
+// Every ComId the device publishes, subscribes to or exchanges as MD, once, in that order.
+std::vector<TelegramAlias> collectAliases(const TrdpConfig &config)
+{
+    std::vector<TelegramAlias> aliases;
+    std::set<uint32_t> seen;
+    const auto add = [&](uint32_t comId, uint16_t datasetId) {
+        if (seen.insert(comId).second)
+        {
+            aliases.push_back({comId, datasetId});
+        }
+    };
+    for (const auto &telegram : config.pdPublish)
+    {
+        add(telegram.comId, telegram.datasetId);
+    }
+    for (const auto &telegram : config.pdSubscribe)
+    {
+        add(telegram.comId, telegram.datasetId);
+    }
+    for (const auto &tpl : config.mdTemplates)
+    {
+        add(tpl.comId, tpl.datasetId);
+    }
+    return aliases;
+}
+
+std::string renderHeader(const std::vector<DatasetLayout> &layouts,
+                         const std::vector<TelegramAlias> &telegrams,
+                         const std::string &ns,
+                         const std::string &source)
+{
+    std::ostringstream os;
+    os << "// Generated by trdp-codegen from " << source << ". Do not edit.\n";
+    os << "#pragma once\n\n";
+    os << "#include \"trdp/codec.hpp\"\n#include \"trdp/dataset.hpp\"\n\n";
+    os << "#include <cstddef>\n#include <cstdint>\n#include <cstring>\n\n";
+    os << "namespace " << ns << "\n{\n\n";
+
+    for (const auto &layout : layouts)
+    {
+        const auto &name = layout.typeName;
+        os << "#pragma pack(push, 1)\n";
+        os << "struct " << name << "\n{\n";
+        os << "    static constexpr uint16_t kDatasetId = " << layout.dataset->datasetId << "u;\n";
+        os << "    static constexpr std::size_t kSize = " << layout.size << "u;\n\n";
+        for (const auto &field : layout.fields)
+        {
+            os << "    " << declarator(field) << "\n";
+        }
+        os << "};\n#pragma pack(pop)\n\n";
+        os << "static_assert(sizeof(" << name << ") == " << name << "::kSize, \"" << name
+           << " layout does not match the dataset size\");\n";
+        for (const auto &field : layout.fields)
+        {
+            os << "static_assert(offsetof(" << name << ", " << field.name << ") == " << field.offset << "u, \"" << name
+               << "::" << field.name << " offset\");\n";
+        }
+        os << "\n";
+
+        os << "// Host-order payload, byte-identical to trdp::packDatasetToPayload().\n";
+        os << "inline void pack(const " << name << " &in, uint8_t *out)\n{\n";
+        os << "    std::memcpy(out, &in, " << name << "::kSize);\n}\n\n";
+        os << "inline void unpack(const uint8_t *in, " << name << " &out)\n{\n";
+        os << "    std::memcpy(&out, in, " << name << "::kSize);\n}\n\n";
+
+        os << "// Network-order (big-endian) payload as produced by tau_marshall().\n";
+        os << "inline void marshall(const " << name << " &in, uint8_t *out)\n{\n";
+        if (layout.fields.empty())
+        {
+            os << "    (void)in;\n    (void)out;\n";
+        }
+        for (const auto &field : layout.fields)
+        {
+            emitMarshallField(os, field);
+        }
+        os << "}\n\n";
+        os << "inline void unmarshall(const uint8_t *in, " << name << " &out)\n{\n";
+        if (layout.fields.empty())
+        {
+            os << "    (void)in;\n    (void)out;\n";
+        }
+        for (const auto &field : layout.fields)
+        {
+            emitUnmarshallField(os, field);
+        }
+        os << "}\n\n";
+    }
+
+    os << "namespace telegrams\n{\n";
+    for (const auto &telegram : telegrams)
+    {
+        const auto layout = std::find_if(layouts.begin(), layouts.end(),
+                                         [&](const auto &l) { return l.dataset->datasetId == telegram.datasetId; });
+        if (layout == layouts.end())
+        {
+            continue;
+        }
+        os << "struct ComId" << telegram.comId << "\n{\n";
+        os << "    static constexpr uint32_t comId = " << telegram.comId << "u;\n";
+        os << "    using Dataset = " << layout->typeName << ";\n};\n";
+    }
+    os << "} // namespace telegrams\n\n";
+
+    os << "/**\n * Check the generated layouts against a runtime registry, e.g. one loaded from a newer XML.\n"
+          " * Logs every mismatch and returns false if any dataset differs.\n */\n";
+    os << "bool verifyLayouts(const trdp::DatasetRegistry &registry);\n\n";
+    os << "} // namespace " << ns << "\n";
+    return os.str();
+}
+
+std::string renderSource(const std::vector<DatasetLayout> &layouts,
+                         const std::string &ns,
+                         const std::string &headerName,
+                         const std::string &source)
+{
+    std::ostringstream os;
+    os << "// Generated by trdp-codegen from " << source << ". Do not edit.\n";
+    os << "#include \"" << headerName << "\"\n\n";
+    os << "#include \"trdp/logging.hpp\"\n\n#include <string>\n\n";
+    os << "namespace " << ns << "\n{\nnamespace\n{\n";
+    os << "struct ExpectedElement\n{\n    const char *name;\n    std::size_t offset;\n    std::size_t size;\n};\n\n";
+    os << "bool verifyDataset(const trdp::DatasetRegistry &registry,\n"
+          "                   uint16_t datasetId,\n"
+          "                   std::size_t size,\n"
+          "                   const ExpectedElement *elements,\n"
+          "                   std::size_t count)\n{\n";
+    os << "    const auto *dataset = registry.find(datasetId);\n";
+    os << "    if (dataset == nullptr)\n    {\n"
+          "        trdp::warn(\"Generated dataset \", datasetId, \" missing from registry\");\n"
+          "        return false;\n    }\n";
+    os << "    bool ok = dataset->payloadSize() == size;\n";
+    os << "    for (std::size_t i = 0; i < count; ++i)\n    {\n";
+    os << "        const auto *element = dataset->find(elements[i].name);\n";
+    os << "        if (element == nullptr || element->offset != elements[i].offset ||\n"
+          "            trdp::expectedSize(*element) * (element->arrayLength > 1 ? element->arrayLength : 1) != elements[i].size)\n"
+          "        {\n"
+          "            trdp::warn(\"Generated layout for element '\", elements[i].name, \"' of dataset \", datasetId,\n"
+          "                       \" differs from the registry\");\n"
+          "            ok = false;\n        }\n    }\n";
+    os << "    return ok;\n}\n} // namespace\n\n";
+
+    os << "bool verifyLayouts(const trdp::DatasetRegistry &registry)\n{\n    bool ok = true;\n";
+    for (const auto &layout : layouts)
+    {
+        std::vector<const FieldLayout *> named;
+        for (const auto &field : layout.fields)
+        {
+            if (field.element != nullptr)
+            {
+                named.push_back(&field);
+            }
+        }
+        os << "    {\n";
+        if (named.empty())
+        {
+            os << "        ok = verifyDataset(registry, " << layout.dataset->datasetId << "u, " << layout.size
+               << "u, nullptr, 0u) && ok;\n";
+        }
+        else
+        {
+            os << "        static const ExpectedElement elements[] = {\n";
+            for (const auto *field : named)
+            {
+                std::string escaped;
+                for (const char c : field->element->name)
+                {
+                    if (c == '"' || c == '\\')
+                    {
+                        escaped.push_back('\\');
+                    }
+                    escaped.push_back(c);
+                }
+                os << "            {\"" << escaped << "\", " << field->offset << "u, " << field->count * field->unitSize
+                   << "u},\n";
+            }
+            os << "        };\n";
+            os << "        ok = verifyDataset(registry, " << layout.dataset->datasetId << "u, " << layout.size
+               << "u, elements, " << named.size() << "u) && ok;\n";
+        }
+        os << "    }\n";
+    }
+    os << "    return ok;\n}\n\n} // namespace " << ns << "\n";
+    return os.str();
+}
+
+bool writeIfChanged(const std::string &path, const std::string &content)
+{
+    {
+        std::ifstream existing(path, std::ios::binary);
+        if (existing)
+        {
+            std::ostringstream current;
+            current << existing.rdbuf();
+            if (current.str() == content)
+            {
+                return true;
+            }
+        }
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+    return static_cast<bool>(out);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "Usage: trdp-codegen <device.xml> <output-dir> <basename> [namespace]" << std::endl;
+        return 2;
+    }
+
+    const std::string deviceFile = argv[1];
+    const std::string outputDir = argv[2];
+    const std::string baseName = argv[3];
+    const std::string ns = argc > 4 ? argv[4] : sanitize(baseName, "trdp_codecs");
+
+    XmlConfigLoader loader;
+    const auto config = loader.loadFromDeviceConfig(deviceFile, "", "", "");
+    if (!config)
+    {
+        error("trdp-codegen: failed to load ", deviceFile);
+        return 1;
+    }
+
+    auto datasets = config->datasetRegistry.list();
+    std::sort(datasets.begin(), datasets.end(), [](const auto &a, const auto &b) { return a.datasetId < b.datasetId; });
+
+    std::vector<DatasetLayout> layouts;
+    std::set<std::string> usedTypeNames;
+    for (const auto &dataset : datasets)
+    {
+        DatasetLayout layout;
+        if (!buildLayout(dataset, usedTypeNames, layout))
+        {
+            return 1;
+        }
+        layouts.push_back(std::move(layout));
+    }
+
+    const auto headerName = baseName + ".hpp";
+    if (!writeIfChanged(outputDir + "/" + headerName, renderHeader(layouts, collectAliases(*config), ns, deviceFile)) ||
+        !writeIfChanged(outputDir + "/" + baseName + ".cpp", renderSource(layouts, ns, headerName, deviceFile)))
+    {
+        error("trdp-codegen: failed to write output to ", outputDir);
+        return 1;
+    }
+
+    info("trdp-codegen: generated ", layouts.size(), " dataset codecs into ", outputDir);
+    return 0;
+}
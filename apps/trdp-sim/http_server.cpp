@@ -0,0 +1,849 @@
+#include "http_server.hpp"
+
+#include "trdp/logging.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace trdp
+{
+
+namespace
+{
+constexpr std::size_t kMaxHeaderBytes = 16 * 1024;
+constexpr std::size_t kMaxBodyBytes = 1024 * 1024;
+constexpr std::size_t kReadChunk = 16 * 1024;
+constexpr int kMaxEvents = 64;
+constexpr auto kIdleTimeout = std::chrono::seconds(30);
+
+using Clock = std::chrono::steady_clock;
+
+bool equalsIgnoreCase(const std::string &a, const std::string &b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+std::string trim(const std::string &value)
+{
+    const auto begin = value.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+    {
+        return {};
+    }
+    const auto end = value.find_last_not_of(" \t\r");
+    return value.substr(begin, end - begin + 1);
+}
+
+enum class ParseResult
+{
+    Incomplete,
+    Complete,
+    Invalid,
+    TooLarge,
+    Unsupported
+};
+
+/**
+ * Parse one request from the front of buffer. On success the request bytes are consumed, so
+ * any pipelined bytes stay in the buffer for the next call.
+ */
+ParseResult parseRequest(std::string &buffer, HttpRequest &out)
+{
+    const auto headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == std::string::npos)
+    {
+        return buffer.size() > kMaxHeaderBytes ? ParseResult::TooLarge : ParseResult::Incomplete;
+    }
+    if (headerEnd > kMaxHeaderBytes)
+    {
+        return ParseResult::TooLarge;
+    }
+
+    std::istringstream lines(buffer.substr(0, headerEnd));
+    std::string requestLine;
+    std::getline(lines, requestLine);
+    if (!requestLine.empty() && requestLine.back() == '\r')
+    {
+        requestLine.pop_back();
+    }
+    std::istringstream requestLineStream(requestLine);
+    HttpRequest request;
+    if (!(requestLineStream >> request.method >> request.path >> request.version))
+    {
+        return ParseResult::Invalid;
+    }
+    const auto queryStart = request.path.find('?');
+    if (queryStart != std::string::npos)
+    {
+        request.query = request.path.substr(queryStart + 1);
+        request.path.erase(queryStart);
+    }
+
+    std::size_t contentLength = 0;
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        const auto colon = line.find(':');
+        if (colon == std::string::npos)
+        {
+            continue;
+        }
+        auto name = trim(line.substr(0, colon));
+        auto value = trim(line.substr(colon + 1));
+        if (equalsIgnoreCase(name, "Content-Length"))
+        {
+            char *end = nullptr;
+            errno = 0;
+            const auto parsed = std::strtoull(value.c_str(), &end, 10);
+            if (value.empty() || errno != 0 || *end != '\0')
+            {
+                return ParseResult::Invalid;
+            }
+            if (parsed > kMaxBodyBytes)
+            {
+                return ParseResult::TooLarge;
+            }
+            contentLength = static_cast<std::size_t>(parsed);
+        }
+        else if (equalsIgnoreCase(name, "Transfer-Encoding") && !equalsIgnoreCase(value, "identity"))
+        {
+            return ParseResult::Unsupported;
+        }
+        request.headers.emplace_back(std::move(name), std::move(value));
+    }
+
+    const auto bodyStart = headerEnd + 4;
+    if (buffer.size() - bodyStart < contentLength)
+    {
+        return ParseResult::Incomplete;
+    }
+    request.body = buffer.substr(bodyStart, contentLength);
+    buffer.erase(0, bodyStart + contentLength);
+    out = std::move(request);
+    return ParseResult::Complete;
+}
+
+bool wantsKeepAlive(const HttpRequest &request)
+{
+    const auto connection = request.header("Connection");
+    if (request.version == "HTTP/1.0")
+    {
+        return equalsIgnoreCase(connection, "keep-alive");
+    }
+    return !equalsIgnoreCase(connection, "close");
+}
+
+std::string serialize(const HttpResponse &response, bool keepAlive)
+{
+    std::string out;
+    out.reserve(128 + response.body.size());
+    out += "HTTP/1.1 " + std::to_string(response.status) + " " + response.statusText + "\r\n";
+    // 304 and 204 never carry a body; a streamed body runs until the connection closes.
+    const bool bodyless = response.status == 304 || response.status == 204;
+    if (!bodyless)
+    {
+        out += "Content-Type: " + response.contentType + "\r\n";
+    }
+    if (!bodyless && !response.stream)
+    {
+        out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    }
+    for (const auto &header : response.headers)
+    {
+        out += header.first + ": " + header.second + "\r\n";
+    }
+    out += keepAlive && !response.stream ? "Connection: keep-alive\r\nKeep-Alive: timeout=30\r\n\r\n"
+                                         : "Connection: close\r\n\r\n";
+    out += response.body;
+    return out;
+}
+
+HttpResponse errorResponse(int status, const std::string &statusText)
+{
+    HttpResponse response;
+    response.status = status;
+    response.statusText = statusText;
+    response.body = "{\"error\":\"" + statusText + "\"}\n";
+    return response;
+}
+} // namespace
+
+struct HttpServer::Connection
+{
+    int fd{-1};
+    uint64_t generation{0};
+    std::string in;
+    std::string out;
+    std::size_t outOffset{0};
+    uint32_t events{0};
+    bool busy{false};            // a request is with the workers
+    bool closeAfterWrite{false}; // no more requests will be read
+    std::shared_ptr<HttpStream> stream; // set once the connection carries a streamed response
+    Clock::time_point lastActivity{Clock::now()};
+};
+
+std::string HttpRequest::header(const std::string &name) const
+{
+    for (const auto &entry : headers)
+    {
+        if (equalsIgnoreCase(entry.first, name))
+        {
+            return entry.second;
+        }
+    }
+    return {};
+}
+
+std::string urlDecode(const std::string &value)
+{
+    std::string result;
+    result.reserve(value.size());
+    for (std::size_t i = 0; i < value.size(); ++i)
+    {
+        if (value[i] == '%' && i + 2 < value.size() && std::isxdigit(static_cast<unsigned char>(value[i + 1])) &&
+            std::isxdigit(static_cast<unsigned char>(value[i + 2])))
+        {
+            result.push_back(static_cast<char>(std::strtol(value.substr(i + 1, 2).c_str(), nullptr, 16)));
+            i += 2;
+        }
+        else if (value[i] == '+')
+        {
+            result.push_back(' ');
+        }
+        else
+        {
+            result.push_back(value[i]);
+        }
+    }
+    return result;
+}
+
+std::optional<std::string> HttpRequest::queryParam(const std::string &name) const
+{
+    std::size_t start = 0;
+    while (start <= query.size())
+    {
+        auto end = query.find('&', start);
+        if (end == std::string::npos)
+        {
+            end = query.size();
+        }
+        const auto pair = query.substr(start, end - start);
+        const auto equals = pair.find('=');
+        if (urlDecode(pair.substr(0, equals)) == name)
+        {
+            return equals == std::string::npos ? std::string() : urlDecode(pair.substr(equals + 1));
+        }
+        start = end + 1;
+    }
+    return std::nullopt;
+}
+
+bool HttpStream::write(const std::string &bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // An empty queue takes any write, so one snapshot larger than the bound still goes out.
+    if (detached_ || closeRequested_ || (!queue_.empty() && queue_.size() + bytes.size() > maxQueuedBytes_))
+    {
+        return false;
+    }
+    const bool wasEmpty = queue_.empty();
+    queue_ += bytes;
+    if (wasEmpty && wake_)
+    {
+        wake_();
+    }
+    return true;
+}
+
+void HttpStream::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    closeRequested_ = true;
+    if (wake_)
+    {
+        wake_();
+    }
+}
+
+bool HttpStream::closed() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return detached_ || closeRequested_;
+}
+
+std::size_t HttpStream::queuedBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+void HttpStream::attach(std::function<void()> wake)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_ = std::move(wake);
+}
+
+void HttpStream::detach()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    detached_ = true;
+    wake_ = nullptr;
+    queue_.clear();
+}
+
+std::string HttpStream::take()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string bytes;
+    bytes.swap(queue_);
+    return bytes;
+}
+
+bool HttpStream::closeRequested() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closeRequested_;
+}
+
+HttpServer::HttpServer(HttpHandler handler, std::size_t workerCount)
+    : handler_(std::move(handler)), workerCount_(std::max<std::size_t>(1, workerCount))
+{
+}
+
+HttpServer::~HttpServer()
+{
+    stop();
+}
+
+bool HttpServer::start(uint16_t port)
+{
+    port_ = port;
+    listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0)
+    {
+        error("Failed to create HTTP socket");
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port_);
+    if (bind(listenFd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        error("Failed to bind HTTP server socket: ", std::strerror(errno));
+        stop();
+        return false;
+    }
+    if (listen(listenFd_, SOMAXCONN) < 0)
+    {
+        error("Failed to listen on HTTP server socket");
+        stop();
+        return false;
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0)
+    {
+        error("Failed to set up HTTP event loop");
+        stop();
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+    event.data.fd = wakeFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+
+    running_.store(true);
+    eventThread_ = std::thread([this]() { eventLoop(); });
+    for (std::size_t i = 0; i < workerCount_; ++i)
+    {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+
+    info("HTTP server listening on port ", port_, " (", workerCount_, " workers)");
+    return true;
+}
+
+void HttpServer::stop()
+{
+    running_.store(false);
+    if (wakeFd_ >= 0)
+    {
+        const uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+    }
+    jobReady_.notify_all();
+    if (eventThread_.joinable())
+    {
+        eventThread_.join();
+    }
+    for (auto &worker : workers_)
+    {
+        worker.join();
+    }
+    workers_.clear();
+
+    for (auto &entry : connections_)
+    {
+        if (entry.second->stream)
+        {
+            entry.second->stream->detach();
+        }
+        ::close(entry.first);
+    }
+    connections_.clear();
+    streamFds_.clear();
+    for (int *fd : {&listenFd_, &epollFd_, &wakeFd_})
+    {
+        if (*fd >= 0)
+        {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void HttpServer::eventLoop()
+{
+    epoll_event events[kMaxEvents];
+    auto lastSweep = Clock::now();
+    while (running_.load())
+    {
+        const int ready = epoll_wait(epollFd_, events, kMaxEvents, 1000);
+        for (int i = 0; i < ready; ++i)
+        {
+            const int fd = events[i].data.fd;
+            const uint32_t flags = events[i].events;
+            if (fd == listenFd_)
+            {
+                acceptClients();
+                continue;
+            }
+            if (fd == wakeFd_)
+            {
+                uint64_t count = 0;
+                (void)!read(wakeFd_, &count, sizeof(count));
+                drainCompletions();
+                flushStreams();
+                continue;
+            }
+
+            auto it = connections_.find(fd);
+            if (it == connections_.end())
+            {
+                continue;
+            }
+            if (flags & (EPOLLERR | EPOLLHUP))
+            {
+                closeConnection(fd);
+                continue;
+            }
+            if (it->second->stream)
+            {
+                // Push channel: the client only ever sends a close.
+                if (flags & EPOLLRDHUP)
+                {
+                    closeConnection(fd);
+                    continue;
+                }
+                if (flags & EPOLLIN)
+                {
+                    discardInput(*it->second);
+                    it = connections_.find(fd);
+                }
+                if (it != connections_.end() && (flags & EPOLLOUT))
+                {
+                    writeClient(*it->second);
+                }
+                continue;
+            }
+            if ((flags & EPOLLRDHUP) && !(it->second->events & EPOLLIN))
+            {
+                // Half-closed while a request is in flight: still deliver its response.
+                auto &connection = *it->second;
+                connection.closeAfterWrite = true;
+                updateInterest(connection, connection.events & EPOLLOUT);
+                if (!connection.busy && connection.out.empty())
+                {
+                    closeConnection(fd);
+                    continue;
+                }
+            }
+            if (flags & EPOLLIN)
+            {
+                readClient(*it->second);
+                it = connections_.find(fd);
+                if (it == connections_.end())
+                {
+                    continue;
+                }
+            }
+            if (flags & EPOLLOUT)
+            {
+                writeClient(*it->second);
+            }
+        }
+
+        if (Clock::now() - lastSweep > std::chrono::seconds(1))
+        {
+            closeIdle();
+            lastSweep = Clock::now();
+        }
+    }
+}
+
+void HttpServer::acceptClients()
+{
+    while (true)
+    {
+        const int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            return; // EAGAIN once the backlog is drained
+        }
+        int opt = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->generation = nextGeneration_++;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            ::close(fd);
+            continue;
+        }
+        connection->events = event.events;
+        connections_[fd] = std::move(connection);
+    }
+}
+
+void HttpServer::readClient(Connection &connection)
+{
+    char buffer[kReadChunk];
+    bool peerClosed = false;
+    while (true)
+    {
+        const ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            connection.in.append(buffer, static_cast<std::size_t>(received));
+            if (connection.in.size() > kMaxHeaderBytes + kMaxBodyBytes)
+            {
+                break; // parsing rejects it below
+            }
+            continue;
+        }
+        if (received == 0)
+        {
+            peerClosed = true;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            closeConnection(connection.fd);
+            return;
+        }
+        break;
+    }
+    connection.lastActivity = Clock::now();
+
+    if (peerClosed)
+    {
+        // The client will not send more; answer what is already buffered, then close.
+        connection.closeAfterWrite = true;
+        updateInterest(connection, connection.events & EPOLLOUT);
+    }
+    const int fd = connection.fd;
+    processBuffered(connection);
+    const auto it = connections_.find(fd);
+    if (it != connections_.end() && peerClosed && !it->second->busy && it->second->out.empty())
+    {
+        closeConnection(fd);
+    }
+}
+
+void HttpServer::processBuffered(Connection &connection)
+{
+    if (connection.busy || !connection.out.empty())
+    {
+        return;
+    }
+
+    HttpRequest request;
+    const auto result = parseRequest(connection.in, request);
+    switch (result)
+    {
+    case ParseResult::Incomplete:
+        return;
+    case ParseResult::Complete:
+        break;
+    case ParseResult::Invalid:
+        connection.out = serialize(errorResponse(400, "Bad Request"), false);
+        break;
+    case ParseResult::TooLarge:
+        connection.out = serialize(errorResponse(413, "Payload Too Large"), false);
+        break;
+    case ParseResult::Unsupported:
+        connection.out = serialize(errorResponse(501, "Not Implemented"), false);
+        break;
+    }
+    if (result != ParseResult::Complete)
+    {
+        connection.in.clear();
+        connection.closeAfterWrite = true;
+        writeClient(connection);
+        return;
+    }
+
+    const bool keepAlive = wantsKeepAlive(request) && !connection.closeAfterWrite;
+    connection.busy = true;
+    // Stop reading while the request is being handled; pipelined bytes wait in connection.in.
+    updateInterest(connection, connection.closeAfterWrite ? 0u : EPOLLRDHUP);
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        jobs_.push_back(Job{connection.fd, connection.generation, std::move(request), keepAlive});
+    }
+    jobReady_.notify_one();
+}
+
+void HttpServer::writeClient(Connection &connection)
+{
+    do
+    {
+        while (connection.outOffset < connection.out.size())
+        {
+            const ssize_t sent = send(connection.fd, connection.out.data() + connection.outOffset,
+                                      connection.out.size() - connection.outOffset, MSG_NOSIGNAL);
+            if (sent > 0)
+            {
+                connection.outOffset += static_cast<std::size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                updateInterest(connection, EPOLLOUT | (connection.events & EPOLLRDHUP));
+                return;
+            }
+            closeConnection(connection.fd);
+            return;
+        }
+
+        connection.out.clear();
+        connection.outOffset = 0;
+        connection.lastActivity = Clock::now();
+    } while (connection.stream && refillFromStream(connection));
+
+    if (connection.stream)
+    {
+        if (connection.stream->closeRequested())
+        {
+            closeConnection(connection.fd);
+            return;
+        }
+        // Reading only serves to notice the client going away.
+        updateInterest(connection, EPOLLIN | EPOLLRDHUP);
+        return;
+    }
+    if (connection.closeAfterWrite)
+    {
+        closeConnection(connection.fd);
+        return;
+    }
+    updateInterest(connection, EPOLLIN | EPOLLRDHUP);
+    processBuffered(connection);
+}
+
+void HttpServer::drainCompletions()
+{
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        completions.swap(completions_);
+    }
+    for (auto &completion : completions)
+    {
+        const auto it = connections_.find(completion.fd);
+        if (it == connections_.end() || it->second->generation != completion.generation)
+        {
+            continue; // client went away while the request was handled
+        }
+        auto &connection = *it->second;
+        connection.busy = false;
+        connection.closeAfterWrite = connection.closeAfterWrite || !completion.keepAlive;
+        connection.out = std::move(completion.bytes);
+        connection.outOffset = 0;
+        if (completion.stream)
+        {
+            connection.stream = std::move(completion.stream);
+            connection.in.clear(); // a push channel answers no further requests
+            const int wakeFd = wakeFd_;
+            connection.stream->attach([wakeFd]() {
+                const uint64_t one = 1;
+                (void)!write(wakeFd, &one, sizeof(one));
+            });
+            streamFds_.push_back(connection.fd);
+        }
+        writeClient(connection);
+    }
+    for (auto &completion : completions)
+    {
+        if (completion.stream)
+        {
+            completion.stream->detach(); // not moved out above: its client went away
+        }
+    }
+}
+
+void HttpServer::flushStreams()
+{
+    const auto fds = streamFds_;
+    for (const int fd : fds)
+    {
+        const auto it = connections_.find(fd);
+        if (it != connections_.end() && it->second->out.empty())
+        {
+            writeClient(*it->second);
+        }
+    }
+}
+
+bool HttpServer::refillFromStream(Connection &connection)
+{
+    connection.out = connection.stream->take();
+    connection.outOffset = 0;
+    return !connection.out.empty();
+}
+
+void HttpServer::discardInput(Connection &connection)
+{
+    char buffer[1024];
+    while (true)
+    {
+        const ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received > 0 || (received < 0 && errno == EINTR))
+        {
+            continue;
+        }
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            closeConnection(connection.fd);
+        }
+        return;
+    }
+}
+
+void HttpServer::workerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex_);
+            jobReady_.wait(lock, [this]() { return !jobs_.empty() || !running_.load(); });
+            if (!running_.load())
+            {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        HttpResponse response;
+        try
+        {
+            response = handler_(job.request);
+        }
+        catch (const std::exception &ex)
+        {
+            warn("HTTP handler failed for ", job.request.method, " ", job.request.path, ": ", ex.what());
+            response = errorResponse(400, "Bad Request");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            completions_.push_back(Completion{job.fd, job.generation, serialize(response, job.keepAlive), job.keepAlive,
+                                              std::move(response.stream)});
+        }
+        const uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+void HttpServer::updateInterest(Connection &connection, uint32_t events)
+{
+    if (connection.events == events)
+    {
+        return;
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = connection.fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection.fd, &event);
+    connection.events = events;
+}
+
+void HttpServer::closeConnection(int fd)
+{
+    const auto it = connections_.find(fd);
+    if (it != connections_.end() && it->second->stream)
+    {
+        it->second->stream->detach();
+        streamFds_.erase(std::remove(streamFds_.begin(), streamFds_.end(), fd), streamFds_.end());
+    }
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections_.erase(fd);
+}
+
+void HttpServer::closeIdle()
+{
+    const auto now = Clock::now();
+    std::vector<int> idle;
+    for (const auto &entry : connections_)
+    {
+        const auto &connection = *entry.second;
+        if (!connection.stream && !connection.busy && connection.out.empty() &&
+            now - connection.lastActivity > kIdleTimeout)
+        {
+            idle.push_back(entry.first);
+        }
+    }
+    for (const int fd : idle)
+    {
+        closeConnection(fd);
+    }
+}
+
+} // namespace trdp
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace trdp
+{
+
+/** Percent-decode a path segment or query component ('+' reads as a space). */
+std::string urlDecode(const std::string &value);
+
+struct HttpRequest
+{
+    std::string method;
+    std::string path;  // without the query string
+    std::string query; // raw text after '?', if any
+    std::string version;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+
+    /** Value of the first header with this name (case-insensitive), or an empty string. */
+    std::string header(const std::string &name) const;
+
+    /** Decoded value of the first query parameter with this name, or std::nullopt. */
+    std::optional<std::string> queryParam(const std::string &name) const;
+};
+
+/**
+ * Body of a long-lived response (e.g. text/event-stream) that the application keeps writing to
+ * after the handler returned. Writes are queued here and flushed by the server's event thread.
+ * The queue is bounded so a slow client never blocks a writer: write() refuses data that would
+ * overflow it and the writer decides what to drop or coalesce.
+ */
+class HttpStream
+{
+public:
+    explicit HttpStream(std::size_t maxQueuedBytes = 256 * 1024) : maxQueuedBytes_(maxQueuedBytes) {}
+
+    /**
+     * Queue bytes for the client. False if the client is gone or the queue would overflow; an
+     * empty queue accepts a write of any size.
+     */
+    bool write(const std::string &bytes);
+    /** Finish the response; the connection closes once queued bytes are sent. */
+    void close();
+    bool closed() const;
+    std::size_t queuedBytes() const;
+
+private:
+    friend class HttpServer;
+
+    void attach(std::function<void()> wake);
+    void detach();
+    std::string take();
+    bool closeRequested() const;
+
+    mutable std::mutex mutex_;
+    std::string queue_;
+    std::size_t maxQueuedBytes_;
+    std::function<void()> wake_;
+    bool detached_{false};
+    bool closeRequested_{false};
+};
+
+struct HttpResponse
+{
+    int status{200};
+    std::string statusText{"OK"};
+    std::string contentType{"application/json"};
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+
+    // When set, the response has no Content-Length: body is sent first, then whatever the
+    // application writes to the stream, until either side closes the connection.
+    std::shared_ptr<HttpStream> stream;
+};
+
+using HttpHandler = std::function<HttpResponse(const HttpRequest &)>;
+
+/**
+ * Small HTTP/1.1 server: one epoll thread owns all sockets (non-blocking, partial reads and
+ * writes buffered per connection) and hands complete requests to a pool of worker threads
+ * that run the handler. Connections are kept alive unless the client asks otherwise, and
+ * each connection has at most one request in flight so responses stay in order. A response
+ * carrying an HttpStream turns its connection into a push channel that reads no further
+ * requests.
+ */
+class HttpServer
+{
+public:
+    explicit HttpServer(HttpHandler handler, std::size_t workerCount = 4);
+    ~HttpServer();
+
+    HttpServer(const HttpServer &) = delete;
+    HttpServer &operator=(const HttpServer &) = delete;
+
+    bool start(uint16_t port);
+    void stop();
+
+private:
+    struct Connection;
+
+    struct Job
+    {
+        int fd;
+        uint64_t generation;
+        HttpRequest request;
+        bool keepAlive;
+    };
+
+    struct Completion
+    {
+        int fd;
+        uint64_t generation;
+        std::string bytes;
+        bool keepAlive;
+        std::shared_ptr<HttpStream> stream;
+    };
+
+    void eventLoop();
+    void workerLoop();
+
+    void acceptClients();
+    void readClient(Connection &connection);
+    void processBuffered(Connection &connection);
+    void writeClient(Connection &connection);
+    void drainCompletions();
+    void flushStreams();
+    bool refillFromStream(Connection &connection);
+    void discardInput(Connection &connection);
+    void closeConnection(int fd);
+    void updateInterest(Connection &connection, uint32_t events);
+    void closeIdle();
+
+    HttpHandler handler_;
+    std::size_t workerCount_;
+    uint16_t port_{0};
+    int listenFd_{-1};
+    int epollFd_{-1};
+    int wakeFd_{-1};
+    std::atomic_bool running_{false};
+    std::thread eventThread_;
+    std::vector<std::thread> workers_;
+
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_; // event thread only
+    std::vector<int> streamFds_;                                       // event thread only
+    uint64_t nextGeneration_{1};
+
+    std::mutex jobMutex_;
+    std::condition_variable jobReady_;
+    std::deque<Job> jobs_;
+
+    std::mutex completionMutex_;
+    std::vector<Completion> completions_;
+};
+
+} // namespace trdp
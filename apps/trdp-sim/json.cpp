@@ -0,0 +1,453 @@
+#include "json.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace trdp
+{
+
+class JsonParser
+{
+public:
+    explicit JsonParser(const std::string &text) : text_(text) {}
+
+    std::optional<JsonValue> parseDocument(std::string *error)
+    {
+        JsonValue root;
+        skipWhitespace();
+        if (!parseValue(root, 0))
+        {
+            return fail(error);
+        }
+        skipWhitespace();
+        if (pos_ != text_.size())
+        {
+            message_ = "unexpected trailing characters";
+            return fail(error);
+        }
+        return root;
+    }
+
+private:
+    static constexpr int kMaxDepth = 64;
+
+    std::optional<JsonValue> fail(std::string *error) const
+    {
+        if (error)
+        {
+            *error = message_ + " at offset " + std::to_string(pos_);
+        }
+        return std::nullopt;
+    }
+
+    bool expected(const char *what)
+    {
+        message_ = std::string("expected ") + what;
+        return false;
+    }
+
+    void skipWhitespace()
+    {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r'))
+        {
+            ++pos_;
+        }
+    }
+
+    bool consumeLiteral(const char *literal)
+    {
+        const std::string word(literal);
+        if (text_.compare(pos_, word.size(), word) != 0)
+        {
+            return expected("a value");
+        }
+        pos_ += word.size();
+        return true;
+    }
+
+    bool parseValue(JsonValue &out, int depth)
+    {
+        if (depth > kMaxDepth)
+        {
+            message_ = "nesting too deep";
+            return false;
+        }
+        if (pos_ >= text_.size())
+        {
+            return expected("a value");
+        }
+        switch (text_[pos_])
+        {
+        case '{':
+            return parseObject(out, depth);
+        case '[':
+            return parseArray(out, depth);
+        case '"':
+            out.kind_ = JsonValue::Kind::String;
+            return parseString(out.text_);
+        case 't':
+            out.kind_ = JsonValue::Kind::Bool;
+            out.bool_ = true;
+            return consumeLiteral("true");
+        case 'f':
+            out.kind_ = JsonValue::Kind::Bool;
+            out.bool_ = false;
+            return consumeLiteral("false");
+        case 'n':
+            out.kind_ = JsonValue::Kind::Null;
+            return consumeLiteral("null");
+        default:
+            out.kind_ = JsonValue::Kind::Number;
+            return parseNumber(out.text_);
+        }
+    }
+
+    bool parseObject(JsonValue &out, int depth)
+    {
+        out.kind_ = JsonValue::Kind::Object;
+        ++pos_; // '{'
+        skipWhitespace();
+        if (pos_ < text_.size() && text_[pos_] == '}')
+        {
+            ++pos_;
+            return true;
+        }
+        while (true)
+        {
+            skipWhitespace();
+            if (pos_ >= text_.size() || text_[pos_] != '"')
+            {
+                return expected("a member name");
+            }
+            std::string key;
+            if (!parseString(key))
+            {
+                return false;
+            }
+            skipWhitespace();
+            if (pos_ >= text_.size() || text_[pos_] != ':')
+            {
+                return expected("':'");
+            }
+            ++pos_;
+            skipWhitespace();
+            JsonValue value;
+            if (!parseValue(value, depth + 1))
+            {
+                return false;
+            }
+            out.keys_.push_back(std::move(key));
+            out.items_.push_back(std::move(value));
+            skipWhitespace();
+            if (pos_ < text_.size() && text_[pos_] == ',')
+            {
+                ++pos_;
+                continue;
+            }
+            if (pos_ < text_.size() && text_[pos_] == '}')
+            {
+                ++pos_;
+                return true;
+            }
+            return expected("',' or '}'");
+        }
+    }
+
+    bool parseArray(JsonValue &out, int depth)
+    {
+        out.kind_ = JsonValue::Kind::Array;
+        ++pos_; // '['
+        skipWhitespace();
+        if (pos_ < text_.size() && text_[pos_] == ']')
+        {
+            ++pos_;
+            return true;
+        }
+        while (true)
+        {
+            skipWhitespace();
+            JsonValue value;
+            if (!parseValue(value, depth + 1))
+            {
+                return false;
+            }
+            out.items_.push_back(std::move(value));
+            skipWhitespace();
+            if (pos_ < text_.size() && text_[pos_] == ',')
+            {
+                ++pos_;
+                continue;
+            }
+            if (pos_ < text_.size() && text_[pos_] == ']')
+            {
+                ++pos_;
+                return true;
+            }
+            return expected("',' or ']'");
+        }
+    }
+
+    bool parseNumber(std::string &out)
+    {
+        const std::size_t start = pos_;
+        auto digits = [&]() {
+            const std::size_t first = pos_;
+            while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9')
+            {
+                ++pos_;
+            }
+            return pos_ > first;
+        };
+
+        if (pos_ < text_.size() && text_[pos_] == '-')
+        {
+            ++pos_;
+        }
+        if (pos_ < text_.size() && text_[pos_] == '0')
+        {
+            ++pos_;
+        }
+        else if (!digits())
+        {
+            pos_ = start;
+            return expected("a value");
+        }
+        if (pos_ < text_.size() && text_[pos_] == '.')
+        {
+            ++pos_;
+            if (!digits())
+            {
+                return expected("digits after '.'");
+            }
+        }
+        if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E'))
+        {
+            ++pos_;
+            if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-'))
+            {
+                ++pos_;
+            }
+            if (!digits())
+            {
+                return expected("exponent digits");
+            }
+        }
+        out.assign(text_, start, pos_ - start);
+        return true;
+    }
+
+    bool parseHex4(uint32_t &out)
+    {
+        if (pos_ + 4 > text_.size())
+        {
+            return expected("four hex digits");
+        }
+        out = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const char c = text_[pos_++];
+            out <<= 4;
+            if (c >= '0' && c <= '9')
+            {
+                out |= static_cast<uint32_t>(c - '0');
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                out |= static_cast<uint32_t>(c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                out |= static_cast<uint32_t>(c - 'A' + 10);
+            }
+            else
+            {
+                return expected("four hex digits");
+            }
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string &out, uint32_t cp)
+    {
+        if (cp < 0x80)
+        {
+            out.push_back(static_cast<char>(cp));
+        }
+        else if (cp < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else if (cp < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    bool parseString(std::string &out)
+    {
+        ++pos_; // opening quote
+        while (pos_ < text_.size())
+        {
+            const char c = text_[pos_++];
+            if (c == '"')
+            {
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                message_ = "control character in string";
+                return false;
+            }
+            if (c != '\\')
+            {
+                out.push_back(c);
+                continue;
+            }
+            if (pos_ >= text_.size())
+            {
+                break;
+            }
+            const char esc = text_[pos_++];
+            switch (esc)
+            {
+            case '"':
+            case '\\':
+            case '/':
+                out.push_back(esc);
+                break;
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            case 'u':
+            {
+                uint32_t cp = 0;
+                if (!parseHex4(cp))
+                {
+                    return false;
+                }
+                if (cp >= 0xD800 && cp <= 0xDBFF)
+                {
+                    uint32_t low = 0;
+                    if (text_.compare(pos_, 2, "\\u") != 0)
+                    {
+                        return expected("low surrogate");
+                    }
+                    pos_ += 2;
+                    if (!parseHex4(low) || low < 0xDC00 || low > 0xDFFF)
+                    {
+                        return expected("low surrogate");
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                else if (cp >= 0xDC00 && cp <= 0xDFFF)
+                {
+                    message_ = "unpaired low surrogate";
+                    return false;
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default:
+                message_ = "invalid escape";
+                return false;
+            }
+        }
+        message_ = "unterminated string";
+        return false;
+    }
+
+    const std::string &text_;
+    std::size_t pos_{0};
+    std::string message_;
+};
+
+std::optional<JsonValue> JsonValue::parse(const std::string &text, std::string *error)
+{
+    return JsonParser(text).parseDocument(error);
+}
+
+double JsonValue::asNumber() const
+{
+    return kind_ == Kind::Number ? std::strtod(text_.c_str(), nullptr) : 0.0;
+}
+
+const JsonValue *JsonValue::find(const std::string &key) const
+{
+    if (kind_ != Kind::Object)
+    {
+        return nullptr;
+    }
+    for (std::size_t i = 0; i < keys_.size(); ++i)
+    {
+        if (keys_[i] == key)
+        {
+            return &items_[i];
+        }
+    }
+    return nullptr;
+}
+
+std::optional<std::string> JsonValue::scalarText() const
+{
+    switch (kind_)
+    {
+    case Kind::String:
+    case Kind::Number:
+        return text_;
+    case Kind::Bool:
+        return std::string(bool_ ? "true" : "false");
+    default:
+        return std::nullopt;
+    }
+}
+
+std::string jsonEscape(const std::string &text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out.push_back('\\');
+            out.push_back(c);
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(c)));
+            out += escaped;
+        }
+        else
+        {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+} // namespace trdp
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace trdp
+{
+
+/**
+ * Parsed JSON document. Numbers keep their literal text so 64-bit integers and exact decimals
+ * reach assignValue() unchanged; object members keep their document order.
+ */
+class JsonValue
+{
+public:
+    enum class Kind
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    /**
+     * Parse a complete document. Returns std::nullopt on malformed input, trailing garbage or
+     * nesting deeper than 64 levels; error (if given) then holds a message with the byte offset.
+     */
+    static std::optional<JsonValue> parse(const std::string &text, std::string *error = nullptr);
+
+    Kind kind() const { return kind_; }
+    bool isNull() const { return kind_ == Kind::Null; }
+    bool isBool() const { return kind_ == Kind::Bool; }
+    bool isNumber() const { return kind_ == Kind::Number; }
+    bool isString() const { return kind_ == Kind::String; }
+    bool isArray() const { return kind_ == Kind::Array; }
+    bool isObject() const { return kind_ == Kind::Object; }
+
+    bool asBool() const { return bool_; }
+    double asNumber() const;
+    /** String contents, or the literal text of a number. */
+    const std::string &text() const { return text_; }
+
+    /** Array elements or object member values. */
+    const std::vector<JsonValue> &items() const { return items_; }
+    /** Object member names, parallel to items(). */
+    const std::vector<std::string> &keys() const { return keys_; }
+
+    /** First member with this name, or nullptr if absent or this is not an object. */
+    const JsonValue *find(const std::string &key) const;
+
+    /** Strings, numbers and booleans as the text a value setter expects; std::nullopt otherwise. */
+    std::optional<std::string> scalarText() const;
+
+private:
+    friend class JsonParser;
+
+    Kind kind_{Kind::Null};
+    bool bool_{false};
+    std::string text_;
+    std::vector<std::string> keys_;
+    std::vector<JsonValue> items_;
+};
+
+/** Escape text for use inside a JSON string literal (quotes not included). */
+std::string jsonEscape(const std::string &text);
+
+} // namespace trdp
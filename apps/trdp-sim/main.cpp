@@ -1,27 +1,38 @@
+#include "http_server.hpp"
+#include "json.hpp"
+#include "pd_replay.hpp"
+#include "pd_tap.hpp"
+#include "prometheus.hpp"
+#include "render.hpp"
+#include "value_stream.hpp"
+
 #include "trdp/config.hpp"
+#include "trdp/config_cache.hpp"
+#include "trdp/config_reload.hpp"
+#include "trdp/flight_recorder.hpp"
 #include "trdp/logging.hpp"
 #include "trdp/md.hpp"
+#include "trdp/metrics.hpp"
+#include "trdp/packet_capture.hpp"
 #include "trdp/pd.hpp"
 #include "trdp/session.hpp"
 #include "trdp/tau.hpp"
 
-#include <arpa/inet.h>
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <csignal>
+#include <cstdint>
 #include <cstring>
 #include <cstdlib>
-#include <iomanip>
+#include <ctime>
 #include <iostream>
 #include <map>
 #include <mutex>
-#include <netinet/in.h>
-#include <regex>
 #include <sstream>
 #include <string>
 #include <thread>
-#include <sys/select.h>
-#include <sys/socket.h>
-#include <unistd.h>
 
 using namespace trdp;
 
@@ -29,353 +40,706 @@ namespace
 {
 std::atomic_bool running{true};
 std::mutex engineMutex;
+std::atomic_bool flightDumpRequested{false}; // set by SIGUSR1
 
-std::string toHex(const std::vector<uint8_t> &data)
+/** Request bodies are optional for some routes, so a blank body reads as an empty object. */
+std::optional<JsonValue> parseBody(const std::string &body, std::string &parseError)
 {
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-    for (const auto byte : data)
+    if (body.find_first_not_of(" \t\r\n") == std::string::npos)
     {
-        oss << std::setw(2) << static_cast<int>(byte);
+        return JsonValue::parse("{}");
     }
-    return oss.str();
+    return JsonValue::parse(body, &parseError);
+}
+
+std::optional<std::string> jsonString(const JsonValue &doc, const std::string &key)
+{
+    const JsonValue *member = doc.find(key);
+    return member ? member->scalarText() : std::nullopt;
 }
 
-std::string urlDecode(const std::string &value)
+std::vector<std::string> splitList(const std::string &text)
 {
-    std::string result;
-    for (std::size_t i = 0; i < value.size(); ++i)
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ','))
     {
-        if (value[i] == '%' && i + 2 < value.size())
-        {
-            const std::string hex = value.substr(i + 1, 2);
-            char decoded = static_cast<char>(std::strtol(hex.c_str(), nullptr, 16));
-            result.push_back(decoded);
-            i += 2;
-        }
-        else if (value[i] == '+')
+        if (!item.empty())
         {
-            result.push_back(' ');
-        }
-        else
-        {
-            result.push_back(value[i]);
+            items.push_back(item);
         }
     }
-    return result;
+    return items;
 }
 
-std::string renderValuesJson(const ElementValues &values)
+bool parseNumberList(const std::string &text, uint64_t max, std::vector<uint64_t> &out)
 {
-    std::ostringstream oss;
-    oss << "[";
-    for (std::size_t i = 0; i < values.size(); ++i)
+    for (const auto &item : splitList(text))
     {
-        const auto &val = values[i];
-        if (i > 0)
+        if (item.size() > 10 || item.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+        const auto value = std::stoull(item);
+        if (value > max)
         {
-            oss << ",";
+            return false;
         }
-        oss << "{\"name\":\"" << val.element.name << "\",";
-        oss << "\"type\":\"" << toString(val.element.type) << "\",";
-        oss << "\"size\":" << val.rawValue.size() << ",";
-        oss << "\"locked\":" << (val.locked ? "true" : "false") << ",";
-        oss << "\"bytes\":\"" << toHex(val.rawValue) << "\"}";
+        out.push_back(value);
     }
-    oss << "]";
-    return oss.str();
+    return true;
 }
 
-std::string renderPublishJson(const PdEngine &pd)
+/**
+ * Read comId, datasetId, destination, fields, cursor and limit. A field of the form
+ * values.<member> keeps "values" but only that member of each element.
+ */
+bool parseListQuery(const HttpRequest &req, ListQuery &query, std::string &problem)
 {
-    std::ostringstream oss;
-    oss << "{\"publish\":[";
-    const auto &publish = pd.publishTelegrams();
-    for (std::size_t i = 0; i < publish.size(); ++i)
+    std::vector<uint64_t> numbers;
+    if (!parseNumberList(req.queryParam("comId").value_or(""), UINT32_MAX, numbers))
     {
-        const auto &pub = publish[i];
-        if (i > 0)
+        problem = "comId must be a list of numbers";
+        return false;
+    }
+    query.comIds.assign(numbers.begin(), numbers.end());
+    numbers.clear();
+    if (!parseNumberList(req.queryParam("datasetId").value_or(""), UINT16_MAX, numbers))
+    {
+        problem = "datasetId must be a list of numbers";
+        return false;
+    }
+    query.datasetIds.assign(numbers.begin(), numbers.end());
+    query.destinations = splitList(req.queryParam("destination").value_or(""));
+
+    for (const auto &field : splitList(req.queryParam("fields").value_or("")))
+    {
+        const std::string prefix = "values.";
+        const bool valueField = field.compare(0, prefix.size(), prefix) == 0;
+        const std::string top = valueField ? "values" : field;
+        if (std::find(query.fields.begin(), query.fields.end(), top) == query.fields.end())
         {
-            oss << ",";
+            query.fields.push_back(top);
+        }
+        if (valueField)
+        {
+            query.valueFields.push_back(field.substr(prefix.size()));
         }
-        oss << "{\"index\":" << i << ",\"comId\":" << pub.comId << ",\"datasetId\":" << pub.datasetId << ",";
-        oss << "\"destination\":\"" << pub.destinationIp << "\",\"cycleTimeMs\":" << pub.cycleTimeMs << ",";
-        oss << "\"values\":" << renderValuesJson(pub.values) << "}";
     }
-    oss << "]}";
-    return oss.str();
-}
 
-std::string renderMdJson(const MdEngine &md)
-{
-    std::ostringstream oss;
-    oss << "{\"templates\":[";
-    const auto &templates = md.templates();
-    for (std::size_t i = 0; i < templates.size(); ++i)
+    for (const auto &param : {std::make_pair("cursor", &query.cursor), std::make_pair("limit", &query.limit)})
     {
-        const auto &tpl = templates[i];
-        if (i > 0)
+        numbers.clear();
+        const auto text = req.queryParam(param.first);
+        if (text && (!parseNumberList(*text, UINT32_MAX, numbers) || numbers.size() != 1))
+        {
+            problem = std::string(param.first) + " must be a number";
+            return false;
+        }
+        if (text)
         {
-            oss << ",";
+            *param.second = static_cast<std::size_t>(numbers.front());
         }
-        oss << "{\"name\":\"" << tpl.name << "\",\"comId\":" << tpl.comId << ",\"datasetId\":"
-            << tpl.datasetId << ",";
-        oss << "\"destination\":\"" << tpl.destinationIp << ":" << tpl.destinationPort << "\",";
-        oss << "\"direction\":" << static_cast<int>(tpl.direction) << ",";
-        oss << "\"values\":" << renderValuesJson(tpl.values) << "}";
     }
-    oss << "]}";
-    return oss.str();
+    return true;
 }
 
-std::optional<std::string> parseJsonString(const std::string &body, const std::string &key)
+/** ETag of one query's view of a list: the list's ETag plus a hash of the query string. */
+std::string queryEtag(const std::string &listEtag, const std::string &query)
 {
-    std::regex re("\"" + key + "\"\\s*:\\s*\"([^\"]*)\"");
-    std::smatch match;
-    if (std::regex_search(body, match, re) && match.size() > 1)
+    const auto hash = hashBytes(query.data(), query.size());
+    uint8_t bytes[sizeof(hash)];
+    std::memcpy(bytes, &hash, sizeof(hash));
+    std::string etag = listEtag.substr(0, listEtag.size() - 1) + "-q";
+    appendHex(etag, bytes, sizeof(bytes));
+    return etag + "\"";
+}
+
+/** Absolute, symlink-free form of an existing path; empty if it cannot be resolved. */
+std::string canonicalPath(const std::string &path)
+{
+    char *resolved = realpath(path.c_str(), nullptr);
+    if (resolved == nullptr)
     {
-        return match[1].str();
+        return {};
     }
-    return std::nullopt;
+    std::string result(resolved);
+    std::free(resolved);
+    return result;
+}
+
+std::string parentDirectory(const std::string &path)
+{
+    const auto slash = path.rfind('/');
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash == 0 ? 1 : slash);
 }
 
-std::optional<bool> parseJsonBool(const std::string &body, const std::string &key)
+std::optional<bool> jsonBool(const JsonValue &doc, const std::string &key)
 {
-    std::regex re("\"" + key + "\"\\s*:\\s*(true|false)");
-    std::smatch match;
-    if (std::regex_search(body, match, re) && match.size() > 1)
+    const JsonValue *member = doc.find(key);
+    if (member && member->isBool())
     {
-        return match[1].str() == "true";
+        return member->asBool();
     }
     return std::nullopt;
 }
 
-struct HttpRequest
-{
-    std::string method;
-    std::string path;
-    std::string body;
-};
-
 class SimpleHttpServer
 {
 public:
-    SimpleHttpServer(PdEngine &pd, MdEngine &md, TrdpConfig &config, std::atomic_bool &running)
-        : pd_(pd), md_(md), config_(config), running_(running)
+    SimpleHttpServer(PdEngine &pd,
+                     MdEngine &md,
+                     TrdpConfig &config,
+                     ConfigReloader &reloader,
+                     const TrdpSession &session,
+                     std::shared_ptr<const FlightRecorder> recorder,
+                     std::atomic_bool &running)
+        : pd_(pd), md_(md), config_(config), reloader_(reloader), session_(session), recorder_(std::move(recorder)),
+          running_(running), reloadDirectory_(parentDirectory(canonicalPath(reloader.deviceFile()))),
+          streams_(config, engineMutex), server_([this](const HttpRequest &req) { return timed(req); })
     {
     }
 
     bool start(uint16_t port)
     {
-        port_ = port;
-        serverThread_ = std::thread([this]() { this->serve(); });
-        return true;
+        streams_.start();
+        return server_.start(port);
     }
 
     void stop()
     {
         running_.store(false);
-        if (serverThread_.joinable())
-        {
-            serverThread_.join();
-        }
+        server_.stop();
+        streams_.stop();
     }
 
 private:
-    void serve()
+    HttpResponse respond(int status,
+                         const std::string &statusText,
+                         const std::string &body,
+                         const std::string &contentType = "application/json") const
+    {
+        HttpResponse response;
+        response.status = status;
+        response.statusText = statusText;
+        response.contentType = contentType;
+        response.body = body;
+        return response;
+    }
+
+    HttpResponse invalidJson(const std::string &parseError) const
     {
-        int listenFd = socket(AF_INET, SOCK_STREAM, 0);
-        if (listenFd < 0)
+        return respond(400, "Bad Request", "{\"error\":\"Invalid JSON: " + jsonEscape(parseError) + "\"}\n");
+    }
+
+    /**
+     * 304 if the client already holds etag, otherwise 200 with the rendered body. Either way
+     * the ETag is sent so the next poll can be conditional.
+     */
+    template <typename BodyFn>
+    HttpResponse conditional(const HttpRequest &req,
+                             const std::string &etag,
+                             BodyFn body,
+                             const std::string &contentType = "application/json") const
+    {
+        HttpResponse response = etagMatches(req.header("If-None-Match"), etag)
+                                    ? respond(304, "Not Modified", "")
+                                    : respond(200, "OK", body(), contentType);
+        response.headers.emplace_back("ETag", etag);
+        return response;
+    }
+
+    /** A list endpoint: the cached full document, or a filtered page when there is a query. */
+    template <typename EtagFn, typename FullFn, typename PageFn>
+    HttpResponse listRoute(const HttpRequest &req, EtagFn etag, FullFn full, PageFn page)
+    {
+        if (req.query.empty())
         {
-            error("Failed to create HTTP socket");
-            return;
+            std::lock_guard<std::mutex> lock(engineMutex);
+            return conditional(req, etag(), full);
         }
+        ListQuery query;
+        std::string problem;
+        if (!parseListQuery(req, query, problem))
+        {
+            return respond(400, "Bad Request", "{\"error\":\"" + jsonEscape(problem) + "\"}\n");
+        }
+        std::lock_guard<std::mutex> lock(engineMutex);
+        return conditional(req, queryEtag(etag(), req.query), [&]() { return page(query); });
+    }
+
+    /**
+     * PUT bodies for the raw payload routes must be unlabelled or application/octet-stream, so a
+     * JSON or hex body sent by mistake is not taken as payload bytes.
+     */
+    bool isOctetStream(const HttpRequest &req) const
+    {
+        const auto type = req.header("Content-Type");
+        return type.empty() || type.compare(0, 24, "application/octet-stream") == 0;
+    }
 
-        int opt = 1;
-        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    HttpResponse rawSizeMismatch(std::size_t expected, std::size_t received) const
+    {
+        return respond(400, "Bad Request",
+                       "{\"error\":\"Payload size mismatch\",\"expected\":" + std::to_string(expected) +
+                           ",\"received\":" + std::to_string(received) + "}\n");
+    }
 
-        sockaddr_in addr{};
-        addr.sin_family = AF_INET;
-        addr.sin_addr.s_addr = htonl(INADDR_ANY);
-        addr.sin_port = htons(port_);
+    /** handle() plus request latency and status class counts for /metrics. */
+    HttpResponse timed(const HttpRequest &req)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        HttpResponse response = handle(req);
+        requestLatency_.observe(std::chrono::steady_clock::now() - start);
+        const auto statusClass = static_cast<std::size_t>(response.status / 100);
+        requestsByClass_[statusClass < requestsByClass_.size() ? statusClass : 0].add();
+        return response;
+    }
 
-        if (bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+    HttpResponse handle(const HttpRequest &req)
+    {
+        if (req.path == "/" && req.method == "GET")
         {
-            error("Failed to bind HTTP server socket");
-            close(listenFd);
-            return;
+            const std::string body =
+                "<html><body><h1>TRDP Simulator HTTP</h1><p>Use the JSON API under /api to list PD publish telegrams, MD "
+                "templates, and mutate element values.\n";
+            const std::string links =
+                "<ul><li>GET /api/pd/publish</li><li>GET /api/md/templates</li><li>POST /api/pd/publish/{index}/value</li>"
+                "<li>POST /api/md/templates/{name}/value</li><li>POST /api/pd/publish/{index}/lock</li>"
+                "<li>POST /api/md/templates/{name}/lock</li><li>GET /api/pd/publish/{index}/payload</li>"
+                "<li>GET /api/md/templates/{name}/payload</li><li>GET|PUT /api/pd/publish/{index}/raw</li>"
+                "<li>GET|PUT /api/md/templates/{name}/raw</li><li>POST /api/batch</li><li>GET /api/stream</li>"
+                "<li>GET|POST /api/reload</li><li>GET /api/stats</li><li>GET /api/flight-recorder</li>"
+                "<li>GET /metrics</li></ul>"
+                "</body></html>";
+            return respond(200, "OK", body + links, "text/html");
         }
 
-        if (listen(listenFd, 5) < 0)
+        if (req.path == "/api/pd/publish" && req.method == "GET")
         {
-            error("Failed to listen on HTTP server socket");
-            close(listenFd);
-            return;
+            return listRoute(
+                req, [&]() { return renderCache_.publishEtag(pd_); }, [&]() { return renderCache_.publishJson(pd_); },
+                [&](const ListQuery &query) { return renderCache_.publishJson(pd_, query); });
         }
 
-        info("HTTP server listening on port " + std::to_string(port_));
+        if (req.path == "/api/md/templates" && req.method == "GET")
+        {
+            return listRoute(
+                req, [&]() { return renderCache_.mdEtag(md_); }, [&]() { return renderCache_.mdJson(md_); },
+                [&](const ListQuery &query) { return renderCache_.mdJson(md_, query); });
+        }
 
-        while (running_.load())
+        if (req.path == "/api/stats" && req.method == "GET")
         {
-            fd_set readSet;
-            FD_ZERO(&readSet);
-            FD_SET(listenFd, &readSet);
-            timeval timeout{1, 0};
-            const int ready = select(listenFd + 1, &readSet, nullptr, nullptr, &timeout);
-            if (ready <= 0)
-            {
-                continue;
-            }
+            std::lock_guard<std::mutex> lock(engineMutex);
+            return respond(200, "OK", renderStatsJson(pd_, md_, std::chrono::steady_clock::now()));
+        }
 
-            sockaddr_in clientAddr{};
-            socklen_t clientLen = sizeof(clientAddr);
-            int clientFd = accept(listenFd, reinterpret_cast<sockaddr *>(&clientAddr), &clientLen);
-            if (clientFd < 0)
+        if (req.path == "/api/flight-recorder" && req.method == "GET")
+        {
+            if (!recorder_)
             {
-                continue;
+                return respond(404, "Not Found", "{\"error\":\"Flight recorder disabled\"}\n");
             }
+            return respond(200, "OK", recorder_->dump(), "application/octet-stream");
+        }
+
+        if (req.path == "/api/reload")
+        {
+            return handleReload(req);
+        }
+
+        if (req.path == "/metrics" && req.method == "GET")
+        {
+            return handleMetrics();
+        }
+
+        if (req.path == "/api/batch" && req.method == "POST")
+        {
+            return handleBatch(req);
+        }
 
-            handleClient(clientFd);
-            close(clientFd);
+        if (req.path == "/api/stream" && req.method == "GET")
+        {
+            return handleStream(req);
         }
 
-        close(listenFd);
+        const auto parts = splitPath(req.path);
+        if (parts.size() >= 4 && parts[0] == "api" && parts[1] == "pd" && parts[2] == "publish")
+        {
+            return handlePdRoute(parts, req);
+        }
+        if (parts.size() >= 4 && parts[0] == "api" && parts[1] == "md" && parts[2] == "templates")
+        {
+            return handleMdRoute(parts, req);
+        }
+
+        return respond(404, "Not Found", "{}\n");
     }
 
-    bool readRequest(int clientFd, HttpRequest &out) const
+    HttpResponse handleReload(const HttpRequest &req)
     {
-        std::string buffer;
-        buffer.reserve(4096);
-        char temp[1024];
-        ssize_t received = 0;
-        std::size_t headerEnd = std::string::npos;
-
-        while (headerEnd == std::string::npos)
+        if (req.method == "POST")
         {
-            received = recv(clientFd, temp, sizeof(temp), 0);
-            if (received <= 0)
+            std::string parseError;
+            const auto doc = parseBody(req.body, parseError);
+            if (!doc)
+            {
+                return invalidJson(parseError);
+            }
+            // The server listens on every interface, so a client may only name a file next to the
+            // device file given at startup; the CLI reload command takes any path.
+            std::string file;
+            if (const auto path = jsonString(*doc, "path"))
             {
-                return false;
+                file = canonicalPath(path->empty() || path->front() == '/' ? *path : reloadDirectory_ + "/" + *path);
+                if (file.empty() || parentDirectory(file) != reloadDirectory_)
+                {
+                    return respond(403, "Forbidden",
+                                   "{\"error\":\"Only files in the device file's directory can be reloaded\"}\n");
+                }
             }
-            buffer.append(temp, static_cast<std::size_t>(received));
-            headerEnd = buffer.find("\r\n\r\n");
-            if (buffer.size() > 16384)
+            if (!reloader_.request(file))
             {
-                return false;
+                return respond(409, "Conflict", "{\"error\":\"Reload already in progress\"}\n");
             }
+            return respond(202, "Accepted", "{\"reloading\":true}\n");
         }
-
-        const std::size_t bodyStart = headerEnd + 4;
-        std::size_t contentLength = 0;
-        std::istringstream headers(buffer.substr(0, headerEnd));
-        std::string requestLine;
-        std::getline(headers, requestLine);
-        if (requestLine.back() == '\r')
+        if (req.method == "GET")
         {
-            requestLine.pop_back();
+            return respond(200, "OK",
+                         "{\"file\":\"" + jsonEscape(reloader_.deviceFile()) + "\",\"pending\":" +
+                             (reloader_.busy() ? "true" : "false") + ",\"last\":\"" +
+                             jsonEscape(reloader_.lastResult()) + "\"}\n");
         }
-        std::istringstream requestLineStream(requestLine);
-        requestLineStream >> out.method >> out.path;
+        return respond(404, "Not Found", "{}\n");
+    }
 
-        std::string headerLine;
-        while (std::getline(headers, headerLine))
+    /**
+     * Prometheus scrape. Hot paths only bump per-thread slots or, for per-telegram counts,
+     * plain fields under the engine lock they already hold; everything is summed here.
+     */
+    HttpResponse handleMetrics()
+    {
+        PrometheusWriter page;
         {
-            if (!headerLine.empty() && headerLine.back() == '\r')
+            std::lock_guard<std::mutex> lock(engineMutex);
+            const auto &publish = pd_.publishTelegrams();
+            const auto &subscribe = pd_.subscribeTelegrams();
+            const auto &templates = md_.templates();
+            const auto &publishStats = pd_.publishStats();
+            const auto &subscribeStats = pd_.subscribeStats();
+            const auto &templateStats = md_.templateStats();
+            const auto pdLabels = [](const char *kind, std::size_t index, uint32_t comId) {
+                return MetricLabels{{"kind", kind}, {"telegram", std::to_string(index)}, {"comId", std::to_string(comId)}};
+            };
+            const auto mdLabels = [](const MdTemplate &tpl) {
+                return MetricLabels{{"kind", "md"}, {"telegram", tpl.name}, {"comId", std::to_string(tpl.comId)}};
+            };
+
+            page.family("trdp_telegram_sent_total", "counter", "Telegrams handed to the transport.");
+            for (std::size_t i = 0; i < publish.size(); ++i)
+            {
+                page.sample("trdp_telegram_sent_total", pdLabels("pd_publish", i, publish[i].comId),
+                            publishStats[i].sent);
+            }
+            for (std::size_t i = 0; i < templates.size(); ++i)
+            {
+                page.sample("trdp_telegram_sent_total", mdLabels(templates[i]), templateStats[i].sent);
+            }
+            page.family("trdp_telegram_received_total", "counter", "Telegrams received and applied.");
+            for (std::size_t i = 0; i < subscribe.size(); ++i)
+            {
+                page.sample("trdp_telegram_received_total", pdLabels("pd_subscribe", i, subscribe[i].comId),
+                            subscribeStats[i].received);
+            }
+            for (std::size_t i = 0; i < templates.size(); ++i)
+            {
+                page.sample("trdp_telegram_received_total", mdLabels(templates[i]), templateStats[i].received);
+            }
+            page.family("trdp_telegram_timeouts_total", "counter", "Subscriptions that went silent for their timeout.");
+            for (std::size_t i = 0; i < subscribe.size(); ++i)
+            {
+                page.sample("trdp_telegram_timeouts_total", pdLabels("pd_subscribe", i, subscribe[i].comId),
+                            subscribeStats[i].timeouts);
+            }
+            page.family("trdp_telegram_timed_out", "gauge", "1 while a subscription is in timeout.");
+            for (std::size_t i = 0; i < subscribe.size(); ++i)
             {
-                headerLine.pop_back();
+                page.sample("trdp_telegram_timed_out", pdLabels("pd_subscribe", i, subscribe[i].comId),
+                            subscribeStats[i].timedOut ? 1 : 0);
             }
-            const auto pos = headerLine.find(":");
-            if (pos == std::string::npos)
+            page.family("trdp_telegram_marshall_failures_total", "counter", "Failed tau_marshall or tau_unmarshall calls.");
+            for (std::size_t i = 0; i < publish.size(); ++i)
             {
-                continue;
+                page.sample("trdp_telegram_marshall_failures_total", pdLabels("pd_publish", i, publish[i].comId),
+                            publishStats[i].marshallFailures);
             }
-            const std::string key = headerLine.substr(0, pos);
-            const std::string value = headerLine.substr(pos + 1);
-            if (key == "Content-Length")
+            for (std::size_t i = 0; i < subscribe.size(); ++i)
             {
-                contentLength = static_cast<std::size_t>(std::stoul(value));
+                page.sample("trdp_telegram_marshall_failures_total", pdLabels("pd_subscribe", i, subscribe[i].comId),
+                            subscribeStats[i].marshallFailures);
             }
+            for (std::size_t i = 0; i < templates.size(); ++i)
+            {
+                page.sample("trdp_telegram_marshall_failures_total", mdLabels(templates[i]),
+                            templateStats[i].marshallFailures);
+            }
+            page.family("trdp_telegram_send_jitter_seconds", "histogram",
+                        "Deviation of each send period from the telegram's cycle time.");
+            for (std::size_t i = 0; i < publish.size(); ++i)
+            {
+                page.histogram("trdp_telegram_send_jitter_seconds", pdLabels("pd_publish", i, publish[i].comId),
+                               publishStats[i].sendJitter.snapshot());
+            }
+            page.family("trdp_telegram_inter_arrival_seconds", "histogram", "Time between two receptions.");
+            for (std::size_t i = 0; i < subscribe.size(); ++i)
+            {
+                page.histogram("trdp_telegram_inter_arrival_seconds", pdLabels("pd_subscribe", i, subscribe[i].comId),
+                               subscribeStats[i].interArrival.snapshot());
+            }
+            for (std::size_t i = 0; i < templates.size(); ++i)
+            {
+                page.histogram("trdp_telegram_inter_arrival_seconds", mdLabels(templates[i]),
+                               templateStats[i].interArrival.snapshot());
+            }
+            page.family("trdp_config_revision", "gauge", "Value changes applied since start.");
+            page.sample("trdp_config_revision", {}, config_.revision);
+        }
+
+        page.family("trdp_cycle_lateness_seconds", "histogram", "Delay of each process cycle behind its schedule.");
+        page.histogram("trdp_cycle_lateness_seconds", {}, session_.cycleLateness().snapshot());
+        page.family("trdp_cycle_overruns_total", "counter", "Cycles that started after their slot had passed.");
+        page.sample("trdp_cycle_overruns_total", {}, session_.cycleOverruns().value());
+
+        page.family("trdp_http_request_duration_seconds", "histogram", "Time to handle an HTTP request.");
+        page.histogram("trdp_http_request_duration_seconds", {}, requestLatency_.snapshot());
+        page.family("trdp_http_requests_total", "counter", "HTTP requests by status class.");
+        for (std::size_t i = 1; i < requestsByClass_.size(); ++i)
+        {
+            page.sample("trdp_http_requests_total", {{"code", std::to_string(i) + "xx"}}, requestsByClass_[i].value());
         }
+        page.family("trdp_stream_clients", "gauge", "Connected /api/stream clients.");
+        page.sample("trdp_stream_clients", {}, streams_.clientCount());
 
-        while (buffer.size() - bodyStart < contentLength)
+        page.family("trdp_log_messages_total", "counter", "Messages reaching a rate-limited log site.");
+        const auto sites = logSiteStats();
+        for (const auto &site : sites)
         {
-            received = recv(clientFd, temp, sizeof(temp), 0);
-            if (received <= 0)
+            uint64_t occurrences = 0;
+            for (const auto &message : site.messages)
             {
-                break;
+                occurrences += message.occurrences;
             }
-            buffer.append(temp, static_cast<std::size_t>(received));
+            page.sample("trdp_log_messages_total", {{"site", site.site}}, occurrences);
+        }
+        page.family("trdp_log_suppressed_total", "counter", "Repeats held back by a rate-limited log site.");
+        for (const auto &site : sites)
+        {
+            uint64_t suppressed = 0;
+            for (const auto &message : site.messages)
+            {
+                suppressed += message.suppressed;
+            }
+            page.sample("trdp_log_suppressed_total", {{"site", site.site}}, suppressed);
         }
 
-        out.body = buffer.substr(bodyStart, contentLength);
-        return true;
-    }
-
-    void sendResponse(int clientFd,
-                      int status,
-                      const std::string &statusText,
-                      const std::string &body,
-                      const std::string &contentType = "application/json") const
-    {
-        std::ostringstream oss;
-        oss << "HTTP/1.1 " << status << " " << statusText << "\r\n";
-        oss << "Content-Type: " << contentType << "\r\n";
-        oss << "Content-Length: " << body.size() << "\r\n";
-        oss << "Connection: close\r\n\r\n";
-        oss << body;
-        const auto response = oss.str();
-        send(clientFd, response.c_str(), response.size(), 0);
+        uint64_t resident = 0;
+        uint64_t virtualSize = 0;
+        if (readProcessMemory(resident, virtualSize))
+        {
+            page.family("process_resident_memory_bytes", "gauge", "Resident memory size in bytes.");
+            page.sample("process_resident_memory_bytes", {}, resident);
+            page.family("process_virtual_memory_bytes", "gauge", "Virtual memory size in bytes.");
+            page.sample("process_virtual_memory_bytes", {}, virtualSize);
+        }
+        return respond(200, "OK", page.text(), "text/plain; version=0.0.4");
     }
 
-    void handleClient(int clientFd)
+    /**
+     * Apply many element updates, across any number of PD publish telegrams and MD templates,
+     * as one step. Every telegram is staged on a copy first; only if all of them accept their
+     * updates are the copies swapped in, all under one engine lock, so the session never sends
+     * a half-applied batch.
+     */
+    HttpResponse handleBatch(const HttpRequest &req)
     {
-        HttpRequest req;
-        if (!readRequest(clientFd, req))
+        std::string parseError;
+        const auto doc = parseBody(req.body, parseError);
+        if (!doc)
+        {
+            return invalidJson(parseError);
+        }
+        const JsonValue *updates = doc->find("updates");
+        if (!updates || !updates->isArray())
         {
-            return;
+            return respond(400, "Bad Request", "{\"error\":\"Missing updates array\"}\n");
         }
 
-        if (req.path == "/" && req.method == "GET")
+        struct Target
         {
-            const std::string body =
-                "<html><body><h1>TRDP Simulator HTTP</h1><p>Use the JSON API under /api to list PD publish telegrams, MD "
-                "templates, and mutate element values.\n";
-            const std::string links =
-                "<ul><li>GET /api/pd/publish</li><li>GET /api/md/templates</li><li>POST /api/pd/publish/{index}/value</li>"
-                "<li>POST /api/md/templates/{name}/value</li><li>POST /api/pd/publish/{index}/lock</li>"
-                "<li>POST /api/md/templates/{name}/lock</li><li>GET /api/pd/publish/{index}/payload</li>"
-                "<li>GET /api/md/templates/{name}/payload</li></ul></body></html>";
-            sendResponse(clientFd, 200, "OK", body + links, "text/html");
-            return;
+            bool isPd{true};
+            std::size_t index{0};
+            std::string name;
+            std::vector<ElementUpdate> updates;
+        };
+        std::vector<Target> targets;
+        std::map<std::string, std::size_t> targetSlots;
+
+        for (std::size_t n = 0; n < updates->items().size(); ++n)
+        {
+            const JsonValue &entry = updates->items()[n];
+            const auto reject = [&](const std::string &reason) {
+                return respond(400, "Bad Request",
+                               "{\"error\":\"" + jsonEscape(reason) + "\",\"update\":" + std::to_string(n) + "}\n");
+            };
+
+            const JsonValue *pdIndex = entry.find("pd");
+            const JsonValue *mdName = entry.find("md");
+            if ((pdIndex == nullptr) == (mdName == nullptr))
+            {
+                return reject("Each update needs exactly one of pd or md");
+            }
+            if (pdIndex && (!pdIndex->isNumber() || pdIndex->text().find_first_not_of("0123456789") != std::string::npos))
+            {
+                return reject("pd must be a publish index");
+            }
+            if (mdName && !mdName->isString())
+            {
+                return reject("md must be a template name");
+            }
+
+            ElementUpdate update;
+            const auto element = jsonString(entry, "element");
+            if (!element)
+            {
+                return reject("Missing element");
+            }
+            update.element = *element;
+            update.value = jsonString(entry, "value");
+            update.locked = jsonBool(entry, "locked");
+            if (!update.value && !update.locked)
+            {
+                return reject("Update has neither value nor locked");
+            }
+
+            const std::string key = pdIndex ? "pd:" + pdIndex->text() : "md:" + mdName->text();
+            auto slot = targetSlots.find(key);
+            if (slot == targetSlots.end())
+            {
+                Target target;
+                target.isPd = pdIndex != nullptr;
+                if (target.isPd)
+                {
+                    target.index = static_cast<std::size_t>(std::stoull(pdIndex->text()));
+                }
+                else
+                {
+                    target.name = mdName->text();
+                }
+                slot = targetSlots.emplace(key, targets.size()).first;
+                targets.push_back(std::move(target));
+            }
+            targets[slot->second].updates.push_back(std::move(update));
         }
 
-        if (req.path == "/api/pd/publish" && req.method == "GET")
+        std::lock_guard<std::mutex> lock(engineMutex);
+        std::vector<ElementValues> staged(targets.size());
+        for (std::size_t i = 0; i < targets.size(); ++i)
         {
-            std::lock_guard<std::mutex> lock(engineMutex);
-            sendResponse(clientFd, 200, "OK", renderPublishJson(pd_));
-            return;
+            const auto &target = targets[i];
+            const std::string label =
+                target.isPd ? "publish #" + std::to_string(target.index) : "template '" + target.name + "'";
+            const ElementValues *live = nullptr;
+            if (target.isPd)
+            {
+                if (target.index < pd_.publishTelegrams().size())
+                {
+                    live = &pd_.publishTelegrams()[target.index].values;
+                }
+            }
+            else
+            {
+                for (const auto &tpl : md_.templates())
+                {
+                    if (tpl.name == target.name)
+                    {
+                        live = &tpl.values;
+                        break;
+                    }
+                }
+            }
+            if (!live)
+            {
+                return respond(404, "Not Found", "{\"error\":\"Unknown " + jsonEscape(label) + "\"}\n");
+            }
+
+            staged[i] = *live;
+            std::string reason;
+            if (!applyUpdates(staged[i], target.updates, reason))
+            {
+                return respond(400, "Bad Request", "{\"error\":\"" + jsonEscape(label + ": " + reason) + "\"}\n");
+            }
         }
 
-        if (req.path == "/api/md/templates" && req.method == "GET")
+        for (std::size_t i = 0; i < targets.size(); ++i)
         {
-            std::lock_guard<std::mutex> lock(engineMutex);
-            sendResponse(clientFd, 200, "OK", renderMdJson(md_));
-            return;
+            if (targets[i].isPd)
+            {
+                pd_.replacePublishValues(targets[i].index, std::move(staged[i]));
+            }
+            else
+            {
+                md_.replaceTemplateValues(targets[i].name, std::move(staged[i]));
+            }
         }
+        return respond(200, "OK",
+                       "{\"applied\":" + std::to_string(updates->items().size()) + ",\"telegrams\":" +
+                           std::to_string(targets.size()) + "}\n");
+    }
 
-        const auto parts = splitPath(req.path);
-        if (parts.size() >= 4 && parts[0] == "api" && parts[1] == "pd" && parts[2] == "publish")
+    /**
+     * Server-Sent Events feed of value changes. Query parameters: comId and element (comma
+     * separated lists), kind (publish, subscribe, md) and maxRate (flushes per second).
+     */
+    HttpResponse handleStream(const HttpRequest &req)
+    {
+        StreamFilter filter;
+        for (const auto &comId : splitList(req.queryParam("comId").value_or("")))
         {
-            handlePdRoute(parts, req, clientFd);
-            return;
+            if (comId.find_first_not_of("0123456789") != std::string::npos || comId.size() > 10)
+            {
+                return respond(400, "Bad Request", "{\"error\":\"comId must be a list of numbers\"}\n");
+            }
+            filter.comIds.push_back(static_cast<uint32_t>(std::stoul(comId)));
         }
-        if (parts.size() >= 4 && parts[0] == "api" && parts[1] == "md" && parts[2] == "templates")
+        filter.elements = splitList(req.queryParam("element").value_or(""));
+        if (const auto kinds = req.queryParam("kind"))
+        {
+            const auto list = splitList(*kinds);
+            const auto has = [&](const char *kind) { return std::find(list.begin(), list.end(), kind) != list.end(); };
+            filter.publish = has("publish");
+            filter.subscribe = has("subscribe");
+            filter.md = has("md");
+        }
+        if (const auto rate = req.queryParam("maxRate"))
         {
-            handleMdRoute(parts, req, clientFd);
-            return;
+            char *end = nullptr;
+            const double perSecond = std::strtod(rate->c_str(), &end);
+            if (rate->empty() || *end != '\0' || !(perSecond > 0.0))
+            {
+                return respond(400, "Bad Request", "{\"error\":\"maxRate must be a positive number\"}\n");
+            }
+            filter.interval = std::chrono::milliseconds(
+                static_cast<int64_t>(1000.0 / std::min(std::max(perSecond, 0.1), 100.0)));
         }
 
-        sendResponse(clientFd, 404, "Not Found", "{}\n");
+        HttpResponse response = respond(200, "OK", "retry: 2000\n\n", "text/event-stream");
+        response.headers.emplace_back("Cache-Control", "no-cache");
+        response.stream = std::make_shared<HttpStream>();
+        streams_.add(response.stream, std::move(filter));
+        return response;
     }
 
     std::vector<std::string> splitPath(const std::string &path) const
@@ -393,22 +757,60 @@ private:
         return parts;
     }
 
-    void handlePdRoute(const std::vector<std::string> &parts, const HttpRequest &req, int clientFd)
+    HttpResponse handlePdRoute(const std::vector<std::string> &parts, const HttpRequest &req)
     {
         const std::size_t index = static_cast<std::size_t>(std::stoul(parts[3]));
         if (parts.size() == 5 && parts[4] == "payload" && req.method == "GET")
         {
-            std::vector<uint8_t> payload;
+            std::lock_guard<std::mutex> lock(engineMutex);
+            if (index >= pd_.publishTelegrams().size())
             {
-                std::lock_guard<std::mutex> lock(engineMutex);
-                if (!pd_.buildPublishPayload(index, payload))
-                {
-                    sendResponse(clientFd, 404, "Not Found", "{\"error\":\"Unknown publish index\"}\n");
-                    return;
-                }
+                return respond(404, "Not Found", "{\"error\":\"Unknown publish index\"}\n");
+            }
+            return conditional(req, renderCache_.telegramEtag(pd_.publishTelegrams()[index].version), [&]() {
+                std::vector<uint8_t> payload;
+                pd_.buildPublishPayload(index, payload);
+                return "{\"payload\":\"" + toHex(payload) + "\"}\n";
+            });
+        }
+
+        if (parts.size() == 5 && parts[4] == "raw" && req.method == "GET")
+        {
+            std::lock_guard<std::mutex> lock(engineMutex);
+            if (index >= pd_.publishTelegrams().size())
+            {
+                return respond(404, "Not Found", "{\"error\":\"Unknown publish index\"}\n");
             }
-            sendResponse(clientFd, 200, "OK", "{\"payload\":\"" + toHex(payload) + "\"}\n");
-            return;
+            return conditional(
+                req, renderCache_.telegramEtag(pd_.publishTelegrams()[index].version),
+                [&]() {
+                    std::vector<uint8_t> payload;
+                    pd_.buildPublishPayload(index, payload);
+                    return std::string(payload.begin(), payload.end());
+                },
+                "application/octet-stream");
+        }
+
+        if (parts.size() == 5 && parts[4] == "raw" && req.method == "PUT")
+        {
+            if (!isOctetStream(req))
+            {
+                return respond(415, "Unsupported Media Type", "{\"error\":\"Expected application/octet-stream\"}\n");
+            }
+            std::lock_guard<std::mutex> lock(engineMutex);
+            if (index >= pd_.publishTelegrams().size())
+            {
+                return respond(404, "Not Found", "{\"error\":\"Unknown publish index\"}\n");
+            }
+            const auto expected = pd_.publishPayloadSize(index);
+            if (req.body.size() != expected)
+            {
+                return rawSizeMismatch(expected, req.body.size());
+            }
+            const bool ok =
+                pd_.setPublishPayload(index, reinterpret_cast<const uint8_t *>(req.body.data()), req.body.size());
+            return respond(ok ? 200 : 400, ok ? "OK" : "Bad Request",
+                           ok ? "{\"updated\":true}\n" : "{\"error\":\"Failed to decode payload\"}\n");
         }
 
         if (req.method == "POST")
@@ -417,86 +819,108 @@ private:
             {
                 std::lock_guard<std::mutex> lock(engineMutex);
                 const bool ok = pd_.clearPublish(index);
-                sendResponse(clientFd, ok ? 200 : 400, ok ? "OK" : "Bad Request", ok ? "{\"cleared\":true}\n" :
+                return respond(ok ? 200 : 400, ok ? "OK" : "Bad Request", ok ? "{\"cleared\":true}\n" :
                                                                                     "{\"error\":\"Unable to clear publish\"}\n");
-                return;
             }
 
-            const auto element = parseJsonString(req.body, "element");
+            std::string parseError;
+            const auto doc = parseBody(req.body, parseError);
+            if (!doc)
+            {
+                return invalidJson(parseError);
+            }
+            const auto element = jsonString(*doc, "element");
             if (!element)
             {
-                sendResponse(clientFd, 400, "Bad Request", "{\"error\":\"Missing element\"}\n");
-                return;
+                return respond(400, "Bad Request", "{\"error\":\"Missing element\"}\n");
             }
 
             if (parts.size() == 5 && parts[4] == "value")
             {
-                const auto value = parseJsonString(req.body, "value");
+                const auto value = jsonString(*doc, "value");
                 if (!value)
                 {
-                    sendResponse(clientFd, 400, "Bad Request", "{\"error\":\"Missing value\"}\n");
-                    return;
+                    return respond(400, "Bad Request", "{\"error\":\"Missing value\"}\n");
                 }
                 std::lock_guard<std::mutex> lock(engineMutex);
                 const bool ok = pd_.setPublishValue(index, *element, *value);
-                sendResponse(clientFd, ok ? 200 : 400, ok ? "OK" : "Bad Request", ok ? "{\"updated\":true}\n" :
+                return respond(ok ? 200 : 400, ok ? "OK" : "Bad Request", ok ? "{\"updated\":true}\n" :
                                                                                     "{\"error\":\"Failed to set value\"}\n");
-                return;
             }
 
             if (parts.size() == 5 && parts[4] == "lock")
             {
-                const auto locked = parseJsonBool(req.body, "locked");
+                const auto locked = jsonBool(*doc, "locked");
                 if (!locked)
                 {
-                    sendResponse(clientFd, 400, "Bad Request", "{\"error\":\"Missing locked flag\"}\n");
-                    return;
+                    return respond(400, "Bad Request", "{\"error\":\"Missing locked flag\"}\n");
                 }
                 std::lock_guard<std::mutex> lock(engineMutex);
                 const bool ok = pd_.setPublishLock(index, *element, *locked);
-                sendResponse(clientFd,
-                             ok ? 200 : 400,
+                return respond(ok ? 200 : 400,
                              ok ? "OK" : "Bad Request",
                              ok ? "{\"locked\":" + std::string(*locked ? "true" : "false") + "}\n" :
                                    "{\"error\":\"Failed to update lock\"}\n");
-                return;
             }
         }
 
-        sendResponse(clientFd, 404, "Not Found", "{}\n");
+        return respond(404, "Not Found", "{}\n");
     }
 
-    void handleMdRoute(const std::vector<std::string> &parts, const HttpRequest &req, int clientFd)
+    HttpResponse handleMdRoute(const std::vector<std::string> &parts, const HttpRequest &req)
     {
         const std::string name = urlDecode(parts[3]);
         if (parts.size() == 5 && parts[4] == "payload" && req.method == "GET")
         {
+            std::lock_guard<std::mutex> lock(engineMutex);
+            const auto &templates = md_.templates();
+            const auto it = std::find_if(templates.begin(), templates.end(),
+                                         [&](const MdTemplate &tpl) { return tpl.name == name; });
+            if (it == templates.end())
+            {
+                return respond(404, "Not Found", "{\"error\":\"Unknown template\"}\n");
+            }
+            return conditional(req, renderCache_.telegramEtag(it->version), [&]() {
+                std::vector<uint8_t> payload;
+                md_.templatePayload(name, payload);
+                return "{\"payload\":\"" + toHex(payload) + "\"}\n";
+            });
+        }
+
+        if (parts.size() == 5 && parts[4] == "raw" && (req.method == "GET" || req.method == "PUT"))
+        {
+            if (req.method == "PUT" && !isOctetStream(req))
+            {
+                return respond(415, "Unsupported Media Type", "{\"error\":\"Expected application/octet-stream\"}\n");
+            }
+            std::lock_guard<std::mutex> lock(engineMutex);
+            const auto &templates = md_.templates();
+            const auto it = std::find_if(templates.begin(), templates.end(),
+                                         [&](const MdTemplate &tpl) { return tpl.name == name; });
+            if (it == templates.end())
+            {
+                return respond(404, "Not Found", "{\"error\":\"Unknown template\"}\n");
+            }
             std::vector<uint8_t> payload;
+            if (req.method == "GET")
             {
-                std::lock_guard<std::mutex> lock(engineMutex);
-                const auto tpl = std::find_if(md_.templates().begin(), md_.templates().end(),
-                                               [&](const auto &t) { return t.name == name; });
-                if (tpl == md_.templates().end())
-                {
-                    sendResponse(clientFd, 404, "Not Found", "{\"error\":\"Unknown template\"}\n");
-                    return;
-                }
-                const DatasetDef *dataset = md_.datasets().find(tpl->datasetId);
-                if (dataset)
-                {
-                    packDatasetToPayload(*dataset, tpl->values, payload);
-                }
-                if (config_.tauMarshaller && config_.tauMarshaller->valid())
-                {
-                    std::vector<uint8_t> marshalled;
-                    if (config_.tauMarshaller->marshall(tpl->comId, payload, marshalled))
-                    {
-                        payload = std::move(marshalled);
-                    }
-                }
+                return conditional(
+                    req, renderCache_.telegramEtag(it->version),
+                    [&]() {
+                        md_.templatePayload(name, payload);
+                        return std::string(payload.begin(), payload.end());
+                    },
+                    "application/octet-stream");
+            }
+            md_.templatePayload(name, payload);
+            if (req.body.size() != payload.size())
+            {
+                return rawSizeMismatch(payload.size(), req.body.size());
             }
-            sendResponse(clientFd, 200, "OK", "{\"payload\":\"" + toHex(payload) + "\"}\n");
-            return;
+            const bool ok =
+                md_.setTemplatePayload(name, reinterpret_cast<const uint8_t *>(req.body.data()), req.body.size());
+            return respond(ok ? 200 : 400, ok ? "OK" : "Bad Request",
+                           ok ? "{\"updated\":true}\n" : "{\"error\":\"Failed to decode payload\"}\n");
         }
 
         if (req.method == "POST")
@@ -505,61 +929,67 @@ private:
             {
                 std::lock_guard<std::mutex> lock(engineMutex);
                 const bool ok = md_.clearTemplate(name);
-                sendResponse(clientFd, ok ? 200 : 400, ok ? "OK" : "Bad Request", ok ? "{\"cleared\":true}\n" :
+                return respond(ok ? 200 : 400, ok ? "OK" : "Bad Request", ok ? "{\"cleared\":true}\n" :
                                                                                     "{\"error\":\"Unable to clear template\"}\n");
-                return;
             }
 
-            const auto element = parseJsonString(req.body, "element");
+            std::string parseError;
+            const auto doc = parseBody(req.body, parseError);
+            if (!doc)
+            {
+                return invalidJson(parseError);
+            }
+            const auto element = jsonString(*doc, "element");
             if (!element)
             {
-                sendResponse(clientFd, 400, "Bad Request", "{\"error\":\"Missing element\"}\n");
-                return;
+                return respond(400, "Bad Request", "{\"error\":\"Missing element\"}\n");
             }
 
             if (parts.size() == 5 && parts[4] == "value")
             {
-                const auto value = parseJsonString(req.body, "value");
+                const auto value = jsonString(*doc, "value");
                 if (!value)
                 {
-                    sendResponse(clientFd, 400, "Bad Request", "{\"error\":\"Missing value\"}\n");
-                    return;
+                    return respond(400, "Bad Request", "{\"error\":\"Missing value\"}\n");
                 }
                 std::lock_guard<std::mutex> lock(engineMutex);
                 const bool ok = md_.setTemplateValue(name, *element, *value);
-                sendResponse(clientFd, ok ? 200 : 400, ok ? "OK" : "Bad Request", ok ? "{\"updated\":true}\n" :
+                return respond(ok ? 200 : 400, ok ? "OK" : "Bad Request", ok ? "{\"updated\":true}\n" :
                                                                                     "{\"error\":\"Failed to set value\"}\n");
-                return;
             }
 
             if (parts.size() == 5 && parts[4] == "lock")
             {
-                const auto locked = parseJsonBool(req.body, "locked");
+                const auto locked = jsonBool(*doc, "locked");
                 if (!locked)
                 {
-                    sendResponse(clientFd, 400, "Bad Request", "{\"error\":\"Missing locked flag\"}\n");
-                    return;
+                    return respond(400, "Bad Request", "{\"error\":\"Missing locked flag\"}\n");
                 }
                 std::lock_guard<std::mutex> lock(engineMutex);
                 const bool ok = md_.setTemplateLock(name, *element, *locked);
-                sendResponse(clientFd,
-                             ok ? 200 : 400,
+                return respond(ok ? 200 : 400,
                              ok ? "OK" : "Bad Request",
                              ok ? "{\"locked\":" + std::string(*locked ? "true" : "false") + "}\n" :
                                    "{\"error\":\"Failed to update lock\"}\n");
-                return;
             }
         }
 
-        sendResponse(clientFd, 404, "Not Found", "{}\n");
+        return respond(404, "Not Found", "{}\n");
     }
 
     PdEngine &pd_;
     MdEngine &md_;
     TrdpConfig &config_;
+    ConfigReloader &reloader_;
+    const TrdpSession &session_;
+    std::shared_ptr<const FlightRecorder> recorder_;
     std::atomic_bool &running_;
-    std::thread serverThread_;
-    uint16_t port_{8080};
+    std::string reloadDirectory_; // canonical directory of the startup device file
+    ValueStreamHub streams_;
+    RenderCache renderCache_; // guarded by engineMutex
+    Histogram requestLatency_{{100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000}};
+    std::array<Counter, 6> requestsByClass_; // by status / 100; slot 0 catches anything odd
+    HttpServer server_; // last, so it stops before the members its handler uses go away
 };
 
 void handleSignal(int)
@@ -567,7 +997,21 @@ void handleSignal(int)
     running.store(false);
 }
 
-void repl(PdEngine &pd, MdEngine &md)
+void handleDumpSignal(int)
+{
+    flightDumpRequested.store(true);
+}
+
+std::string defaultFlightDumpPath()
+{
+    return "trdp-flight-" + std::to_string(static_cast<long long>(std::time(nullptr))) + ".bin";
+}
+
+void repl(PdEngine &pd,
+          MdEngine &md,
+          ConfigReloader &reloader,
+          const std::shared_ptr<FlightRecorder> &recorder,
+          PdReplay &replay)
 {
     std::string line;
     std::cout << "Type 'help' for commands" << std::endl;
@@ -586,6 +1030,9 @@ void repl(PdEngine &pd, MdEngine &md)
             std::cout << "Commands:\n"
                       << "  list-pd-pub\n  list-pd-sub\n  set-pd-value <index> <element> <value>\n  clear-pd-pub <index>\n"
                       << "  list-md\n  set-md-value <name> <element> <value>\n  clear-md <name>\n  send-md <name>\n"
+                      << "  stats\n  flight-show [count]\n  flight-dump [file]\n"
+                      << "  replay <capture> [speed|max]\n  replay-stop\n"
+                      << "  reload [device.xml]\n  log-level [debug|info|warn|error|off]\n  log-sites\n"
                       << std::endl;
         }
         else if (cmd == "list-pd-pub")
@@ -598,6 +1045,56 @@ void repl(PdEngine &pd, MdEngine &md)
             std::lock_guard<std::mutex> lock(engineMutex);
             pd.listSubscribe(std::cout);
         }
+        else if (cmd == "flight-show" || cmd == "flight-dump")
+        {
+            if (!recorder)
+            {
+                std::cout << "Flight recorder disabled (--flight-events 0)" << std::endl;
+            }
+            else if (cmd == "flight-show")
+            {
+                std::size_t count = 20;
+                iss >> count;
+                recorder->print(std::cout, count);
+            }
+            else
+            {
+                std::string path;
+                if (!(iss >> path))
+                {
+                    path = defaultFlightDumpPath();
+                }
+                recorder->dumpToFile(path);
+            }
+        }
+        else if (cmd == "replay")
+        {
+            std::string path, speedText = "1";
+            double speed = 1.0;
+            if (!(iss >> path) || ((iss >> speedText) && !parseReplaySpeed(speedText, speed)))
+            {
+                std::cout << "Usage: replay <capture.pcap|pcapng> [speed|max]" << std::endl;
+            }
+            else if (replay.active())
+            {
+                std::cout << "Replay already in progress" << std::endl;
+            }
+            else
+            {
+                replay.start(path, speed);
+            }
+        }
+        else if (cmd == "replay-stop")
+        {
+            replay.stop();
+        }
+        else if (cmd == "stats")
+        {
+            std::lock_guard<std::mutex> lock(engineMutex);
+            const auto now = std::chrono::steady_clock::now();
+            pd.listStats(std::cout, now);
+            md.listStats(std::cout, now);
+        }
         else if (cmd == "set-pd-value")
         {
             std::size_t idx;
@@ -666,6 +1163,47 @@ void repl(PdEngine &pd, MdEngine &md)
                 }
             }
         }
+        else if (cmd == "reload")
+        {
+            std::string path;
+            iss >> path;
+            if (!reloader.request(path))
+            {
+                std::cout << "Reload already in progress" << std::endl;
+            }
+        }
+        else if (cmd == "log-level")
+        {
+            std::string name;
+            if (!(iss >> name))
+            {
+                std::cout << "Log level: " << toString(logLevel()) << std::endl;
+            }
+            else if (const auto level = parseLogLevel(name))
+            {
+                setLogLevel(*level);
+            }
+            else
+            {
+                std::cout << "Usage: log-level [debug|info|warn|error|off]" << std::endl;
+            }
+        }
+        else if (cmd == "log-sites")
+        {
+            const auto sites = logSiteStats();
+            if (sites.empty())
+            {
+                std::cout << "No rate-limited messages logged yet" << std::endl;
+            }
+            for (const auto &site : sites)
+            {
+                for (const auto &message : site.messages)
+                {
+                    std::cout << site.site << ": " << message.occurrences << " seen, " << message.suppressed
+                              << " suppressed: " << message.message << std::endl;
+                }
+            }
+        }
         else if (!cmd.empty())
         {
             std::cout << "Unknown command: " << cmd << std::endl;
@@ -678,32 +1216,175 @@ void repl(PdEngine &pd, MdEngine &md)
 int main(int argc, char **argv)
 {
     std::signal(SIGINT, handleSignal);
+    std::signal(SIGUSR1, handleDumpSignal);
 
-    const std::string deviceFile = (argc > 1) ? argv[1] : "apps/trdp-sim/example-device.xml";
+    std::string deviceFile = "apps/trdp-sim/example-device.xml";
+    std::string cacheFile;
+    std::size_t flightEvents = 65536;
+    std::string captureFile;
+    std::string captureIp;
+    std::string replayFile;
+    std::string replaySpeed = "1";
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--config-cache" && i + 1 < argc)
+        {
+            cacheFile = argv[++i];
+        }
+        else if (arg == "--capture" && i + 1 < argc)
+        {
+            captureFile = argv[++i];
+        }
+        else if (arg == "--capture-ip" && i + 1 < argc)
+        {
+            captureIp = argv[++i];
+        }
+        else if (arg == "--replay" && i + 1 < argc)
+        {
+            replayFile = argv[++i];
+        }
+        else if (arg == "--replay-speed" && i + 1 < argc)
+        {
+            replaySpeed = argv[++i];
+        }
+        else if (arg == "--flight-events" && i + 1 < argc)
+        {
+            flightEvents = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            deviceFile = arg;
+        }
+    }
 
     XmlConfigLoader loader;
-    auto config = loader.loadFromDeviceConfig(deviceFile, "", "", "");
+    auto config = cacheFile.empty() ? loader.loadFromDeviceConfig(deviceFile, "", "", "")
+                                    : loader.loadFromDeviceConfigCached(deviceFile, cacheFile);
     if (!config)
     {
         error("Failed to load configuration");
         return 1;
     }
 
-    TrdpSession session;
+    TrdpSession session(SessionConfig::fromDeviceConfig(*config));
     session.init();
     session.open();
 
     PdEngine pd(*config);
     MdEngine md(*config);
 
-    SimpleHttpServer http(pd, md, *config, running);
+    // Last sends, receptions and timeouts for post-mortems; dumped on SIGUSR1, flight-dump or
+    // GET /api/flight-recorder.
+    std::shared_ptr<FlightRecorder> recorder;
+    if (flightEvents > 0)
+    {
+        recorder = std::make_shared<FlightRecorder>(flightEvents);
+        pd.attachRecorder(recorder);
+        md.attachRecorder(recorder);
+    }
+
+    // MD frames leave from an ephemeral port so replies can be received without
+    // competing with the TRDP stack for the well-known MD port.
+    auto mdTransport = std::make_shared<MdTransport>();
+    if (mdTransport->open("0.0.0.0", 0))
+    {
+        mdTransport->setTrafficClass(config->mdDefaults.qos, config->mdDefaults.ttl);
+        md.attachTransport(mdTransport);
+    }
+
+    // Optional pcapng copy of the MD frames on the wire and of the PD frames the device would publish.
+    std::shared_ptr<PacketCapture> capture;
+    if (!captureFile.empty())
+    {
+        capture = std::make_shared<PacketCapture>();
+        uint32_t localIp = 0;
+        if (!captureIp.empty() && parseIpv4(captureIp, localIp))
+        {
+            capture->setLocalIp(localIp);
+        }
+        else if (!captureIp.empty())
+        {
+            warn("Ignoring --capture-ip '", captureIp, "': not an IPv4 address");
+        }
+        if (capture->open(captureFile))
+        {
+            mdTransport->attachCapture(capture);
+        }
+        else
+        {
+            capture.reset();
+        }
+    }
+    // Simulated PD publishing: counts each due publish telegram and copies it to the capture.
+    PdPublishTap pdTap(capture);
+
+    // Reloads are parsed in the background and swapped in between session cycles.
+    ConfigReloader reloader(deviceFile, cacheFile);
+
+    SimpleHttpServer http(pd, md, *config, reloader, session, recorder, running);
     http.start(8080);
 
-    std::thread worker([&]() { session.runLoop(running); });
-    repl(pd, md);
+    std::thread worker([&]() {
+        session.runLoop(running, [&]() {
+            {
+                std::lock_guard<std::mutex> lock(engineMutex);
+                const auto now = std::chrono::steady_clock::now();
+                pd.checkTimeouts(now);
+                pdTap.run(pd, config->pdDefaults.port, now);
+            }
+            if (flightDumpRequested.exchange(false) && recorder)
+            {
+                // Off the cycle thread: writing a full ring takes a while.
+                std::thread([recorder]() { recorder->dumpToFile(defaultFlightDumpPath()); }).detach();
+            }
+            if (reloader.ready())
+            {
+                std::lock_guard<std::mutex> lock(engineMutex);
+                if (const auto diff = reloader.applyPending(*config))
+                {
+                    session.setCycleTime(config->process.cycleTimeUs);
+                    pd.carryStats(*diff);
+                    md.carryStats(*diff);
+                    md.preparePayloads();
+                    mdTransport->setTrafficClass(config->mdDefaults.qos, config->mdDefaults.ttl);
+                }
+            }
+        });
+    });
+    std::thread mdReceiver([&]() {
+        while (running.load() && mdTransport->isOpen())
+        {
+            MdFrame frame;
+            if (mdTransport->receive(frame, 200))
+            {
+                std::lock_guard<std::mutex> lock(engineMutex);
+                md.handleFrame(frame);
+            }
+        }
+    });
+    // Captured PD traffic fed into the subscriptions, from --replay or the replay command.
+    PdReplay replay(pd, engineMutex);
+    if (!replayFile.empty())
+    {
+        double speed = 1.0;
+        if (!parseReplaySpeed(replaySpeed, speed))
+        {
+            warn("Ignoring --replay-speed '", replaySpeed, "': expected a factor or 'max'");
+            speed = 1.0;
+        }
+        replay.start(replayFile, speed);
+    }
+    repl(pd, md, reloader, recorder, replay);
     running.store(false);
+    replay.stop();
     http.stop();
     worker.join();
+    mdReceiver.join();
+    if (capture)
+    {
+        capture->close();
+    }
     session.close();
 
     return 0;
@@ -0,0 +1,197 @@
+#include "pd_replay.hpp"
+
+#include "trdp/logging.hpp"
+#include "trdp/telegram_stats.hpp"
+#include "trdp/wire.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace trdp
+{
+
+namespace
+{
+// Frames applied per lock; at a few hundred nanoseconds each the lock is held well under 1 ms.
+constexpr std::size_t kBatchSize = 256;
+// Longest single sleep in timed mode, so a stop request is noticed promptly.
+constexpr auto kMaxSleep = std::chrono::milliseconds(100);
+} // namespace
+
+bool parseReplaySpeed(const std::string &text, double &speed)
+{
+    if (text == "max")
+    {
+        speed = 0.0;
+        return true;
+    }
+    char *end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    if (text.empty() || end != text.c_str() + text.size() || !(value > 0.0))
+    {
+        return false;
+    }
+    speed = value;
+    return true;
+}
+
+PdReplay::PdReplay(PdEngine &pd, std::mutex &engineMutex) : pd_(pd), engineMutex_(engineMutex) {}
+
+PdReplay::~PdReplay()
+{
+    stop();
+}
+
+bool PdReplay::start(const std::string &path, double speed)
+{
+    if (active_.load())
+    {
+        return false;
+    }
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+    auto reader = std::make_unique<CaptureReader>();
+    if (!reader->open(path))
+    {
+        return false;
+    }
+    reader_ = std::move(reader);
+    path_ = path;
+    stopRequested_.store(false);
+    active_.store(true);
+    thread_ = std::thread([this, speed]() { run(speed); });
+    return true;
+}
+
+void PdReplay::stop()
+{
+    stopRequested_.store(true);
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void PdReplay::run(double speed)
+{
+    info("Replaying PD frames from ", path_, speed > 0.0 ? "" : " as fast as possible");
+    {
+        std::lock_guard<std::mutex> lock(engineMutex_);
+        buildRoutes();
+    }
+
+    Report report;
+    CapturedDatagram datagram;
+    bool more = reader_->next(datagram);
+    report.firstNs = datagram.timeNs;
+    const auto wallStart = std::chrono::steady_clock::now();
+    // When the capture says a frame arrived, mapped onto the wall clock and scaled by speed.
+    const auto dueAt = [&](uint64_t timeNs) {
+        const auto offsetNs = static_cast<double>(static_cast<int64_t>(timeNs - report.firstNs)) / speed;
+        return wallStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double, std::nano>(offsetNs));
+    };
+
+    while (more && !stopRequested_.load(std::memory_order_relaxed))
+    {
+        if (speed > 0.0)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            const auto due = dueAt(datagram.timeNs);
+            if (due > now)
+            {
+                std::this_thread::sleep_until(std::min(due, now + kMaxSleep));
+                continue;
+            }
+        }
+
+        const auto batchNow = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(engineMutex_);
+        for (std::size_t n = 0; more && n < kBatchSize; ++n)
+        {
+            if (speed > 0.0 && n > 0 && dueAt(datagram.timeNs) > batchNow)
+            {
+                break;
+            }
+            apply(datagram, report);
+            report.lastNs = datagram.timeNs;
+            more = reader_->next(datagram);
+        }
+    }
+
+    const auto wallUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wallStart).count());
+    const auto spanUs = report.lastNs > report.firstNs ? (report.lastNs - report.firstNs) / 1000u : 0u;
+    const double wallSeconds = static_cast<double>(wallUs > 0 ? wallUs : 1) / 1e6;
+    char rates[96];
+    std::snprintf(rates, sizeof(rates), "%.0f frames/s, %.1f MB/s, %.1fx real time",
+                  static_cast<double>(report.pdFrames) / wallSeconds,
+                  static_cast<double>(report.bytes) / wallSeconds / 1e6, static_cast<double>(spanUs) / 1e6 / wallSeconds);
+    info(stopRequested_.load() ? "Stopped replay of " : "Replayed ", path_, ": ", report.pdFrames, " PD frames (",
+         report.applied, " applied, ", report.rejected, " rejected, ", report.unsubscribed, " without subscription), ",
+         report.otherDatagrams, " other datagrams, ", reader_->skipped(), " non-UDP frames; ", formatDuration(spanUs),
+         " of traffic in ", formatDuration(wallUs), ": ", rates);
+
+    reader_.reset();
+    active_.store(false);
+}
+
+void PdReplay::apply(const CapturedDatagram &datagram, Report &report)
+{
+    PdHeader header;
+    if (!decodePdHeader(datagram.payload, datagram.size, header) ||
+        (header.msgType != PdMessageType::Data && header.msgType != PdMessageType::Pull) ||
+        header.datasetLength > datagram.size - kPdHeaderSize)
+    {
+        ++report.otherDatagrams;
+        return;
+    }
+    ++report.pdFrames;
+    report.bytes += datagram.size;
+
+    const auto *indices = routesFor(header.comId);
+    if (indices == nullptr)
+    {
+        ++report.unsubscribed;
+        return;
+    }
+    for (const auto index : *indices)
+    {
+        if (pd_.updateSubscribeValues(index, datagram.payload + kPdHeaderSize, header.datasetLength))
+        {
+            ++report.applied;
+        }
+        else
+        {
+            ++report.rejected;
+        }
+    }
+}
+
+const std::vector<std::size_t> *PdReplay::routesFor(uint32_t comId)
+{
+    // A reload moves in a new subscription list between two batches; rebuild when it has.
+    if (pd_.configGeneration() != routedGeneration_)
+    {
+        buildRoutes();
+    }
+    const auto it = routes_.find(comId);
+    return it != routes_.end() ? &it->second : nullptr;
+}
+
+void PdReplay::buildRoutes()
+{
+    routes_.clear();
+    const auto &subscribe = pd_.subscribeTelegrams();
+    for (std::size_t i = 0; i < subscribe.size(); ++i)
+    {
+        routes_[subscribe[i].comId].push_back(i);
+    }
+    routedGeneration_ = pd_.configGeneration();
+}
+
+} // namespace trdp
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "trdp/capture_reader.hpp"
+#include "trdp/pd.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace trdp
+{
+
+/** Parse a replay speed: a factor such as "1" or "0.5", or "max" (returned as 0). */
+bool parseReplaySpeed(const std::string &text, double &speed);
+
+/**
+ * Feeds the PD frames of a pcap/pcapng capture into PdEngine::updateSubscribeValues(), as if
+ * they had just been received. Frames are matched to subscriptions by ComId, without source
+ * filtering, so field captures replay regardless of the addresses they were recorded with;
+ * other UDP traffic in the capture (MD, or PD for ComIds nothing subscribes to) is counted and
+ * skipped.
+ *
+ * speed 1 keeps the capture's timing, 10 replays ten times faster and 0 as fast as possible.
+ * Frames are applied in batches under the engine lock, so the cycle thread and CLI stay
+ * responsive while an hour of traffic goes through in seconds. The result, including the
+ * achieved frame rate, is logged when the replay ends.
+ */
+class PdReplay
+{
+public:
+    PdReplay(PdEngine &pd, std::mutex &engineMutex);
+    ~PdReplay();
+
+    PdReplay(const PdReplay &) = delete;
+    PdReplay &operator=(const PdReplay &) = delete;
+
+    /** Start replaying in the background; false if one is already running or the file is unusable. */
+    bool start(const std::string &path, double speed);
+    /** Stop a running replay and wait for it; its partial result is still logged. */
+    void stop();
+    bool active() const { return active_.load(); }
+
+private:
+    struct Report
+    {
+        uint64_t pdFrames{0};
+        uint64_t bytes{0};
+        uint64_t applied{0};
+        uint64_t rejected{0};     // updateSubscribeValues() refused the payload
+        uint64_t unsubscribed{0}; // PD frames for a ComId without subscription
+        uint64_t otherDatagrams{0};
+        uint64_t firstNs{0};
+        uint64_t lastNs{0};
+    };
+
+    void run(double speed);
+    void apply(const CapturedDatagram &datagram, Report &report);
+    const std::vector<std::size_t> *routesFor(uint32_t comId);
+    void buildRoutes();
+
+    PdEngine &pd_;
+    std::mutex &engineMutex_;
+    std::unique_ptr<CaptureReader> reader_;
+    std::string path_;
+    std::unordered_map<uint32_t, std::vector<std::size_t>> routes_; // ComId -> subscribe indices
+    uint64_t routedGeneration_{0}; // configuration generation routes_ was built from
+    std::atomic_bool active_{false};
+    std::atomic_bool stopRequested_{false};
+    std::thread thread_;
+};
+
+} // namespace trdp
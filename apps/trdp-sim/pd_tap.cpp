@@ -0,0 +1,71 @@
+#include "pd_tap.hpp"
+
+#include "trdp/logging.hpp"
+
+#include <algorithm>
+
+namespace trdp
+{
+
+PdPublishTap::PdPublishTap(std::shared_ptr<PacketCapture> capture) : capture_(std::move(capture)) {}
+
+void PdPublishTap::run(PdEngine &pd, uint16_t port, std::chrono::steady_clock::time_point now)
+{
+    const auto &publish = pd.publishTelegrams();
+    if (schedules_.size() != publish.size())
+    {
+        schedules_.assign(publish.size(), Schedule{});
+    }
+
+    static const uint8_t kZeroPadding[4] = {0, 0, 0, 0};
+    for (std::size_t i = 0; i < publish.size(); ++i)
+    {
+        auto &schedule = schedules_[i];
+        if (now < schedule.due)
+        {
+            continue;
+        }
+        const auto &pub = publish[i];
+        const auto cycle = std::chrono::milliseconds(std::max<uint32_t>(pub.cycleTimeMs, 1));
+        // Keep the cadence, but do not burst to catch up after a stall.
+        schedule.due = schedule.due == std::chrono::steady_clock::time_point{} || now - schedule.due > cycle
+                           ? now + cycle
+                           : schedule.due + cycle;
+
+        std::size_t written = 0;
+        if (!pd.buildPublishPayload(i, payload_.data(), payload_.size(), written))
+        {
+            static LogSite buildSite("pd_tap.build");
+            warn(buildSite, "Cannot build PD payload for ComId ", pub.comId, "; not sent");
+            continue;
+        }
+        pd.recordSent(i, now, payload_.data(), written);
+        if (!capture_)
+        {
+            continue;
+        }
+
+        PdHeader header;
+        header.sequenceCounter = schedule.sequence++;
+        header.comId = pub.comId;
+        header.datasetLength = static_cast<uint32_t>(written);
+        std::array<uint8_t, kPdHeaderSize> headerBytes{};
+        encodePdHeader(header, headerBytes);
+
+        CaptureAddress address;
+        address.sourceIp = capture_->localIp();
+        address.sourcePort = port;
+        if (!parseIpv4(pub.destinationIp, address.destinationIp))
+        {
+            address.destinationIp = 0xFFFFFFFFu;
+        }
+        address.destinationPort = port;
+        address.tos = static_cast<uint8_t>((pub.priority & 0x07u) << 5);
+        address.ttl = pub.ttl;
+        const CaptureSegment segments[3] = {
+            {headerBytes.data(), headerBytes.size()}, {payload_.data(), written}, {kZeroPadding, paddingFor(written)}};
+        capture_->capture(address, segments, 3);
+    }
+}
+
+} // namespace trdp
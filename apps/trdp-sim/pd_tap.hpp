@@ -0,0 +1,44 @@
+#pragma once
+
+#include "trdp/packet_capture.hpp"
+#include "trdp/pd.hpp"
+#include "trdp/wire.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace trdp
+{
+
+/**
+ * Produces the PD frames this device would publish, each at its telegram's cycle time. Nothing
+ * is sent on the network: the simulator has no PD transport, so this stands in for one. Every
+ * frame is counted through PdEngine::recordSent(), which feeds the sent counts, send jitter
+ * and flight recorder, and is copied to the packet capture when there is one. Frames carry a
+ * per-telegram sequence counter and the payload as buildPublishPayload() produces it.
+ * Call run() from the cycle thread with the engine lock held.
+ */
+class PdPublishTap
+{
+public:
+    /** capture may be null, in which case frames are only counted. */
+    explicit PdPublishTap(std::shared_ptr<PacketCapture> capture);
+
+    void run(PdEngine &pd, uint16_t port, std::chrono::steady_clock::time_point now);
+
+private:
+    struct Schedule
+    {
+        std::chrono::steady_clock::time_point due{};
+        uint32_t sequence{0};
+    };
+
+    std::shared_ptr<PacketCapture> capture_;
+    std::vector<Schedule> schedules_; // indexed like the publish telegrams; restarted after a reload
+    std::array<uint8_t, kPdMaxDataSize> payload_{};
+};
+
+} // namespace trdp
@@ -0,0 +1,144 @@
+#include "prometheus.hpp"
+
+#include <cstdio>
+#include <unistd.h>
+
+namespace trdp
+{
+
+namespace
+{
+void appendEscaped(std::string &out, const std::string &value)
+{
+    for (const char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            out.push_back('\\');
+            out.push_back(c);
+        }
+        else if (c == '\n')
+        {
+            out += "\\n";
+        }
+        else
+        {
+            out.push_back(c);
+        }
+    }
+}
+
+/** Microseconds as a decimal number of seconds without trailing zeros, e.g. 2500 -> 0.0025. */
+std::string seconds(uint64_t us)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%llu.%06llu", static_cast<unsigned long long>(us / 1000000u),
+                  static_cast<unsigned long long>(us % 1000000u));
+    std::string out(text);
+    while (out.back() == '0')
+    {
+        out.pop_back();
+    }
+    if (out.back() == '.')
+    {
+        out.pop_back();
+    }
+    return out;
+}
+} // namespace
+
+void PrometheusWriter::family(const char *name, const char *type, const char *help)
+{
+    out_ += "# HELP ";
+    out_ += name;
+    out_ += ' ';
+    out_ += help;
+    out_ += "\n# TYPE ";
+    out_ += name;
+    out_ += ' ';
+    out_ += type;
+    out_ += '\n';
+}
+
+void PrometheusWriter::appendLabels(const MetricLabels &labels, const char *extraName, const std::string &extraValue)
+{
+    if (labels.empty() && extraName == nullptr)
+    {
+        return;
+    }
+    out_ += '{';
+    bool first = true;
+    const auto append = [&](const char *name, const std::string &value) {
+        if (!first)
+        {
+            out_ += ',';
+        }
+        first = false;
+        out_ += name;
+        out_ += "=\"";
+        appendEscaped(out_, value);
+        out_ += '"';
+    };
+    for (const auto &label : labels)
+    {
+        append(label.first, label.second);
+    }
+    if (extraName != nullptr)
+    {
+        append(extraName, extraValue);
+    }
+    out_ += '}';
+}
+
+void PrometheusWriter::sample(const char *name, const MetricLabels &labels, uint64_t value)
+{
+    out_ += name;
+    appendLabels(labels);
+    out_ += ' ';
+    out_ += std::to_string(value);
+    out_ += '\n';
+}
+
+void PrometheusWriter::histogram(const char *name, const MetricLabels &labels, const Histogram::Snapshot &snapshot)
+{
+    const std::string base(name);
+    uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < snapshot.buckets.size(); ++i)
+    {
+        cumulative += snapshot.buckets[i];
+        out_ += base + "_bucket";
+        appendLabels(labels, "le", i < snapshot.upperBoundsUs.size() ? seconds(snapshot.upperBoundsUs[i]) : "+Inf");
+        out_ += ' ';
+        out_ += std::to_string(cumulative);
+        out_ += '\n';
+    }
+    out_ += base + "_sum";
+    appendLabels(labels);
+    out_ += ' ';
+    out_ += seconds(snapshot.sumUs);
+    out_ += '\n';
+    sample((base + "_count").c_str(), labels, snapshot.count);
+}
+
+bool readProcessMemory(uint64_t &residentBytes, uint64_t &virtualBytes)
+{
+    std::FILE *file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    unsigned long long sizePages = 0;
+    unsigned long long residentPages = 0;
+    const bool ok = std::fscanf(file, "%llu %llu", &sizePages, &residentPages) == 2;
+    std::fclose(file);
+    if (!ok)
+    {
+        return false;
+    }
+    const auto pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    residentBytes = residentPages * pageSize;
+    virtualBytes = sizePages * pageSize;
+    return true;
+}
+
+} // namespace trdp
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "trdp/metrics.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace trdp
+{
+
+using MetricLabels = std::vector<std::pair<const char *, std::string>>;
+
+/**
+ * Builds a page in the Prometheus text exposition format (version 0.0.4). Call family() once
+ * per metric name, then add its samples; durations are converted from microseconds to seconds.
+ */
+class PrometheusWriter
+{
+public:
+    void family(const char *name, const char *type, const char *help);
+    void sample(const char *name, const MetricLabels &labels, uint64_t value);
+    void histogram(const char *name, const MetricLabels &labels, const Histogram::Snapshot &snapshot);
+
+    const std::string &text() const { return out_; }
+
+private:
+    void appendLabels(const MetricLabels &labels, const char *extraName = nullptr, const std::string &extraValue = {});
+
+    std::string out_;
+};
+
+/** Resident and virtual size of this process from /proc/self/statm; false where unavailable. */
+bool readProcessMemory(uint64_t &residentBytes, uint64_t &virtualBytes);
+
+} // namespace trdp
@@ -0,0 +1,535 @@
+#include "render.hpp"
+
+#include "json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace trdp
+{
+
+namespace
+{
+struct HexTable
+{
+    char pairs[256][2];
+
+    constexpr HexTable() : pairs()
+    {
+        constexpr char digits[] = "0123456789abcdef";
+        for (int i = 0; i < 256; ++i)
+        {
+            pairs[i][0] = digits[i >> 4];
+            pairs[i][1] = digits[i & 0x0F];
+        }
+    }
+};
+
+constexpr HexTable kHexTable;
+
+bool wanted(const std::vector<std::string> &fields, const char *name)
+{
+    return fields.empty() || std::find(fields.begin(), fields.end(), name) != fields.end();
+}
+
+/** Writes the members of one JSON object, leaving out those a projection does not list. */
+class ObjectWriter
+{
+public:
+    ObjectWriter(std::string &out, const std::vector<std::string> &fields) : out_(out), fields_(fields)
+    {
+        out_ += "{";
+    }
+
+    /** Emit the member name and return true if the member is wanted; the caller appends the value. */
+    bool member(const char *name)
+    {
+        if (!wanted(fields_, name))
+        {
+            return false;
+        }
+        if (!first_)
+        {
+            out_ += ",";
+        }
+        first_ = false;
+        out_ += "\"";
+        out_ += name;
+        out_ += "\":";
+        return true;
+    }
+
+    void number(const char *name, uint64_t value)
+    {
+        if (member(name))
+        {
+            out_ += std::to_string(value);
+        }
+    }
+
+    void string(const char *name, const std::string &value)
+    {
+        if (member(name))
+        {
+            out_ += "\"";
+            out_ += jsonEscape(value);
+            out_ += "\"";
+        }
+    }
+
+    void finish() { out_ += "}"; }
+
+private:
+    std::string &out_;
+    const std::vector<std::string> &fields_;
+    bool first_{true};
+};
+
+void appendPublishFragment(std::string &out,
+                           std::size_t index,
+                           const PdPublishTelegram &pub,
+                           const std::vector<std::string> &fields = {},
+                           const std::vector<std::string> &valueFields = {})
+{
+    ObjectWriter object(out, fields);
+    object.number("index", index);
+    object.number("comId", pub.comId);
+    object.number("datasetId", pub.datasetId);
+    object.string("destination", pub.destinationIp);
+    object.number("cycleTimeMs", pub.cycleTimeMs);
+    object.number("qos", pub.priority);
+    object.number("ttl", pub.ttl);
+    object.number("version", pub.version);
+    if (object.member("values"))
+    {
+        appendValuesJson(out, pub.values, {}, valueFields);
+    }
+    object.finish();
+}
+
+void appendMdFragment(std::string &out,
+                      const MdTemplate &tpl,
+                      const std::vector<std::string> &fields = {},
+                      const std::vector<std::string> &valueFields = {})
+{
+    ObjectWriter object(out, fields);
+    object.string("name", tpl.name);
+    object.number("comId", tpl.comId);
+    object.number("datasetId", tpl.datasetId);
+    object.string("destination", tpl.destinationIp + ":" + std::to_string(tpl.destinationPort));
+    object.number("direction", static_cast<uint64_t>(tpl.direction));
+    object.number("version", tpl.version);
+    if (object.member("values"))
+    {
+        appendValuesJson(out, tpl.values, {}, valueFields);
+    }
+    object.finish();
+}
+
+void appendHistogramJson(std::string &out, const Histogram::Snapshot &snapshot, uint64_t maxUs)
+{
+    const std::vector<std::string> all;
+    ObjectWriter object(out, all);
+    object.number("count", snapshot.count);
+    object.number("sumUs", snapshot.sumUs);
+    object.number("maxUs", maxUs);
+    const auto appendArray = [&](const char *name, const std::vector<uint64_t> &values) {
+        object.member(name);
+        out += "[";
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            out += i == 0 ? "" : ",";
+            out += std::to_string(values[i]);
+        }
+        out += "]";
+    };
+    appendArray("upperBoundsUs", snapshot.upperBoundsUs);
+    appendArray("buckets", snapshot.buckets);
+    object.finish();
+}
+
+/** Shared members of one entry in GET /api/stats; "lastReceiveAgeUs" is null before the first reception. */
+void appendStatsMembers(ObjectWriter &object,
+                        std::string &out,
+                        const TelegramStats &stats,
+                        std::chrono::steady_clock::time_point now)
+{
+    object.number("sent", stats.sent);
+    object.number("received", stats.received);
+    object.number("timeouts", stats.timeouts);
+    object.number("marshallFailures", stats.marshallFailures);
+    object.member("lastReceiveAgeUs");
+    if (stats.lastReceive == std::chrono::steady_clock::time_point{})
+    {
+        out += "null";
+    }
+    else
+    {
+        out += std::to_string(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - stats.lastReceive).count());
+    }
+}
+
+template <typename Telegram>
+bool matches(const ListQuery &query, const Telegram &telegram)
+{
+    return (query.comIds.empty() ||
+            std::find(query.comIds.begin(), query.comIds.end(), telegram.comId) != query.comIds.end()) &&
+           (query.datasetIds.empty() ||
+            std::find(query.datasetIds.begin(), query.datasetIds.end(), telegram.datasetId) != query.datasetIds.end()) &&
+           (query.destinations.empty() || std::find(query.destinations.begin(), query.destinations.end(),
+                                                    telegram.destinationIp) != query.destinations.end());
+}
+} // namespace
+
+std::string toHex(const std::vector<uint8_t> &data)
+{
+    std::string out;
+    appendHex(out, data.data(), data.size());
+    return out;
+}
+
+void appendHex(std::string &out, const uint8_t *data, std::size_t size)
+{
+    const auto start = out.size();
+    out.resize(start + size * 2);
+    char *cursor = &out[start];
+    for (std::size_t i = 0; i < size; ++i, cursor += 2)
+    {
+        std::memcpy(cursor, kHexTable.pairs[data[i]], 2);
+    }
+}
+
+std::string renderValuesJson(const ElementValues &values, const std::vector<std::string> &elements)
+{
+    std::string out;
+    appendValuesJson(out, values, elements);
+    return out;
+}
+
+void appendValuesJson(std::string &out,
+                      const ElementValues &values,
+                      const std::vector<std::string> &elements,
+                      const std::vector<std::string> &fields)
+{
+    if (!fields.empty())
+    {
+        out += "[";
+        bool first = true;
+        for (const auto &val : values)
+        {
+            if (!elements.empty() && std::find(elements.begin(), elements.end(), val.element.name) == elements.end())
+            {
+                continue;
+            }
+            if (!first)
+            {
+                out += ",";
+            }
+            first = false;
+            ObjectWriter object(out, fields);
+            object.string("name", val.element.name);
+            object.string("type", toString(val.element.type));
+            object.number("size", val.rawValue.size());
+            if (object.member("locked"))
+            {
+                out += val.locked ? "true" : "false";
+            }
+            if (object.member("bytes"))
+            {
+                out += "\"";
+                appendHex(out, val.rawValue.data(), val.rawValue.size());
+                out += "\"";
+            }
+            object.finish();
+        }
+        out += "]";
+        return;
+    }
+
+    // Unprojected: the common case, written without per-member checks.
+    out += "[";
+    bool first = true;
+    for (const auto &val : values)
+    {
+        if (!elements.empty() && std::find(elements.begin(), elements.end(), val.element.name) == elements.end())
+        {
+            continue;
+        }
+        if (!first)
+        {
+            out += ",";
+        }
+        first = false;
+        out += "{\"name\":\"";
+        out += jsonEscape(val.element.name);
+        out += "\",\"type\":\"";
+        out += toString(val.element.type);
+        out += "\",\"size\":";
+        out += std::to_string(val.rawValue.size());
+        out += val.locked ? ",\"locked\":true,\"bytes\":\"" : ",\"locked\":false,\"bytes\":\"";
+        appendHex(out, val.rawValue.data(), val.rawValue.size());
+        out += "\"}";
+    }
+    out += "]";
+}
+
+RenderCache::RenderCache()
+{
+    // Tells this process's ETags apart from an earlier run that reached the same versions.
+    const auto now = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    uint8_t bytes[sizeof(now)];
+    std::memcpy(bytes, &now, sizeof(now));
+    appendHex(instance_, bytes, sizeof(bytes));
+}
+
+template <typename Telegram>
+std::string RenderCache::listEtag(const std::vector<Telegram> &telegrams) const
+{
+    // Any change stamps a version above every earlier one, so the newest version and the
+    // count identify the list's state.
+    uint64_t newest = 0;
+    for (const auto &telegram : telegrams)
+    {
+        newest = std::max(newest, telegram.version);
+    }
+    return "\"" + instance_ + "-" + std::to_string(telegrams.size()) + "-" + std::to_string(newest) + "\"";
+}
+
+template <typename Telegram, typename RenderFn>
+void RenderCache::refresh(Section &section, const std::vector<Telegram> &telegrams, RenderFn renderFragment)
+{
+    section.fragments.resize(telegrams.size());
+    for (std::size_t i = 0; i < telegrams.size(); ++i)
+    {
+        auto &fragment = section.fragments[i];
+        if (!fragment.valid || fragment.version != telegrams[i].version)
+        {
+            fragment.json.clear();
+            renderFragment(fragment.json, i, telegrams[i]);
+            fragment.version = telegrams[i].version;
+            fragment.valid = true;
+        }
+    }
+}
+
+template <typename Telegram, typename RenderFn>
+const std::string &RenderCache::assemble(Section &section,
+                                         const std::vector<Telegram> &telegrams,
+                                         std::string etag,
+                                         const char *key,
+                                         RenderFn renderFragment)
+{
+    if (etag == section.etag)
+    {
+        return section.document;
+    }
+    refresh(section, telegrams, renderFragment);
+
+    std::size_t total = 0;
+    for (const auto &fragment : section.fragments)
+    {
+        total += fragment.json.size() + 1;
+    }
+    auto &document = section.document;
+    document.clear();
+    document.reserve(total + 32);
+    document += "{\"";
+    document += key;
+    document += "\":[";
+    for (std::size_t i = 0; i < section.fragments.size(); ++i)
+    {
+        if (i > 0)
+        {
+            document += ",";
+        }
+        document += section.fragments[i].json;
+    }
+    document += "]}";
+    section.etag = std::move(etag);
+    return document;
+}
+
+template <typename Telegram, typename RenderFn, typename ProjectFn>
+std::string RenderCache::page(Section &section,
+                              const std::vector<Telegram> &telegrams,
+                              const char *key,
+                              const ListQuery &query,
+                              RenderFn renderFragment,
+                              ProjectFn renderProjected)
+{
+    const bool projected = !query.fields.empty() || !query.valueFields.empty();
+    if (!projected)
+    {
+        refresh(section, telegrams, renderFragment);
+    }
+
+    std::string out = "{\"";
+    out += key;
+    out += "\":[";
+    std::size_t total = 0;
+    std::size_t emitted = 0;
+    std::size_t next = telegrams.size();
+    for (std::size_t i = 0; i < telegrams.size(); ++i)
+    {
+        if (!matches(query, telegrams[i]))
+        {
+            continue;
+        }
+        ++total;
+        if (i < query.cursor || next != telegrams.size())
+        {
+            continue;
+        }
+        if (query.limit != 0 && emitted == query.limit)
+        {
+            next = i;
+            continue;
+        }
+        if (emitted++ > 0)
+        {
+            out += ",";
+        }
+        if (projected)
+        {
+            renderProjected(out, i, telegrams[i]);
+        }
+        else
+        {
+            out += section.fragments[i].json;
+        }
+    }
+    out += "],\"total\":" + std::to_string(total);
+    if (next != telegrams.size())
+    {
+        out += ",\"nextCursor\":\"" + std::to_string(next) + "\"";
+    }
+    out += "}";
+    return out;
+}
+
+std::string renderStatsJson(const PdEngine &pd, const MdEngine &md, std::chrono::steady_clock::time_point now)
+{
+    const std::vector<std::string> all;
+    std::string out = "{\"publish\":[";
+    for (std::size_t i = 0; i < pd.publishTelegrams().size(); ++i)
+    {
+        const auto &stats = pd.publishStats()[i];
+        out += i == 0 ? "" : ",";
+        ObjectWriter object(out, all);
+        object.number("index", i);
+        object.number("comId", pd.publishTelegrams()[i].comId);
+        appendStatsMembers(object, out, stats, now);
+        object.member("sendJitter");
+        appendHistogramJson(out, stats.sendJitter.snapshot(), stats.sendJitter.maxUs());
+        object.finish();
+    }
+    out += "],\"subscribe\":[";
+    for (std::size_t i = 0; i < pd.subscribeTelegrams().size(); ++i)
+    {
+        const auto &stats = pd.subscribeStats()[i];
+        out += i == 0 ? "" : ",";
+        ObjectWriter object(out, all);
+        object.number("index", i);
+        object.number("comId", pd.subscribeTelegrams()[i].comId);
+        appendStatsMembers(object, out, stats, now);
+        object.member("timedOut");
+        out += stats.timedOut ? "true" : "false";
+        object.member("interArrival");
+        appendHistogramJson(out, stats.interArrival.snapshot(), stats.interArrival.maxUs());
+        object.finish();
+    }
+    out += "],\"md\":[";
+    for (std::size_t i = 0; i < md.templates().size(); ++i)
+    {
+        const auto &stats = md.templateStats()[i];
+        out += i == 0 ? "" : ",";
+        ObjectWriter object(out, all);
+        object.string("name", md.templates()[i].name);
+        object.number("comId", md.templates()[i].comId);
+        appendStatsMembers(object, out, stats, now);
+        object.member("interArrival");
+        appendHistogramJson(out, stats.interArrival.snapshot(), stats.interArrival.maxUs());
+        object.finish();
+    }
+    out += "]}\n";
+    return out;
+}
+
+std::string RenderCache::publishEtag(const PdEngine &pd) const
+{
+    return listEtag(pd.publishTelegrams());
+}
+
+const std::string &RenderCache::publishJson(const PdEngine &pd)
+{
+    return assemble(publish_, pd.publishTelegrams(), publishEtag(pd), "publish",
+                    [](std::string &out, std::size_t index, const PdPublishTelegram &pub) {
+                        appendPublishFragment(out, index, pub);
+                    });
+}
+
+std::string RenderCache::publishJson(const PdEngine &pd, const ListQuery &query)
+{
+    return page(
+        publish_, pd.publishTelegrams(), "publish", query,
+        [](std::string &out, std::size_t index, const PdPublishTelegram &pub) { appendPublishFragment(out, index, pub); },
+        [&](std::string &out, std::size_t index, const PdPublishTelegram &pub) {
+            appendPublishFragment(out, index, pub, query.fields, query.valueFields);
+        });
+}
+
+std::string RenderCache::mdEtag(const MdEngine &md) const
+{
+    return listEtag(md.templates());
+}
+
+const std::string &RenderCache::mdJson(const MdEngine &md)
+{
+    return assemble(md_, md.templates(), mdEtag(md), "templates",
+                    [](std::string &out, std::size_t, const MdTemplate &tpl) { appendMdFragment(out, tpl); });
+}
+
+std::string RenderCache::mdJson(const MdEngine &md, const ListQuery &query)
+{
+    return page(
+        md_, md.templates(), "templates", query,
+        [](std::string &out, std::size_t, const MdTemplate &tpl) { appendMdFragment(out, tpl); },
+        [&](std::string &out, std::size_t, const MdTemplate &tpl) {
+            appendMdFragment(out, tpl, query.fields, query.valueFields);
+        });
+}
+
+std::string RenderCache::telegramEtag(uint64_t version) const
+{
+    return "\"" + instance_ + "-" + std::to_string(version) + "\"";
+}
+
+bool etagMatches(const std::string &ifNoneMatch, const std::string &etag)
+{
+    std::size_t start = 0;
+    while (start < ifNoneMatch.size())
+    {
+        auto end = ifNoneMatch.find(',', start);
+        if (end == std::string::npos)
+        {
+            end = ifNoneMatch.size();
+        }
+        auto candidate = ifNoneMatch.substr(start, end - start);
+        candidate.erase(0, candidate.find_first_not_of(" \t"));
+        candidate.erase(candidate.find_last_not_of(" \t") + 1);
+        if (candidate.compare(0, 2, "W/") == 0)
+        {
+            candidate.erase(0, 2); // weak comparison is fine for GET
+        }
+        if (candidate == "*" || candidate == etag)
+        {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+} // namespace trdp
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "trdp/dataset.hpp"
+#include "trdp/md.hpp"
+#include "trdp/pd.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trdp
+{
+
+/** Lower-case hex, two digits per byte, via a 256-entry lookup table. */
+std::string toHex(const std::vector<uint8_t> &data);
+void appendHex(std::string &out, const uint8_t *data, std::size_t size);
+
+/**
+ * JSON array describing each element's state. With a non-empty element list only those
+ * elements are rendered; with a non-empty field list only those members (name, type, size,
+ * locked, bytes) of each element.
+ */
+std::string renderValuesJson(const ElementValues &values, const std::vector<std::string> &elements = {});
+void appendValuesJson(std::string &out,
+                      const ElementValues &values,
+                      const std::vector<std::string> &elements = {},
+                      const std::vector<std::string> &fields = {});
+
+/**
+ * GET /api/stats: counters, age of the last reception and histogram buckets of every
+ * telegram. Rendered on demand; callers hold the engine lock.
+ */
+std::string renderStatsJson(const PdEngine &pd, const MdEngine &md, std::chrono::steady_clock::time_point now);
+
+/** Filter, projection and page for the list endpoints; empty members mean no restriction. */
+struct ListQuery
+{
+    std::vector<uint32_t> comIds;
+    std::vector<uint16_t> datasetIds;
+    std::vector<std::string> destinations;
+    std::vector<std::string> fields;      // top-level members to keep; "values" keeps the element array
+    std::vector<std::string> valueFields; // members to keep for each element inside "values"
+    std::size_t cursor{0};                // list index to resume from, as returned in nextCursor
+    std::size_t limit{0};                 // 0: no limit
+};
+
+/**
+ * Pre-rendered JSON for GET /api/pd/publish and /api/md/templates. Each telegram's fragment is
+ * kept with the version it was rendered at and only re-rendered after that telegram changed;
+ * the assembled document is kept until any fragment changes. ETags combine a per-process
+ * token with the newest version in the list, so they also change across restarts and
+ * reloads. Not thread-safe: callers hold the engine lock.
+ */
+class RenderCache
+{
+public:
+    RenderCache();
+
+    /** Current ETag of the publish list; cheap enough to answer If-None-Match without rendering. */
+    std::string publishEtag(const PdEngine &pd) const;
+    const std::string &publishJson(const PdEngine &pd);
+    /**
+     * One page of the filtered, projected list, with the number of matching telegrams and the
+     * cursor of the next page. Unprojected pages reuse the cached fragments.
+     */
+    std::string publishJson(const PdEngine &pd, const ListQuery &query);
+
+    std::string mdEtag(const MdEngine &md) const;
+    const std::string &mdJson(const MdEngine &md);
+    std::string mdJson(const MdEngine &md, const ListQuery &query);
+
+    /** ETag for a single telegram's state, e.g. for its payload. */
+    std::string telegramEtag(uint64_t version) const;
+
+private:
+    struct Fragment
+    {
+        bool valid{false};
+        uint64_t version{0};
+        std::string json;
+    };
+
+    struct Section
+    {
+        std::vector<Fragment> fragments;
+        std::string etag; // of document, empty until first assembled
+        std::string document;
+    };
+
+    template <typename Telegram>
+    std::string listEtag(const std::vector<Telegram> &telegrams) const;
+    template <typename Telegram, typename RenderFn>
+    void refresh(Section &section, const std::vector<Telegram> &telegrams, RenderFn renderFragment);
+    template <typename Telegram, typename RenderFn, typename ProjectFn>
+    std::string page(Section &section,
+                     const std::vector<Telegram> &telegrams,
+                     const char *key,
+                     const ListQuery &query,
+                     RenderFn renderFragment,
+                     ProjectFn renderProjected);
+    template <typename Telegram, typename RenderFn>
+    const std::string &assemble(Section &section,
+                                const std::vector<Telegram> &telegrams,
+                                std::string etag,
+                                const char *key,
+                                RenderFn renderFragment);
+
+    std::string instance_;
+    Section publish_;
+    Section md_;
+};
+
+/** True if an If-None-Match header value lists etag (or is "*"). */
+bool etagMatches(const std::string &ifNoneMatch, const std::string &etag);
+
+} // namespace trdp
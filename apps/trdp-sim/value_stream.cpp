@@ -0,0 +1,242 @@
+#include "value_stream.hpp"
+
+#include "json.hpp"
+#include "render.hpp"
+
+#include <algorithm>
+
+namespace trdp
+{
+
+namespace
+{
+// How often pending changes are looked for; a client's interval still caps its flush rate.
+constexpr auto kTick = std::chrono::milliseconds(10);
+constexpr auto kHeartbeat = std::chrono::seconds(15);
+
+bool wantsComId(const StreamFilter &filter, uint32_t comId)
+{
+    return filter.comIds.empty() || std::find(filter.comIds.begin(), filter.comIds.end(), comId) != filter.comIds.end();
+}
+
+void appendEvent(std::string &out, const char *type, const std::string &data)
+{
+    out += "event: ";
+    out += type;
+    out += "\ndata: ";
+    out += data;
+    out += "\n\n";
+}
+} // namespace
+
+ValueStreamHub::ValueStreamHub(const TrdpConfig &config, std::mutex &engineMutex)
+    : config_(config), engineMutex_(engineMutex)
+{
+}
+
+ValueStreamHub::~ValueStreamHub()
+{
+    stop();
+}
+
+void ValueStreamHub::start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_)
+    {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void ValueStreamHub::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+    for (auto &client : clients_)
+    {
+        client.stream->close();
+    }
+    clients_.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &client : pending_)
+    {
+        client.stream->close();
+    }
+    pending_.clear();
+    clientCount_ = 0;
+}
+
+void ValueStreamHub::add(std::shared_ptr<HttpStream> stream, StreamFilter filter)
+{
+    Client client;
+    client.stream = std::move(stream);
+    client.filter = std::move(filter);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(client));
+        ++clientCount_;
+    }
+    wake_.notify_all();
+}
+
+std::size_t ValueStreamHub::clientCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return clientCount_;
+}
+
+void ValueStreamHub::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        if (clients_.empty())
+        {
+            wake_.wait(lock, [this]() { return !running_ || !pending_.empty(); });
+        }
+        else
+        {
+            wake_.wait_for(lock, kTick, [this]() { return !running_ || !pending_.empty(); });
+        }
+        if (!running_)
+        {
+            break;
+        }
+        for (auto &client : pending_)
+        {
+            clients_.push_back(std::move(client));
+        }
+        pending_.clear();
+        lock.unlock();
+
+        const auto now = Clock::now();
+        for (auto &client : clients_)
+        {
+            if (now >= client.nextDue && !client.stream->closed())
+            {
+                flush(client, now);
+            }
+        }
+        clients_.erase(std::remove_if(clients_.begin(), clients_.end(),
+                                      [](const Client &client) { return client.stream->closed(); }),
+                       clients_.end());
+
+        lock.lock();
+        clientCount_ = clients_.size() + pending_.size();
+    }
+}
+
+void ValueStreamHub::flush(Client &client, Clock::time_point now)
+{
+    uint64_t revision = 0;
+    std::string events;
+    bool unchanged = false;
+    {
+        std::lock_guard<std::mutex> lock(engineMutex_);
+        unchanged = client.primed && config_.revision == client.seenRevision;
+        if (!unchanged)
+        {
+            events = render(client, revision);
+        }
+    }
+
+    if (unchanged)
+    {
+        if (now - client.lastWrite >= kHeartbeat && client.stream->write(": keepalive\n\n"))
+        {
+            client.lastWrite = now;
+        }
+        return;
+    }
+
+    // Changes that all fall outside the filter count as seen without writing anything.
+    if (events.empty() || client.stream->write(events))
+    {
+        client.seenRevision = revision;
+        client.primed = true;
+        if (events.empty())
+        {
+            return;
+        }
+        client.lastWrite = now;
+    }
+    // A full queue leaves seenRevision alone, so the next flush carries the newer state instead.
+    client.nextDue = now + client.filter.interval;
+}
+
+std::string ValueStreamHub::render(const Client &client, uint64_t &revision) const
+{
+    const auto &filter = client.filter;
+    const auto changed = [&](uint64_t version) { return !client.primed || version > client.seenRevision; };
+    revision = config_.revision;
+
+    std::string out;
+    if (filter.publish)
+    {
+        for (std::size_t i = 0; i < config_.pdPublish.size(); ++i)
+        {
+            const auto &pub = config_.pdPublish[i];
+            if (!changed(pub.version) || !wantsComId(filter, pub.comId))
+            {
+                continue;
+            }
+            const auto values = renderValuesJson(pub.values, filter.elements);
+            if (values == "[]")
+            {
+                continue;
+            }
+            appendEvent(out, "publish",
+                        "{\"index\":" + std::to_string(i) + ",\"comId\":" + std::to_string(pub.comId) +
+                            ",\"version\":" + std::to_string(pub.version) + ",\"values\":" + values + "}");
+        }
+    }
+    if (filter.subscribe)
+    {
+        for (std::size_t i = 0; i < config_.pdSubscribe.size(); ++i)
+        {
+            const auto &sub = config_.pdSubscribe[i];
+            if (!changed(sub.version) || !wantsComId(filter, sub.comId))
+            {
+                continue;
+            }
+            const auto values = renderValuesJson(sub.lastValues, filter.elements);
+            if (values == "[]")
+            {
+                continue;
+            }
+            appendEvent(out, "subscribe",
+                        "{\"index\":" + std::to_string(i) + ",\"comId\":" + std::to_string(sub.comId) +
+                            ",\"version\":" + std::to_string(sub.version) + ",\"values\":" + values + "}");
+        }
+    }
+    if (filter.md)
+    {
+        for (const auto &tpl : config_.mdTemplates)
+        {
+            if (!changed(tpl.version) || !wantsComId(filter, tpl.comId))
+            {
+                continue;
+            }
+            const auto values = renderValuesJson(tpl.values, filter.elements);
+            if (values == "[]")
+            {
+                continue;
+            }
+            appendEvent(out, "md",
+                        "{\"name\":\"" + jsonEscape(tpl.name) + "\",\"comId\":" + std::to_string(tpl.comId) +
+                            ",\"version\":" + std::to_string(tpl.version) + ",\"values\":" + values + "}");
+        }
+    }
+    return out;
+}
+
+} // namespace trdp
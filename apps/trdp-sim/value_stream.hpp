@@ -0,0 +1,81 @@
+#pragma once
+
+#include "http_server.hpp"
+
+#include "trdp/config.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trdp
+{
+
+struct StreamFilter
+{
+    std::vector<uint32_t> comIds;      // empty: every ComId
+    std::vector<std::string> elements; // empty: every element
+    bool publish{true};
+    bool subscribe{true};
+    bool md{true};
+    std::chrono::milliseconds interval{100}; // minimum time between two flushes to the client
+};
+
+/**
+ * Pushes telegram value changes to Server-Sent Events clients. Engines only stamp versions
+ * (see markChanged()); a single thread compares them against what each client last saw and
+ * renders the changed telegrams, at most once per client interval. Changes in between are
+ * coalesced into the latest state, and a client whose stream queue is full simply gets the
+ * newer state on a later flush, so slow clients never hold up the engines.
+ */
+class ValueStreamHub
+{
+public:
+    ValueStreamHub(const TrdpConfig &config, std::mutex &engineMutex);
+    ~ValueStreamHub();
+
+    ValueStreamHub(const ValueStreamHub &) = delete;
+    ValueStreamHub &operator=(const ValueStreamHub &) = delete;
+
+    void start();
+    void stop();
+
+    /** Start streaming to a client; the first flush sends every matching telegram. */
+    void add(std::shared_ptr<HttpStream> stream, StreamFilter filter);
+    std::size_t clientCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Client
+    {
+        std::shared_ptr<HttpStream> stream;
+        StreamFilter filter;
+        uint64_t seenRevision{0};
+        bool primed{false};
+        Clock::time_point nextDue{};
+        Clock::time_point lastWrite{Clock::now()};
+    };
+
+    void run();
+    void flush(Client &client, Clock::time_point now);
+    std::string render(const Client &client, uint64_t &revision) const;
+
+    const TrdpConfig &config_;
+    std::mutex &engineMutex_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<Client> pending_; // added since the last pass, guarded by mutex_
+    std::size_t clientCount_{0};  // guarded by mutex_
+    bool running_{false};
+    std::thread thread_;
+    std::vector<Client> clients_; // stream thread only
+};
+
+} // namespace trdp
@@ -0,0 +1,34 @@
+# trdp_generate_codecs(<target> XML <device.xml> [NAME <basename>] [NAMESPACE <namespace>])
+#
+# Runs trdp-codegen on a device XML at build time and exposes the generated typed dataset
+# codecs as a static library <target>. Consumers include "<basename>.hpp".
+function(trdp_generate_codecs target)
+    cmake_parse_arguments(ARG "" "XML;NAME;NAMESPACE" "" ${ARGN})
+    if(NOT ARG_XML)
+        message(FATAL_ERROR "trdp_generate_codecs(${target}) requires XML <device.xml>")
+    endif()
+    if(NOT ARG_NAME)
+        set(ARG_NAME ${target})
+    endif()
+    string(MAKE_C_IDENTIFIER "${ARG_NAME}" defaultNamespace)
+    if(NOT ARG_NAMESPACE)
+        set(ARG_NAMESPACE ${defaultNamespace})
+    endif()
+
+    get_filename_component(xmlPath "${ARG_XML}" ABSOLUTE)
+    set(outputDir ${CMAKE_CURRENT_BINARY_DIR}/${target})
+    set(header ${outputDir}/${ARG_NAME}.hpp)
+    set(source ${outputDir}/${ARG_NAME}.cpp)
+
+    file(MAKE_DIRECTORY ${outputDir})
+    add_custom_command(
+        OUTPUT ${header} ${source}
+        COMMAND trdp-codegen ${xmlPath} ${outputDir} ${ARG_NAME} ${ARG_NAMESPACE}
+        DEPENDS trdp-codegen ${xmlPath}
+        COMMENT "Generating TRDP dataset codecs from ${ARG_XML}"
+        VERBATIM)
+
+    add_library(${target} STATIC ${source} ${header})
+    target_include_directories(${target} PUBLIC ${outputDir})
+    target_link_libraries(${target} PUBLIC trdp-core)
+endfunction()
@@ -0,0 +1,141 @@
+#include "trdp/config.hpp"
+#include "trdp/dataset.hpp"
+#include "trdp/logging.hpp"
+#include "trdp/tau.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace trdp;
+
+namespace
+{
+
+constexpr int kIterations = 200000;
+constexpr int kSkipped = 77; // SKIP_RETURN_CODE in tests/CMakeLists.txt
+
+/** Reference payloads for one ComId, computed on a single thread before the race starts. */
+struct Case
+{
+    const TauBinding *binding{nullptr};
+    std::vector<uint8_t> host;
+    std::vector<uint8_t> network;
+};
+
+bool prepare(const TauMarshaller &marshaller, const TrdpConfig &config, uint32_t comId, uint16_t datasetId, Case &out)
+{
+    const auto *dataset = config.datasetRegistry.find(datasetId);
+    out.binding = marshaller.binding(comId);
+    if (dataset == nullptr || out.binding == nullptr)
+    {
+        std::cerr << "ComId " << comId << " has no dataset or tau binding" << std::endl;
+        return false;
+    }
+
+    // Distinct non-zero values, so a payload mixed up between threads cannot compare equal.
+    ElementValues values;
+    for (const auto &element : dataset->elements)
+    {
+        ElementValue value{element, {}, false};
+        const auto text = element.type == TrdpType::STRING ? "comid-" + std::to_string(comId)
+                                                            : std::to_string(comId % 100 + values.size() + 1);
+        if (!assignValue(value, text))
+        {
+            return false;
+        }
+        values.push_back(std::move(value));
+    }
+    if (!packDatasetToPayload(*dataset, values, out.host) || !marshaller.marshall(*out.binding, out.host, out.network))
+    {
+        std::cerr << "Cannot build the reference payload for ComId " << comId << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> roundTrip;
+    if (!marshaller.unmarshall(*out.binding, out.network, roundTrip) || roundTrip != out.host)
+    {
+        std::cerr << "Single-threaded round trip differs for ComId " << comId << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * Marshalls on a TX thread while an RX thread unmarshalls, both through the same marshaller and
+ * the caller-buffer API the engines use, and checks every result against the references.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: tau_concurrency_test <device.xml>" << std::endl;
+        return 2;
+    }
+    setLogLevel(LogLevel::Warn);
+
+    const auto marshaller = TauMarshaller::createFromXml(argv[1]);
+    if (!marshaller)
+    {
+        std::cout << "tau marshalling not available (built without TRDP); skipping" << std::endl;
+        return kSkipped;
+    }
+    const auto config = XmlConfigLoader().loadFromDeviceConfig(argv[1], "", "", "");
+    std::vector<Case> cases(2);
+    if (!config || !prepare(*marshaller, *config, 1001, 1001, cases[0]) ||
+        !prepare(*marshaller, *config, 1002, 1002, cases[1]))
+    {
+        return 1;
+    }
+
+    std::atomic<int> failures{0};
+    std::atomic<bool> go{false};
+    std::thread tx([&]() {
+        std::vector<uint8_t> network(2048);
+        while (!go.load())
+        {
+        }
+        for (int i = 0; i < kIterations; ++i)
+        {
+            const auto &c = cases[i % cases.size()];
+            std::size_t size = network.size();
+            if (!marshaller->marshall(*c.binding, c.host.data(), c.host.size(), network.data(), size) ||
+                size != c.network.size() || !std::equal(c.network.begin(), c.network.end(), network.begin()))
+            {
+                failures.fetch_add(1);
+            }
+        }
+    });
+    std::thread rx([&]() {
+        std::vector<uint8_t> host(2048);
+        while (!go.load())
+        {
+        }
+        for (int i = 0; i < kIterations; ++i)
+        {
+            const auto &c = cases[(i + 1) % cases.size()];
+            std::size_t size = host.size();
+            if (!marshaller->unmarshall(*c.binding, c.network.data(), c.network.size(), host.data(), size) ||
+                size != c.host.size() || !std::equal(c.host.begin(), c.host.end(), host.begin()))
+            {
+                failures.fetch_add(1);
+            }
+        }
+    });
+    go.store(true);
+    tx.join();
+    rx.join();
+
+    if (failures.load() != 0)
+    {
+        std::cerr << failures.load() << " of " << 2 * kIterations << " concurrent operations gave a wrong result"
+                  << std::endl;
+        return 1;
+    }
+    std::cout << 2 * kIterations << " concurrent marshall/unmarshall round trips matched" << std::endl;
+    return 0;
+}
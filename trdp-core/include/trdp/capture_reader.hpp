@@ -0,0 +1,86 @@
+#pragma once
+
+#include "packet_capture.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trdp
+{
+
+/** One UDP datagram read from a capture file. payload points into the mapped file. */
+struct CapturedDatagram
+{
+    uint64_t timeNs{0}; // capture timestamp, nanoseconds since the epoch
+    CaptureAddress address;
+    const uint8_t *payload{nullptr};
+    std::size_t size{0};
+};
+
+/**
+ * Reads the IPv4/UDP datagrams of a pcap or pcapng file, in file order. Both byte orders,
+ * microsecond and nanosecond pcap timestamps and any pcapng if_tsresol are understood, on
+ * Ethernet (with VLAN tags), raw IP and Linux cooked captures. Other frames, IP fragments and
+ * datagrams cut short by the snap length are skipped and counted.
+ *
+ * The file is memory-mapped and datagrams are returned in place, so reading costs no copy
+ * and no system call per packet; a payload stays valid until the reader is closed.
+ */
+class CaptureReader
+{
+public:
+    CaptureReader() = default;
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+
+    /** Map the file and check its header; false (with a logged error) if it is not a capture. */
+    bool open(const std::string &path);
+    void close();
+
+    /** The next datagram; false at the end of the file or at a malformed block (logged). */
+    bool next(CapturedDatagram &out);
+
+    /** Link-layer frames read so far and how many of them were not usable datagrams. */
+    uint64_t frames() const { return frames_; }
+    uint64_t skipped() const { return skipped_; }
+    std::size_t fileSize() const { return size_; }
+
+private:
+    enum class Format
+    {
+        Pcap,
+        Pcapng
+    };
+
+    struct Interface
+    {
+        uint16_t linkType{0};
+        uint64_t ticksPerSecond{1000000};
+    };
+
+    uint32_t read32(std::size_t offset) const;
+    uint16_t read16(std::size_t offset) const;
+    bool nextPcap(CapturedDatagram &out);
+    bool nextPcapng(CapturedDatagram &out);
+    bool readInterface(std::size_t body, std::size_t bodySize);
+    bool readSectionHeader(std::size_t offset, std::size_t available);
+    bool decodeFrame(uint16_t linkType, const uint8_t *frame, std::size_t size, CapturedDatagram &out);
+    bool truncated(const char *what);
+
+    const uint8_t *data_{nullptr};
+    std::size_t size_{0};
+    std::size_t offset_{0};
+    std::string path_;
+    Format format_{Format::Pcap};
+    bool swapped_{false};               // file byte order differs from the host's
+    Interface pcapInterface_;           // pcap: the only interface
+    std::vector<Interface> interfaces_; // pcapng: interfaces of the current section
+    uint64_t frames_{0};
+    uint64_t skipped_{0};
+};
+
+} // namespace trdp
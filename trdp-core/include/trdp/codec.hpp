@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace trdp
+{
+namespace codec
+{
+
+// Big-endian load/store helpers used by generated dataset codecs. They are written so
+// that compilers reduce them to a single (byte-swapped) load or store.
+
+inline void storeBe16(uint8_t *out, uint16_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+}
+
+inline void storeBe32(uint8_t *out, uint32_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+inline void storeBe64(uint8_t *out, uint64_t value)
+{
+    storeBe32(out, static_cast<uint32_t>(value >> 32));
+    storeBe32(out + 4, static_cast<uint32_t>(value));
+}
+
+inline uint16_t loadBe16(const uint8_t *in)
+{
+    return static_cast<uint16_t>((static_cast<uint16_t>(in[0]) << 8) | in[1]);
+}
+
+inline uint32_t loadBe32(const uint8_t *in)
+{
+    return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | static_cast<uint32_t>(in[3]);
+}
+
+inline uint64_t loadBe64(const uint8_t *in)
+{
+    return (static_cast<uint64_t>(loadBe32(in)) << 32) | loadBe32(in + 4);
+}
+
+template <typename To, typename From>
+inline To bitCast(const From &from)
+{
+    static_assert(sizeof(To) == sizeof(From), "bitCast requires equally sized types");
+    To to;
+    std::memcpy(&to, &from, sizeof(To));
+    return to;
+}
+
+/**
+ * TRDP TIMEDATE64: seconds and microseconds, each marshalled as a 32 bit big-endian value.
+ */
+struct TimeDate64
+{
+    uint32_t seconds;
+    int32_t microseconds;
+};
+
+} // namespace codec
+} // namespace trdp
@@ -11,6 +11,41 @@ namespace trdp
 {
 
 class TauMarshaller;
+struct TauBinding;
+
+/**
+ * Entry of <com-parameter-list>; telegrams refer to it through com-parameter-id.
+ */
+struct ComParameter
+{
+    uint32_t id{0};
+    uint8_t qos{5};
+    uint8_t ttl{64};
+};
+
+/**
+ * <trdp-process> of the bus interface. Times are in microseconds, as in the XML.
+ */
+struct ProcessSettings
+{
+    uint32_t cycleTimeUs{10000};
+    uint32_t priority{0};
+    bool blocking{false};
+    bool trafficShaping{false};
+};
+
+/**
+ * Defaults from <pd-com-parameter> / <md-com-parameter>, used by telegrams that do not
+ * override them.
+ */
+struct ComDefaults
+{
+    uint16_t port{17224};
+    uint8_t qos{5};
+    uint8_t ttl{64};
+    uint32_t timeoutUs{100000}; // PD timeout-value, MD reply-timeout
+    uint32_t confirmTimeoutUs{0}; // MD only
+};
 
 struct PdPublishTelegram
 {
@@ -18,8 +53,12 @@ struct PdPublishTelegram
     uint16_t datasetId{0};
     std::string destinationIp;
     uint32_t cycleTimeMs{1000};
-    uint32_t priority{3};
+    uint32_t priority{3}; // QoS, 0..7
+    uint8_t ttl{64};
+    uint32_t comParameterId{0};
     ElementValues values;
+    const TauBinding *tauBinding{nullptr}; // owned by TrdpConfig::tauMarshaller
+    uint64_t version{0};                   // TrdpConfig::revision of the last value change
 };
 
 struct PdSubscribeTelegram
@@ -29,7 +68,10 @@ struct PdSubscribeTelegram
     std::string sourceIp;
     std::string destinationIp;
     uint32_t timeoutMs{1000};
+    uint32_t comParameterId{0};
     ElementValues lastValues;
+    const TauBinding *tauBinding{nullptr}; // owned by TrdpConfig::tauMarshaller
+    uint64_t version{0};                   // TrdpConfig::revision of the last value change
 };
 
 enum class MdDirection
@@ -46,20 +88,55 @@ struct MdTemplate
     MdDirection direction{MdDirection::Request};
     uint32_t comId{0};
     uint16_t datasetId{0};
+    std::string sourceIp;
     std::string destinationIp;
     uint16_t destinationPort{0u};
+    uint32_t replyTimeoutUs{0};
+    uint32_t confirmTimeoutUs{0};
+    uint8_t qos{3}; // from com-parameter-id, else the MD defaults
+    uint8_t ttl{64};
+    uint32_t comParameterId{0};
     ElementValues values;
+    const TauBinding *tauBinding{nullptr}; // owned by TrdpConfig::tauMarshaller
+    uint64_t version{0};                   // TrdpConfig::revision of the last value change
+
+    // Network payload for the current values, maintained by MdEngine. Any change to values
+    // must clear wirePayloadValid.
+    std::vector<uint8_t> wirePayload;
+    bool wirePayloadValid{false};
 };
 
 struct TrdpConfig
 {
+    ProcessSettings process;
+    ComDefaults pdDefaults;
+    ComDefaults mdDefaults{17225, 3, 64, 5000000, 1000000};
+    std::vector<ComParameter> comParameters;
     DatasetRegistry datasetRegistry;
     std::vector<PdPublishTelegram> pdPublish;
     std::vector<PdSubscribeTelegram> pdSubscribe;
     std::vector<MdTemplate> mdTemplates;
-    std::shared_ptr<TauMarshaller> tauMarshaller;
+    // Immutable and safe to share across threads; it never uses libtrdp's global tables, so the
+    // marshaller of a reload can be built while this one is in use (see TauMarshaller).
+    std::shared_ptr<const TauMarshaller> tauMarshaller;
+
+    // Advanced on every value change (and once per reload), so a reader that remembers the
+    // revision it last saw can find changed telegrams by comparing their version against it.
+    uint64_t revision{0};
+    // Advanced once per reload; telegram indices cached by a reader are stale once it changes.
+    uint64_t generation{0};
 };
 
+/**
+ * Record a value change on a publish/subscribe telegram or MD template. Callers hold whatever
+ * lock guards the configuration.
+ */
+template <typename Telegram>
+void markChanged(TrdpConfig &config, Telegram &telegram)
+{
+    telegram.version = ++config.revision;
+}
+
 class XmlConfigLoader
 {
 public:
@@ -67,6 +144,13 @@ public:
                                                    const std::string &comIdFile,
                                                    const std::string &pdFile,
                                                    const std::string &mdFile) const;
+
+    /**
+     * Same as loadFromDeviceConfig, but reuses the binary image in cacheFile when it was built
+     * from identical XML, and (re)writes it otherwise. See ConfigCache.
+     */
+    std::optional<TrdpConfig> loadFromDeviceConfigCached(const std::string &deviceFile,
+                                                         const std::string &cacheFile) const;
 };
 
 } // namespace trdp
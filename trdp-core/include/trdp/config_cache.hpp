@@ -0,0 +1,35 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace trdp
+{
+
+/**
+ * FNV-1a 64 bit hash, used to key cached configurations to the exact XML they came from.
+ */
+uint64_t hashBytes(const void *data, std::size_t size);
+
+/**
+ * Compact binary image of a resolved TrdpConfig (process and com settings, datasets, element
+ * layouts, telegrams, MD templates and their current values, with all strings interned into
+ * one table).
+ *
+ * Images are written atomically (temporary file + rename), so many processes can share one
+ * cache path. Loading maps the file read-only and builds the config straight from the mapped
+ * records; any mismatch in magic, version, source hash or bounds is treated as a miss.
+ * The tau marshaller is not part of the image and must be created separately.
+ */
+class ConfigCache
+{
+public:
+    static bool write(const std::string &path, uint64_t sourceHash, const TrdpConfig &config);
+    static std::optional<TrdpConfig> load(const std::string &path, uint64_t sourceHash);
+};
+
+} // namespace trdp
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace trdp
+{
+
+struct ConfigDiff
+{
+    struct Counts
+    {
+        std::size_t added{0};
+        std::size_t removed{0};
+        std::size_t changed{0};
+        std::size_t unchanged{0};
+    };
+
+    Counts datasets;
+    Counts publish;
+    Counts subscribe;
+    Counts md;
+
+    // For each telegram of the new configuration, the index of the unchanged telegram it
+    // replaces in the old one, or kNoMatch when it was added or changed.
+    static constexpr std::size_t kNoMatch = static_cast<std::size_t>(-1);
+    std::vector<std::size_t> publishFrom;
+    std::vector<std::size_t> subscribeFrom;
+    std::vector<std::size_t> mdFrom;
+
+    std::string summary() const;
+};
+
+/**
+ * Compare two configurations. Publish telegrams are matched by ComId and destination,
+ * subscriptions by ComId, source and destination, MD templates by name and datasets by id.
+ */
+ConfigDiff diffConfigs(const TrdpConfig &live, const TrdpConfig &next);
+
+/**
+ * Replace live with next, carrying element values and locks over from matching telegrams.
+ * Values are kept per element name as long as the element keeps its type and size, so a
+ * telegram whose dataset gained or lost elements still keeps the values that survived.
+ * The caller must hold whatever lock guards the engines using live.
+ */
+ConfigDiff applyConfig(TrdpConfig &live, TrdpConfig next);
+
+/**
+ * Loads a device XML on a background thread and hands the result over at the next cycle
+ * boundary, so traffic keeps flowing while the new file is parsed.
+ */
+class ConfigReloader
+{
+public:
+    ConfigReloader(std::string deviceFile, std::string cacheFile = {});
+
+    /**
+     * Start loading deviceFile (or the last loaded file if empty). Returns false if a reload
+     * is already in progress.
+     */
+    bool request(const std::string &deviceFile = {});
+
+    /** True once a requested load has finished and applyPending() has work to do. */
+    bool ready() const;
+
+    /**
+     * Swap in a finished load. Returns the applied diff, or nothing if no load was ready or
+     * it failed (the live configuration is kept in that case).
+     */
+    std::optional<ConfigDiff> applyPending(TrdpConfig &live);
+
+    bool busy() const;
+    std::string deviceFile() const;
+    std::string lastResult() const;
+
+private:
+    std::string cacheFile_;
+    mutable std::mutex mutex_;
+    std::string deviceFile_;
+    std::string pendingFile_;
+    std::future<std::optional<TrdpConfig>> pending_;
+    std::string lastResult_;
+};
+
+} // namespace trdp
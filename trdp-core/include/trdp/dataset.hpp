@@ -42,18 +42,42 @@ struct ElementValue
 
 using ElementValues = std::vector<ElementValue>;
 
+/**
+ * One change in a batch: a new value, a lock change, or both. An unlock takes effect before the
+ * value and a lock after it, so one update can unlock and change an element, or change and lock it.
+ */
+struct ElementUpdate
+{
+    std::string element;
+    std::optional<std::string> value;
+    std::optional<bool> locked;
+};
+
 // Helpers
 std::size_t expectedSize(const DatasetElementDef &def);
 bool assignValue(ElementValue &value, const std::string &input);
+/**
+ * Apply updates in order. Stops at the first one that names an unknown element or whose value
+ * is rejected, describing it in reason; earlier updates stay applied, so work on a copy when
+ * the batch must be all-or-nothing.
+ */
+bool applyUpdates(ElementValues &values, const std::vector<ElementUpdate> &updates, std::string &reason);
 bool packDatasetToPayload(const DatasetDef &dataset, const ElementValues &values, std::vector<uint8_t> &outBuffer);
 bool unpackPayloadToDataset(const DatasetDef &dataset, const std::vector<uint8_t> &payload, ElementValues &outValues);
 
+// Buffer variants for caller-owned memory. Packing fails if outSize is below dataset.payloadSize().
+bool packDatasetToPayload(const DatasetDef &dataset, const ElementValues &values, uint8_t *out, std::size_t outSize);
+bool unpackPayloadToDataset(const DatasetDef &dataset, const uint8_t *payload, std::size_t payloadSize, ElementValues &outValues);
+
 class DatasetRegistry
 {
 public:
     void add(DatasetDef def);
     const DatasetDef *find(uint16_t datasetId) const;
     std::vector<DatasetDef> list() const;
+    std::size_t size() const { return datasets_.size(); }
+    bool empty() const { return datasets_.empty(); }
+    void reserve(std::size_t count) { datasets_.reserve(count); }
 
 private:
     std::unordered_map<uint16_t, DatasetDef> datasets_;
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace trdp
+{
+
+enum class FlightEventKind : uint8_t
+{
+    PdSend,
+    PdReceive,
+    PdTimeout,
+    MdSend,
+    MdReceive
+};
+
+const char *toString(FlightEventKind kind);
+
+/**
+ * One recorded event, exactly one cache line. Payloads are kept as their size, a 32-bit
+ * hash of all bytes (flightPayloadHash) and the first kPayloadPrefix bytes.
+ */
+struct alignas(64) FlightEvent
+{
+    static constexpr std::size_t kPayloadPrefix = 32;
+
+    std::atomic<uint64_t> stamp{0}; // position + 1 once written, 0 while empty or being written
+    int64_t timeNs{0};               // system clock, nanoseconds since the epoch
+    uint32_t comId{0};
+    uint32_t sequence{0};            // MD sequence counter; per-telegram send/receive count for PD
+    FlightEventKind kind{FlightEventKind::PdSend};
+    uint8_t failed{0};               // the payload could not be applied or sent
+    uint16_t payloadSize{0};         // full size, saturated at 65535
+    uint32_t payloadHash{0};
+    uint8_t payload[kPayloadPrefix]{};
+};
+
+static_assert(sizeof(FlightEvent) == 64, "FlightEvent must fill exactly one cache line");
+
+/**
+ * Fixed-size ring of the most recent PD/MD events for post-mortem analysis. Recording claims
+ * a slot with one atomic increment and fills one cache line, so it can stay enabled at full
+ * rate; the oldest events are overwritten. Any thread may record and dump concurrently: a
+ * slot overwritten while it is being dumped is left out of the dump.
+ *
+ * Dump format (little-endian, as written by the host): a 32-byte header
+ *     char magic[8] = "TRDPFLT1", uint32 recordSize = 64, uint32 count, uint64 firstPosition,
+ *     uint64 reserved
+ * followed by count records, oldest first, laid out like FlightEvent with the stamp holding
+ * the event's position.
+ */
+class FlightRecorder
+{
+public:
+    /** Capacity is rounded up to a power of two. */
+    explicit FlightRecorder(std::size_t capacity = 65536);
+
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+    void record(FlightEventKind kind,
+                uint32_t comId,
+                uint32_t sequence,
+                const uint8_t *payload,
+                std::size_t size,
+                bool failed = false);
+
+    std::size_t capacity() const { return mask_ + 1; }
+    /** Events recorded since start, including overwritten ones. */
+    uint64_t recorded() const { return next_.load(std::memory_order_relaxed); }
+
+    /** The retained events in dump format. */
+    std::string dump() const;
+    /** Write dump() to path; false (with a logged error) if the file cannot be written. */
+    bool dumpToFile(const std::string &path) const;
+
+    /** Human-readable listing of the newest events, oldest first. */
+    void print(std::ostream &os, std::size_t newest) const;
+
+private:
+    std::unique_ptr<FlightEvent[]> events_;
+    std::size_t mask_;
+    std::atomic<uint64_t> next_{0};
+};
+
+/** Non-cryptographic 32-bit hash of a payload, as stored in FlightEvent::payloadHash. */
+uint32_t flightPayloadHash(const uint8_t *data, std::size_t size);
+
+} // namespace trdp
@@ -1,38 +1,235 @@
 #pragma once
 
+#include <atomic>
+#include <charconv>
 #include <chrono>
-#include <ctime>
-#include <iomanip>
-#include <iostream>
-#include <sstream>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Lowest level compiled in: 0 debug, 1 info, 2 warn, 3 error, 4 none. Calls below it format
+ * nothing; only arguments that are themselves expressions (e.g. a std::string built with +) are
+ * still evaluated. Set through the TRDP_LOG_MIN_LEVEL CMake cache variable.
+ */
+#ifndef TRDP_LOG_MIN_LEVEL
+#define TRDP_LOG_MIN_LEVEL 0
+#endif
 
 namespace trdp
 {
 
-inline std::string timeStamp()
+enum class LogLevel : uint8_t
 {
-    const auto now = std::chrono::system_clock::now();
-    const std::time_t t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm{};
-#ifdef _WIN32
-    localtime_s(&tm, &t);
-#else
-    localtime_r(&t, &tm);
-#endif
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-    return oss.str();
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+constexpr LogLevel kMinLogLevel = static_cast<LogLevel>(TRDP_LOG_MIN_LEVEL);
+
+/** Runtime threshold on top of kMinLogLevel; Info by default. */
+void setLogLevel(LogLevel level);
+LogLevel logLevel();
+/** "debug", "info", "warn", "error" or "off". */
+std::optional<LogLevel> parseLogLevel(const std::string &name);
+const char *toString(LogLevel level);
+
+/** Block until every message logged so far has been written. */
+void flushLog();
+
+/**
+ * A call site whose repeated messages are summarised instead of written every time. The first
+ * occurrence of each distinct message is written; identical ones within the interval are only
+ * counted and reported as one "repeated N times" line when the interval is over. Declare it
+ * static next to the call:
+ *
+ *     static LogSite fallbackSite("pd.marshall-fallback");
+ *     warn(fallbackSite, "tau_marshall failed for ComId ", comId);
+ *
+ * Up to 32 distinct messages are told apart per site; beyond that they share one slot.
+ */
+class LogSite
+{
+public:
+    explicit LogSite(const char *name, std::chrono::milliseconds interval = std::chrono::seconds(10));
+    ~LogSite();
+
+    LogSite(const LogSite &) = delete;
+    LogSite &operator=(const LogSite &) = delete;
+
+    const char *name() const { return name_; }
+
+    /** Count one formatted message; true if it should be written now. */
+    bool admit(LogLevel level, const std::string &text);
+
+    /** Write the summaries whose interval is over (all pending ones if force). */
+    void flushSummaries(std::chrono::steady_clock::time_point now, bool force = false);
+
+    struct MessageStats
+    {
+        std::string message;
+        uint64_t occurrences{0};
+        uint64_t suppressed{0};
+    };
+    std::vector<MessageStats> stats() const;
+
+private:
+    struct Entry
+    {
+        uint64_t hash{0};
+        std::string text;
+        LogLevel level{LogLevel::Warn};
+        uint64_t occurrences{0};
+        uint64_t suppressed{0};
+        uint64_t pending{0}; // suppressed since the last line written for this message
+        std::chrono::steady_clock::time_point lastWrite{};
+    };
+
+    const char *name_;
+    std::chrono::milliseconds interval_;
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
+
+struct LogSiteStats
+{
+    std::string site;
+    std::vector<LogSite::MessageStats> messages;
+};
+
+/** Counts of every LogSite that has been reached so far. */
+std::vector<LogSiteStats> logSiteStats();
+
+namespace detail
+{
+extern std::atomic<uint8_t> runtimeLogLevel;
+
+/** Queue one formatted line on the calling thread's ring; written by the log thread. */
+void submitLog(LogLevel level, const char *text, std::size_t size);
+
+inline void appendLogPart(std::string &out, const std::string &part) { out += part; }
+inline void appendLogPart(std::string &out, const char *part) { out += part; }
+inline void appendLogPart(std::string &out, char part) { out += part; }
+
+template <typename T>
+std::enable_if_t<std::is_arithmetic<T>::value || std::is_enum<T>::value> appendLogPart(std::string &out, T part)
+{
+    char text[32];
+    if constexpr (std::is_enum<T>::value)
+    {
+        appendLogPart(out, static_cast<std::underlying_type_t<T>>(part));
+    }
+    else if constexpr (std::is_same<T, bool>::value)
+    {
+        out += part ? "true" : "false";
+    }
+    else if constexpr (std::is_integral<T>::value)
+    {
+        const auto result = std::to_chars(text, text + sizeof(text), part);
+        out.append(text, result.ptr);
+    }
+    else
+    {
+        const int size = std::snprintf(text, sizeof(text), "%g", static_cast<double>(part));
+        out.append(text, static_cast<std::size_t>(size));
+    }
 }
 
-inline void log(const std::string &level, const std::string &message)
+template <LogLevel Level, typename... Parts>
+void logParts(const Parts &...parts)
 {
-    std::cout << "[" << timeStamp() << "] " << level << ": " << message << std::endl;
+    if constexpr (Level >= kMinLogLevel)
+    {
+        if (static_cast<uint8_t>(Level) < runtimeLogLevel.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        // Reused per thread, so steady-state logging does not allocate.
+        thread_local std::string line;
+        line.clear();
+        (appendLogPart(line, parts), ...);
+        submitLog(Level, line.data(), line.size());
+    }
 }
 
-inline void info(const std::string &message) { log("INFO", message); }
-inline void warn(const std::string &message) { log("WARN", message); }
-inline void error(const std::string &message) { log("ERROR", message); }
+template <LogLevel Level, typename... Parts>
+void logParts(LogSite &site, const Parts &...parts)
+{
+    if constexpr (Level >= kMinLogLevel)
+    {
+        if (static_cast<uint8_t>(Level) < runtimeLogLevel.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        thread_local std::string line;
+        line.clear();
+        (appendLogPart(line, parts), ...);
+        if (site.admit(Level, line))
+        {
+            submitLog(Level, line.data(), line.size());
+        }
+    }
+}
+} // namespace detail
 
-} // namespace trdp
+inline bool logEnabled(LogLevel level)
+{
+    return level >= kMinLogLevel && static_cast<uint8_t>(level) >= detail::runtimeLogLevel.load(std::memory_order_relaxed);
+}
 
+/**
+ * Log the concatenation of parts (strings, characters and numbers). Pass pieces rather than a
+ * string built with +: pieces are only formatted when the level is enabled, a built string
+ * always costs its allocations.
+ */
+template <typename... Parts>
+void debug(const Parts &...parts)
+{
+    detail::logParts<LogLevel::Debug>(parts...);
+}
+
+template <typename... Parts>
+void info(const Parts &...parts)
+{
+    detail::logParts<LogLevel::Info>(parts...);
+}
+
+template <typename... Parts>
+void warn(const Parts &...parts)
+{
+    detail::logParts<LogLevel::Warn>(parts...);
+}
+
+template <typename... Parts>
+void error(const Parts &...parts)
+{
+    detail::logParts<LogLevel::Error>(parts...);
+}
+
+/** As above, but repeats are summarised per site (see LogSite). */
+template <typename... Parts>
+void info(LogSite &site, const Parts &...parts)
+{
+    detail::logParts<LogLevel::Info>(site, parts...);
+}
+
+template <typename... Parts>
+void warn(LogSite &site, const Parts &...parts)
+{
+    detail::logParts<LogLevel::Warn>(site, parts...);
+}
+
+template <typename... Parts>
+void error(LogSite &site, const Parts &...parts)
+{
+    detail::logParts<LogLevel::Error>(site, parts...);
+}
+
+} // namespace trdp
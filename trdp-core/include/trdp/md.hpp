@@ -1,29 +1,98 @@
 #pragma once
 
 #include "config.hpp"
+#include "flight_recorder.hpp"
+#include "md_transport.hpp"
+#include "telegram_stats.hpp"
 
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
 
 namespace trdp
 {
 
+struct ConfigDiff;
+
 class MdEngine
 {
 public:
     explicit MdEngine(TrdpConfig &config);
 
     void listTemplates(std::ostream &os) const;
+    void listStats(std::ostream &os, std::chrono::steady_clock::time_point now) const;
     bool setTemplateValue(const std::string &name, const std::string &element, const std::string &value);
     bool clearTemplate(const std::string &name);
-    bool sendTemplate(const std::string &name, std::ostream &os) const;
+    /** Send a template; updates its cached payload and statistics, so hold the engine lock. */
+    bool sendTemplate(const std::string &name, std::ostream &os);
     bool setTemplateLock(const std::string &name, const std::string &element, bool locked);
 
+    /**
+     * Swap in a full set of values for a template, e.g. a copy staged with applyUpdates().
+     * Fails for an unknown name or a value list that does not match the template's elements.
+     */
+    bool replaceTemplateValues(const std::string &name, ElementValues values);
+
+    /**
+     * Pack (and marshall, if available) every template's current values once, so sending an
+     * untouched template does no packing work. Called on construction; call again after the
+     * configuration was reloaded.
+     */
+    void preparePayloads();
+
+    /**
+     * Network payload of a template as it would be sent, packing it first if its values
+     * changed. Returns false for an unknown name.
+     */
+    bool templatePayload(const std::string &name, std::vector<uint8_t> &out);
+
+    /**
+     * Replace a template's values with a complete network payload, e.g. one captured on the
+     * wire. The size must equal the template's current payload size; locked elements keep
+     * their values.
+     */
+    bool setTemplatePayload(const std::string &name, const uint8_t *networkPayload, std::size_t size);
+
+    /**
+     * Route sendTemplate() through a UDP transport. Without one, sends are only reported.
+     */
+    void attachTransport(std::shared_ptr<MdTransport> transport) { transport_ = std::move(transport); }
+    std::shared_ptr<MdBufferPool> bufferPool() const { return pool_; }
+
+    /** Record sent and received frames in a flight recorder; null detaches it. */
+    void attachRecorder(std::shared_ptr<FlightRecorder> recorder) { recorder_ = std::move(recorder); }
+
+    /**
+     * Apply a received frame to the first template with a matching ComId that receives its message
+     * type: requests and notifies go to Reply templates, replies to Confirm templates, and no frame
+     * overwrites a template of the kind it is. Locked elements are left untouched. Returns false if
+     * no template matches or the dataset cannot be decoded.
+     */
+    bool handleFrame(MdFrame &frame);
+
+    /** Runtime statistics, indexed like templates(). Read them under the same lock. */
+    const std::vector<TelegramStats> &templateStats() const { return templateStats_; }
+
+    /** Zero the statistics and size them to the current templates. */
+    void resetStats();
+    /** After a reload: keep the statistics of unchanged templates, zero added and changed ones. */
+    void carryStats(const ConfigDiff &diff);
+
     const std::vector<MdTemplate> &templates() const { return config_.mdTemplates; }
     const DatasetRegistry &datasets() const { return config_.datasetRegistry; }
 
 private:
+    const std::vector<uint8_t> &wirePayload(MdTemplate &tpl);
+    bool decodePayload(MdTemplate &tpl, const uint8_t *networkPayload, std::size_t size);
+    TelegramStats &statsFor(const MdTemplate &tpl);
+
     TrdpConfig &config_;
+    std::shared_ptr<MdBufferPool> pool_;
+    std::shared_ptr<MdTransport> transport_;
+    std::shared_ptr<FlightRecorder> recorder_;
+    std::vector<TelegramStats> templateStats_;
+    std::atomic<uint32_t> sequenceCounter_{0};
 };
 
 } // namespace trdp
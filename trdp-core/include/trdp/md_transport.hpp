@@ -0,0 +1,128 @@
+#pragma once
+
+#include "packet_capture.hpp"
+#include "wire.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trdp
+{
+
+/**
+ * Pool of reusable byte buffers for MD payloads. Buffers keep their capacity between
+ * uses so large messages do not hit the allocator once the pool is warm. Leased buffers
+ * keep whatever size they were returned with; callers resize as needed.
+ * The pool must outlive every lease taken from it.
+ */
+class MdBufferPool
+{
+public:
+    class Lease
+    {
+    public:
+        Lease() = default;
+        Lease(MdBufferPool *pool, std::unique_ptr<std::vector<uint8_t>> buffer);
+        ~Lease();
+
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) noexcept;
+
+        std::vector<uint8_t> &operator*() { return *buffer_; }
+        std::vector<uint8_t> *operator->() { return buffer_.get(); }
+        const std::vector<uint8_t> &operator*() const { return *buffer_; }
+        const std::vector<uint8_t> *operator->() const { return buffer_.get(); }
+        explicit operator bool() const { return buffer_ != nullptr; }
+
+    private:
+        void release();
+
+        MdBufferPool *pool_{nullptr};
+        std::unique_ptr<std::vector<uint8_t>> buffer_;
+    };
+
+    explicit MdBufferPool(std::size_t bufferCapacity = kMdMaxDataSize);
+
+    Lease acquire();
+    std::size_t idleCount() const;
+
+private:
+    void giveBack(std::unique_ptr<std::vector<uint8_t>> buffer);
+
+    std::size_t bufferCapacity_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> idle_;
+};
+
+struct MdFrame
+{
+    MdHeader header;
+    MdBufferPool::Lease body; // dataset bytes start at body->data(); the buffer may be larger
+    std::size_t datasetSize{0};
+    std::string sourceIp;
+    uint16_t sourcePort{0};
+};
+
+/**
+ * UDP transport for MD frames. Frames are sent as a gather list of header, dataset and
+ * padding with a single sendmsg(), and received with a scatter read that places the
+ * dataset straight into a pooled buffer.
+ */
+class MdTransport
+{
+public:
+    /**
+     * Received datasets go into buffers from pool, which are kept at the full datagram size
+     * so a receive never zero-fills them again. Do not share it with pools whose users
+     * clear() or shrink their buffers.
+     */
+    explicit MdTransport(std::shared_ptr<MdBufferPool> pool = std::make_shared<MdBufferPool>(kMdMaxDataSize + 4u));
+    ~MdTransport();
+
+    MdTransport(const MdTransport &) = delete;
+    MdTransport &operator=(const MdTransport &) = delete;
+
+    bool open(const std::string &localIp, uint16_t port);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+    uint16_t localPort() const { return localPort_; }
+
+    /**
+     * Apply TRDP QoS (0..7, sent as DSCP class selector) and TTL to outgoing frames. Cheap
+     * when nothing changes, so it can be called before every send.
+     */
+    bool setTrafficClass(uint8_t qos, uint8_t ttl);
+
+    bool send(const MdHeader &header,
+              const uint8_t *dataset,
+              std::size_t datasetSize,
+              const std::string &destinationIp,
+              uint16_t destinationPort);
+
+    /**
+     * Wait up to timeoutMs for a frame. Returns false on timeout, socket error or a frame
+     * that fails header validation.
+     */
+    bool receive(MdFrame &frame, int timeoutMs);
+
+    MdBufferPool &pool() { return *pool_; }
+
+    /** Copy every frame sent or received into a capture; null detaches it. Attach before use. */
+    void attachCapture(std::shared_ptr<PacketCapture> capture) { capture_ = std::move(capture); }
+
+private:
+    std::shared_ptr<MdBufferPool> pool_; // receive buffers only
+    std::shared_ptr<PacketCapture> capture_;
+    int fd_{-1};
+    uint16_t localPort_{0};
+    uint8_t tos_{0};
+    uint8_t ttl_{64};
+    bool trafficClassSet_{false};
+};
+
+} // namespace trdp
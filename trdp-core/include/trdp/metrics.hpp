@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace trdp
+{
+
+/** Number of slots a counter or histogram is split into. */
+constexpr std::size_t kMetricSlots = 16;
+
+/** Slot of the calling thread; threads are spread over the slots round-robin. */
+inline std::size_t metricSlot()
+{
+    static std::atomic<std::size_t> nextSlot{0};
+    thread_local const std::size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % kMetricSlots;
+    return slot;
+}
+
+/**
+ * Monotonic counter for hot paths. Each thread adds to its own cache line with a relaxed
+ * increment, so counting never contends; value() sums the slots and is meant for scrapes.
+ */
+class Counter
+{
+public:
+    void add(uint64_t n = 1) { slots_[metricSlot()].value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Slot, kMetricSlots> slots_{};
+};
+
+/**
+ * Fixed-bucket histogram of durations, sharded per thread like Counter. Bucket bounds are
+ * inclusive upper limits in microseconds; anything above the last bound lands in +Inf.
+ */
+class Histogram
+{
+public:
+    explicit Histogram(std::vector<uint64_t> upperBoundsUs);
+
+    void observe(uint64_t us);
+    void observe(std::chrono::steady_clock::duration duration);
+
+    struct Snapshot
+    {
+        std::vector<uint64_t> upperBoundsUs;
+        std::vector<uint64_t> buckets; // per bucket, not cumulative; the last one is +Inf
+        uint64_t count{0};
+        uint64_t sumUs{0};
+    };
+
+    /** Sum of all slots. Slots are read one by one, so concurrent observations may be split. */
+    Snapshot snapshot() const;
+
+private:
+    static constexpr std::size_t kCellsPerLine = 8;
+
+    struct alignas(64) Line
+    {
+        std::array<std::atomic<uint64_t>, kCellsPerLine> cells{};
+    };
+
+    std::atomic<uint64_t> &cell(std::size_t slot, std::size_t index);
+    const std::atomic<uint64_t> &cell(std::size_t slot, std::size_t index) const;
+
+    std::vector<uint64_t> bounds_;
+    std::size_t linesPerSlot_{1}; // buckets followed by the sum, padded to whole cache lines
+    std::vector<Line> lines_;
+};
+
+} // namespace trdp
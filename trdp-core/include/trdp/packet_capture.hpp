@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace trdp
+{
+
+/** One piece of a datagram's UDP payload, e.g. header, dataset or padding. */
+struct CaptureSegment
+{
+    const uint8_t *data;
+    std::size_t size;
+};
+
+/** Addressing of a captured datagram. Addresses are IPv4 in host byte order. */
+struct CaptureAddress
+{
+    uint32_t sourceIp{0};
+    uint16_t sourcePort{0};
+    uint32_t destinationIp{0};
+    uint16_t destinationPort{0};
+    uint8_t tos{0};
+    uint8_t ttl{64};
+};
+
+/** Parse a dotted IPv4 address into host byte order; false if it is not one. */
+bool parseIpv4(const std::string &text, uint32_t &out);
+
+/**
+ * Writes UDP datagrams to a pcapng file as Ethernet frames with synthesized Ethernet, IPv4
+ * and UDP headers, timestamped in nanoseconds. Multicast destinations get the matching
+ * 01:00:5e MAC; other MACs are locally administered and derived from the IP address.
+ *
+ * capture() only copies the frame into a preallocated buffer under a short lock. A writer
+ * thread swaps full (or, every 200 ms, non-empty) buffers out and writes them with one
+ * fwrite, so file I/O never runs on the caller's thread. If the disk falls behind and both
+ * buffers are full, frames are dropped and counted rather than blocking the caller.
+ */
+class PacketCapture
+{
+public:
+    /** bufferBytes per buffer; two are allocated when the file is opened. */
+    explicit PacketCapture(std::size_t bufferBytes = 1u << 20);
+    ~PacketCapture();
+
+    PacketCapture(const PacketCapture &) = delete;
+    PacketCapture &operator=(const PacketCapture &) = delete;
+
+    /** Create the file and write the section and interface headers. */
+    bool open(const std::string &path);
+    /**
+     * Write what is buffered and close the file. open() and close() may run while another thread
+     * captures; they are not meant to race each other.
+     */
+    void close();
+    bool isOpen() const;
+
+    /**
+     * Address used for this host in synthesized headers when the caller has none better, e.g.
+     * the destination of received frames. 127.0.0.1 by default.
+     */
+    void setLocalIp(uint32_t ip) { localIp_.store(ip, std::memory_order_relaxed); }
+    uint32_t localIp() const { return localIp_.load(std::memory_order_relaxed); }
+
+    void capture(const CaptureAddress &address, const CaptureSegment *segments, std::size_t count);
+
+    uint64_t packets() const { return packets_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Buffer
+    {
+        std::unique_ptr<uint8_t[]> data;
+        std::size_t used{0};
+    };
+
+    void run();
+    void writeBuffer(const Buffer &buffer);
+
+    std::size_t capacity_;
+    std::FILE *file_{nullptr}; // set and cleared under mutex_; the writer thread uses it unlocked
+    std::string path_;
+    std::atomic<uint32_t> localIp_{0x7F000001u};
+    std::atomic<uint64_t> packets_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    Buffer active_;      // filled by capture()
+    Buffer writing_;     // owned by the writer thread while pendingWrite_
+    bool pendingWrite_{false};
+    bool stopping_{false};
+    uint16_t ipIdentification_{0};
+    std::thread writer_;
+};
+
+} // namespace trdp
@@ -1,8 +1,12 @@
 #pragma once
 
 #include "config.hpp"
+#include "flight_recorder.hpp"
+#include "telegram_stats.hpp"
 
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -10,6 +14,8 @@
 namespace trdp
 {
 
+struct ConfigDiff;
+
 using PdUpdateCallback = std::function<void(const PdSubscribeTelegram &)>;
 
 class PdEngine
@@ -19,22 +25,94 @@ public:
 
     void listPublish(std::ostream &os) const;
     void listSubscribe(std::ostream &os) const;
+    /** Per-telegram counters and, where there are samples, the jitter and inter-arrival buckets. */
+    void listStats(std::ostream &os, std::chrono::steady_clock::time_point now) const;
 
     bool setPublishValue(std::size_t index, const std::string &element, const std::string &value);
     bool clearPublish(std::size_t index);
     bool setPublishLock(std::size_t index, const std::string &element, bool locked);
 
-    bool buildPublishPayload(std::size_t index, std::vector<uint8_t> &networkPayload) const;
+    /**
+     * Swap in a full set of values for a publish telegram, e.g. a copy staged with applyUpdates().
+     * Fails for an unknown index or a value list that does not match the telegram's elements.
+     */
+    bool replacePublishValues(std::size_t index, ElementValues values);
+
+    /**
+     * Network payload for a publish telegram. Counts marshalling failures in the telegram's
+     * statistics, so it needs the engine lock like any other mutation.
+     */
+    bool buildPublishPayload(std::size_t index, std::vector<uint8_t> &networkPayload);
     bool updateSubscribeValues(std::size_t index, const std::vector<uint8_t> &networkPayload);
 
+    /**
+     * Exact number of bytes buildPublishPayload() writes for a telegram, or 0 for an unknown index.
+     */
+    std::size_t publishPayloadSize(std::size_t index) const;
+
+    /**
+     * Pack (and marshall, if available) straight into a caller-owned buffer such as a send slot.
+     * Does not allocate once the calling thread has packed its largest dataset.
+     */
+    bool buildPublishPayload(std::size_t index, uint8_t *out, std::size_t capacity, std::size_t &written);
+
+    /**
+     * Replace a publish telegram's values with a complete network payload. The size must equal
+     * publishPayloadSize(); locked elements keep their values.
+     */
+    bool setPublishPayload(std::size_t index, const uint8_t *networkPayload, std::size_t size);
+    bool updateSubscribeValues(std::size_t index, const uint8_t *networkPayload, std::size_t size);
+
+    /**
+     * Count subscriptions that have gone timeoutMs without a successful update since the last
+     * receive (or since the first check). Each silence counts once; returns the new timeouts.
+     */
+    std::size_t checkTimeouts(std::chrono::steady_clock::time_point now);
+
+    /**
+     * Count one transmission of a publish telegram and record how far the period since the
+     * previous one deviated from its cycle time. Called by whatever puts the payload on the wire;
+     * the payload, if given, goes to the flight recorder.
+     */
+    void recordSent(std::size_t index,
+                    std::chrono::steady_clock::time_point now,
+                    const uint8_t *networkPayload = nullptr,
+                    std::size_t size = 0);
+
+    /**
+     * Runtime statistics, indexed like publishTelegrams() and subscribeTelegrams(). Read them
+     * under the same lock as the telegrams.
+     */
+    const std::vector<TelegramStats> &publishStats() const { return publishStats_; }
+    const std::vector<TelegramStats> &subscribeStats() const { return subscribeStats_; }
+
+    /** Zero the statistics and size them to the current telegrams. */
+    void resetStats();
+    /** After a reload: keep the statistics of unchanged telegrams, zero added and changed ones. */
+    void carryStats(const ConfigDiff &diff);
+
+    /** Record sends, receptions and timeouts in a flight recorder; null detaches it. */
+    void attachRecorder(std::shared_ptr<FlightRecorder> recorder) { recorder_ = std::move(recorder); }
+
     void forEachPublish(const std::function<void(PdPublishTelegram &)> &fn);
     void forEachSubscribe(const std::function<void(PdSubscribeTelegram &)> &fn);
 
     const std::vector<PdPublishTelegram> &publishTelegrams() const { return config_.pdPublish; }
+    const std::vector<PdSubscribeTelegram> &subscribeTelegrams() const { return config_.pdSubscribe; }
     const DatasetRegistry &datasets() const { return config_.datasetRegistry; }
+    /** TrdpConfig::generation of the telegrams above; changes when a reload swaps them. */
+    uint64_t configGeneration() const { return config_.generation; }
 
 private:
+    bool marshallingEnabled() const;
+    bool applySubscribePayload(std::size_t index, const uint8_t *networkPayload, std::size_t size);
+    void markReceived(std::size_t index);
+
     TrdpConfig &config_;
+    // Mutable: const payload builders still count marshalling failures.
+    std::vector<TelegramStats> publishStats_;
+    std::vector<TelegramStats> subscribeStats_;
+    std::shared_ptr<FlightRecorder> recorder_;
 };
 
 } // namespace trdp
@@ -2,8 +2,11 @@
 
 #include "config.hpp"
 #include "logging.hpp"
+#include "metrics.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <optional>
 #include <string>
 #include <thread>
@@ -18,6 +21,18 @@ struct SessionConfig
     uint16_t pdPort{17224};
     uint16_t mdPort{17225};
     uint32_t timeoutUs{100000};
+    uint32_t cycleTimeUs{10000};
+    uint32_t processPriority{0};
+    uint8_t pdQos{5};
+    uint8_t pdTtl{64};
+    uint8_t mdQos{3};
+    uint8_t mdTtl{64};
+
+    /**
+     * Session settings from a loaded device configuration (<trdp-process>, <pd-com-parameter>
+     * and <md-com-parameter>).
+     */
+    static SessionConfig fromDeviceConfig(const TrdpConfig &config);
 };
 
 class TrdpSession
@@ -30,11 +45,32 @@ public:
     bool open();
     void close();
 
+    /**
+     * One process cycle. Returns once the configured cycle time has elapsed since the previous
+     * cycle, so the loop runs at the <trdp-process> cycle rather than as fast as it can.
+     */
     void runOnce();
     void runLoop(std::atomic_bool &runningFlag);
 
+    /**
+     * Like runLoop(), but calls afterCycle between cycles so configuration changes land on a
+     * cycle boundary.
+     */
+    void runLoop(std::atomic_bool &runningFlag, const std::function<void()> &afterCycle);
+
+    void setCycleTime(uint32_t cycleTimeUs) { config_.cycleTimeUs = cycleTimeUs; }
+    const SessionConfig &config() const { return config_; }
+
+    /** How late each cycle started compared to its schedule. */
+    const Histogram &cycleLateness() const { return cycleLateness_; }
+    /** Cycles whose start time had already passed; the schedule then restarts from now. */
+    const Counter &cycleOverruns() const { return cycleOverruns_; }
+
 private:
     SessionConfig config_;
+    std::chrono::steady_clock::time_point nextCycle_{};
+    Histogram cycleLateness_{{50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000}};
+    Counter cycleOverruns_;
 #ifdef TRDP_AVAILABLE
     TRDP_APP_SESSION_T appHandle_{};
 #endif
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #ifdef TRDP_AVAILABLE
@@ -15,6 +17,35 @@ extern "C" {
 namespace trdp
 {
 
+/**
+ * Resolved marshalling information for one ComId. Bindings are owned by the marshaller,
+ * never move after creation and may be cached per telegram for the marshaller's lifetime.
+ */
+struct TauBinding
+{
+    uint32_t comId{0};
+    uint16_t datasetId{0};
+    std::size_t networkSize{0}; // exact marshalled size; 0 when the dataset has variable-length parts
+    std::size_t hostSize{0};    // unmarshalled size for a networkSize payload; 0 when unknown
+#ifdef TRDP_AVAILABLE
+    TRDP_DATASET_T *dataset{nullptr}; // null if the dataset or one nested in it is unknown
+#endif
+};
+
+/**
+ * Wrapper around libtrdp's tau marshalling tables.
+ *
+ * Thread safety: libtrdp keeps the tables of the most recent tau_initMarshall() in process-wide
+ * statics and falls back to them for any ComId or nested dataset it was not handed resolved.
+ * Creating a second marshaller (as every reload does while the live one is in use) overwrites
+ * those statics, and destroying it leaves them dangling. So a marshaller never lets libtrdp
+ * reach them: every binding and nested dataset is resolved when it is created, and a binding
+ * whose dataset could not be fully resolved fails in marshall()/unmarshall() without calling
+ * libtrdp. With that, marshall()/unmarshall() only read the marshaller's own tables and may be
+ * called concurrently from any number of threads (e.g. separate TX and RX threads) without
+ * locking, and any number of marshallers may coexist. Moving or destroying a marshaller still
+ * requires exclusive access.
+ */
 class TauMarshaller
 {
 public:
@@ -33,16 +64,49 @@ public:
      */
     static std::unique_ptr<TauMarshaller> createFromXml(const std::string &deviceFile);
 
+    /**
+     * Same as createFromXml() but parses an XML document already held in memory, so a caller
+     * that has read the file for its own parser does not read it again.
+     */
+    static std::unique_ptr<TauMarshaller> createFromXmlBuffer(const char *xml, std::size_t size);
+
     /**
      * Convert host-order payload to the TRDP network representation for the given ComId.
      * Returns false if no marshalling context is available or the ComId is unknown.
      */
     bool marshall(uint32_t comId, const std::vector<uint8_t> &hostPayload, std::vector<uint8_t> &networkPayload) const;
+    bool marshall(const TauBinding &binding, const std::vector<uint8_t> &hostPayload, std::vector<uint8_t> &networkPayload) const;
 
     /**
      * Convert TRDP network payload back into host byte order for the given ComId.
      */
     bool unmarshall(uint32_t comId, const std::vector<uint8_t> &networkPayload, std::vector<uint8_t> &hostPayload) const;
+    bool unmarshall(const TauBinding &binding, const std::vector<uint8_t> &networkPayload, std::vector<uint8_t> &hostPayload) const;
+
+    /**
+     * Allocation-free variants working on caller-owned buffers. On entry the size argument of the
+     * destination holds its capacity, on success it holds the number of bytes written.
+     */
+    bool marshall(const TauBinding &binding,
+                  const uint8_t *hostPayload,
+                  std::size_t hostSize,
+                  uint8_t *networkPayload,
+                  std::size_t &networkSize) const;
+    bool unmarshall(const TauBinding &binding,
+                    const uint8_t *networkPayload,
+                    std::size_t networkSize,
+                    uint8_t *hostPayload,
+                    std::size_t &hostSize) const;
+
+    /**
+     * Exact marshalled size for a ComId as computed at initialisation, or 0 if unknown or variable.
+     */
+    std::size_t marshalledSize(uint32_t comId) const;
+
+    /**
+     * Constant-time lookup of the resolved dataset for a ComId; nullptr if the ComId is unknown.
+     */
+    const TauBinding *binding(uint32_t comId) const;
 
     /**
      * Lookup the dataset id associated with a ComId from the XML-derived map.
@@ -53,6 +117,8 @@ public:
 
 private:
 #ifdef TRDP_AVAILABLE
+    static std::unique_ptr<TauMarshaller> createFromDoc(TRDP_XML_DOC_HANDLE_T &doc);
+    void buildBindings();
     void release();
 
     void *context_{nullptr};
@@ -60,7 +126,7 @@ private:
     uint32_t numDatasets_{0};
     TRDP_COMID_DSID_MAP_T *comIdMapRaw_{nullptr};
     apTRDP_DATASET_T datasetsRaw_{nullptr};
-    std::vector<TRDP_COMID_DSID_MAP_T> comIdMap_;
+    std::unordered_map<uint32_t, TauBinding> bindings_;
 #endif
 };
 
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "metrics.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace trdp
+{
+
+/** Inclusive upper bounds (µs) for deviations of a send period from the configured cycle. */
+struct JitterBuckets
+{
+    static constexpr std::array<uint32_t, 11> kBoundsUs{50,   100,   250,   500,   1000,  2500,
+                                                        5000, 10000, 25000, 50000, 100000};
+};
+
+/** Inclusive upper bounds (µs) for the time between two receptions of a telegram. */
+struct IntervalBuckets
+{
+    static constexpr std::array<uint32_t, 12> kBoundsUs{1000,   2000,   5000,    10000,   20000,   50000,
+                                                        100000, 200000, 500000, 1000000, 2000000, 5000000};
+};
+
+/**
+ * Histogram with compile-time bucket bounds and plain counters, for data already guarded by a
+ * lock. The counts live inline, so a telegram's histograms sit next to its other statistics.
+ */
+template <typename Buckets>
+class FixedHistogram
+{
+public:
+    static constexpr std::size_t kBucketCount = Buckets::kBoundsUs.size() + 1; // the last one is +Inf
+
+    void observe(uint64_t us)
+    {
+        std::size_t bucket = 0;
+        while (bucket < Buckets::kBoundsUs.size() && us > Buckets::kBoundsUs[bucket])
+        {
+            ++bucket;
+        }
+        ++counts_[bucket];
+        ++count_;
+        sumUs_ += us;
+        maxUs_ = us > maxUs_ ? us : maxUs_;
+    }
+
+    void observe(std::chrono::steady_clock::duration duration)
+    {
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        observe(static_cast<uint64_t>(us < 0 ? 0 : us));
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t sumUs() const { return sumUs_; }
+    uint64_t maxUs() const { return maxUs_; }
+    uint64_t meanUs() const { return count_ == 0 ? 0 : sumUs_ / count_; }
+    const std::array<uint32_t, kBucketCount> &buckets() const { return counts_; }
+
+    /** Same shape as Histogram::snapshot(), for exporters that handle both. */
+    Histogram::Snapshot snapshot() const
+    {
+        Histogram::Snapshot snap;
+        snap.upperBoundsUs.assign(Buckets::kBoundsUs.begin(), Buckets::kBoundsUs.end());
+        snap.buckets.assign(counts_.begin(), counts_.end());
+        snap.count = count_;
+        snap.sumUs = sumUs_;
+        return snap;
+    }
+
+private:
+    std::array<uint32_t, kBucketCount> counts_{};
+    uint64_t count_{0};
+    uint64_t sumUs_{0};
+    uint64_t maxUs_{0};
+};
+
+/**
+ * What happened to one telegram at runtime. The engines keep one per telegram in a vector
+ * indexed like the telegrams, written under the same lock as the telegram's values; the
+ * counters and timestamps share the first cache line. A reload keeps the statistics of
+ * telegrams it leaves unchanged; added and changed telegrams start from zero.
+ */
+struct alignas(64) TelegramStats
+{
+    uint64_t sent{0};
+    uint64_t received{0};
+    uint64_t timeouts{0};
+    uint64_t marshallFailures{0};
+    std::chrono::steady_clock::time_point lastSend{};
+    std::chrono::steady_clock::time_point lastReceive{};
+    std::chrono::steady_clock::time_point supervisedSince{}; // first timeout check
+    bool timedOut{false};
+
+    FixedHistogram<JitterBuckets> sendJitter;     // |period - cycle time| between two sends
+    FixedHistogram<IntervalBuckets> interArrival; // time between two receptions
+
+    /** Start of the current silence: the last reception, or when supervision began. */
+    std::chrono::steady_clock::time_point silentSince() const
+    {
+        return lastReceive != std::chrono::steady_clock::time_point{} ? lastReceive : supervisedSince;
+    }
+};
+
+/**
+ * Statistics re-indexed for a new telegram list: entry i is previous[from[i]], or zero where
+ * from[i] is out of range (ConfigDiff::kNoMatch for added and changed telegrams).
+ */
+std::vector<TelegramStats> carryStats(std::vector<TelegramStats> &previous, const std::vector<std::size_t> &from);
+
+/**
+ * One line per distribution for the CLI, e.g. "inter-arrival n=12 mean=100ms max=104ms
+ * <=100ms:3 <=200ms:9"; empty buckets are left out. Nothing is printed without samples.
+ */
+void printDistribution(std::ostream &os, const char *label, const Histogram::Snapshot &snapshot, uint64_t maxUs);
+
+/** "850us", "12.5ms" or "1.25s". */
+std::string formatDuration(uint64_t us);
+std::string formatDuration(std::chrono::steady_clock::duration duration);
+
+} // namespace trdp
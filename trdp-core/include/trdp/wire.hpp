@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace trdp
+{
+
+constexpr uint16_t kTrdpProtocolVersion = 0x0100u;
+constexpr std::size_t kMdHeaderSize = 116u;
+constexpr std::size_t kMdMaxDataSize = 65388u;
+constexpr std::size_t kMdUriSize = 32u;
+constexpr uint16_t kDefaultMdPort = 17225u;
+constexpr std::size_t kPdHeaderSize = 40u;
+constexpr std::size_t kPdMaxDataSize = 1432u;
+constexpr uint16_t kDefaultPdPort = 17224u;
+
+enum class MdMessageType : uint16_t
+{
+    Request = 0x4D72,        // 'Mr'
+    ReplyNoConfirm = 0x4D70, // 'Mp'
+    ReplyConfirm = 0x4D71,   // 'Mq'
+    Confirm = 0x4D63,        // 'Mc'
+    Notify = 0x4D6E,         // 'Mn'
+    Error = 0x4D65           // 'Me'
+};
+
+struct MdHeader
+{
+    uint32_t sequenceCounter{0};
+    uint16_t protocolVersion{kTrdpProtocolVersion};
+    MdMessageType msgType{MdMessageType::Request};
+    uint32_t comId{0};
+    uint32_t etbTopoCnt{0};
+    uint32_t opTrnTopoCnt{0};
+    uint32_t datasetLength{0};
+    int32_t replyStatus{0};
+    std::array<uint8_t, 16> sessionId{};
+    uint32_t replyTimeoutUs{0};
+    std::string sourceUri;
+    std::string destinationUri;
+};
+
+enum class PdMessageType : uint16_t
+{
+    Data = 0x5064,    // 'Pd'
+    Pull = 0x5070,    // 'Pp', reply to a pull request
+    Request = 0x5072, // 'Pr'
+    Error = 0x5065    // 'Pe'
+};
+
+struct PdHeader
+{
+    uint32_t sequenceCounter{0};
+    uint16_t protocolVersion{kTrdpProtocolVersion};
+    PdMessageType msgType{PdMessageType::Data};
+    uint32_t comId{0};
+    uint32_t etbTopoCnt{0};
+    uint32_t opTrnTopoCnt{0};
+    uint32_t datasetLength{0};
+    uint32_t reserved{0};
+    uint32_t replyComId{0};
+    uint32_t replyIpAddress{0};
+};
+
+/**
+ * CRC32 (IEEE 802.3) as used for the TRDP header frame check sequence.
+ */
+uint32_t crc32(const uint8_t *data, std::size_t size, uint32_t seed = 0xFFFFFFFFu);
+
+/**
+ * Number of zero bytes appended after a dataset so the frame ends on a 4 byte boundary.
+ */
+inline std::size_t paddingFor(std::size_t datasetLength)
+{
+    return (4u - (datasetLength % 4u)) % 4u;
+}
+
+/**
+ * Serialise an MD header in network byte order, including the header FCS.
+ */
+void encodeMdHeader(const MdHeader &header, std::array<uint8_t, kMdHeaderSize> &out);
+
+/**
+ * Serialise a PD header in network byte order, including the header FCS.
+ */
+void encodePdHeader(const PdHeader &header, std::array<uint8_t, kPdHeaderSize> &out);
+
+/**
+ * Parse and validate a PD header. Returns false on FCS mismatch or unknown protocol version.
+ */
+bool decodePdHeader(const uint8_t *data, std::size_t size, PdHeader &out);
+
+/**
+ * Parse and validate an MD header. Returns false on FCS mismatch or unknown protocol version.
+ */
+bool decodeMdHeader(const uint8_t *data, std::size_t size, MdHeader &out);
+
+} // namespace trdp
@@ -0,0 +1,386 @@
+#include "trdp/capture_reader.hpp"
+
+#include "trdp/logging.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace trdp
+{
+
+namespace
+{
+constexpr uint32_t kPcapMagicMicro = 0xA1B2C3D4u;
+constexpr uint32_t kPcapMagicNano = 0xA1B23C4Du;
+constexpr uint32_t kPcapngSectionHeader = 0x0A0D0D0Au;
+constexpr uint32_t kPcapngByteOrderMagic = 0x1A2B3C4Du;
+constexpr uint32_t kPcapngInterface = 1;
+constexpr uint32_t kPcapngSimplePacket = 3;
+constexpr uint32_t kPcapngEnhancedPacket = 6;
+constexpr std::size_t kPcapHeaderSize = 24;
+constexpr std::size_t kPcapRecordHeaderSize = 16;
+
+constexpr uint16_t kLinkTypeEthernet = 1;
+constexpr uint16_t kLinkTypeRaw = 101;
+constexpr uint16_t kLinkTypeLinuxCooked = 113;
+constexpr uint16_t kLinkTypeIpv4 = 228;
+
+uint16_t networkU16(const uint8_t *p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t networkU32(const uint8_t *p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+uint32_t swap32(uint32_t value)
+{
+    return __builtin_bswap32(value);
+}
+
+std::size_t padTo4(std::size_t size)
+{
+    return (size + 3u) & ~std::size_t{3};
+}
+
+uint64_t ticksToNs(uint64_t ticks, uint64_t ticksPerSecond)
+{
+    if (ticksPerSecond == 1000000000u)
+    {
+        return ticks;
+    }
+    return ticks / ticksPerSecond * 1000000000u + ticks % ticksPerSecond * 1000000000u / ticksPerSecond;
+}
+} // namespace
+
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+bool CaptureReader::open(const std::string &path)
+{
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error("Failed to open capture file ", path, ": ", std::strerror(errno));
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(kPcapHeaderSize))
+    {
+        error("Capture file ", path, " is too short");
+        ::close(fd);
+        return false;
+    }
+    void *mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        error("Failed to map capture file ", path, ": ", std::strerror(errno));
+        return false;
+    }
+    madvise(mapped, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const uint8_t *>(mapped);
+    size_ = static_cast<std::size_t>(info.st_size);
+    path_ = path;
+    frames_ = 0;
+    skipped_ = 0;
+
+    uint32_t magic;
+    std::memcpy(&magic, data_, sizeof(magic));
+    if (magic == kPcapngSectionHeader)
+    {
+        format_ = Format::Pcapng;
+        offset_ = 0;
+        return true; // the section header is read like any other block
+    }
+    if (magic == kPcapMagicMicro || magic == kPcapMagicNano || swap32(magic) == kPcapMagicMicro ||
+        swap32(magic) == kPcapMagicNano)
+    {
+        format_ = Format::Pcap;
+        swapped_ = magic != kPcapMagicMicro && magic != kPcapMagicNano;
+        const auto hostMagic = swapped_ ? swap32(magic) : magic;
+        pcapInterface_.ticksPerSecond = hostMagic == kPcapMagicNano ? 1000000000u : 1000000u;
+        pcapInterface_.linkType = static_cast<uint16_t>(read32(20) & 0xFFFFu);
+        offset_ = kPcapHeaderSize;
+        return true;
+    }
+    error("Capture file ", path, " is neither pcap nor pcapng");
+    close();
+    return false;
+}
+
+void CaptureReader::close()
+{
+    if (data_ != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    offset_ = 0;
+    interfaces_.clear();
+}
+
+uint32_t CaptureReader::read32(std::size_t offset) const
+{
+    uint32_t value;
+    std::memcpy(&value, data_ + offset, sizeof(value));
+    return swapped_ ? swap32(value) : value;
+}
+
+uint16_t CaptureReader::read16(std::size_t offset) const
+{
+    uint16_t value;
+    std::memcpy(&value, data_ + offset, sizeof(value));
+    return swapped_ ? __builtin_bswap16(value) : value;
+}
+
+bool CaptureReader::next(CapturedDatagram &out)
+{
+    return format_ == Format::Pcap ? nextPcap(out) : nextPcapng(out);
+}
+
+bool CaptureReader::nextPcap(CapturedDatagram &out)
+{
+    while (offset_ < size_)
+    {
+        if (size_ - offset_ < kPcapRecordHeaderSize)
+        {
+            return truncated("record header");
+        }
+        const uint64_t seconds = read32(offset_);
+        const uint64_t fraction = read32(offset_ + 4);
+        const std::size_t captured = read32(offset_ + 8);
+        const std::size_t frameOffset = offset_ + kPcapRecordHeaderSize;
+        if (captured > size_ - frameOffset)
+        {
+            return truncated("packet");
+        }
+        offset_ = frameOffset + captured;
+        ++frames_;
+        out.timeNs = seconds * 1000000000u + ticksToNs(fraction, pcapInterface_.ticksPerSecond);
+        if (decodeFrame(pcapInterface_.linkType, data_ + frameOffset, captured, out))
+        {
+            return true;
+        }
+        ++skipped_;
+    }
+    return false;
+}
+
+bool CaptureReader::nextPcapng(CapturedDatagram &out)
+{
+    while (offset_ < size_)
+    {
+        if (size_ - offset_ < 12)
+        {
+            return truncated("block header");
+        }
+        uint32_t type;
+        std::memcpy(&type, data_ + offset_, sizeof(type));
+        if (type == kPcapngSectionHeader && !readSectionHeader(offset_, size_ - offset_))
+        {
+            return false;
+        }
+        const std::size_t blockSize = read32(offset_ + 4);
+        if (blockSize < 12 || blockSize % 4 != 0 || blockSize > size_ - offset_)
+        {
+            return truncated("block");
+        }
+        const std::size_t body = offset_ + 8;
+        const std::size_t bodySize = blockSize - 12;
+        offset_ += blockSize;
+
+        type = read32(body - 8);
+        if (type == kPcapngInterface)
+        {
+            if (!readInterface(body, bodySize))
+            {
+                return false;
+            }
+            continue;
+        }
+        if (type != kPcapngEnhancedPacket && type != kPcapngSimplePacket)
+        {
+            continue; // statistics, name resolution, custom blocks, ...
+        }
+
+        ++frames_;
+        uint32_t interfaceId = 0;
+        std::size_t captured = 0;
+        std::size_t frameOffset = 0;
+        if (type == kPcapngEnhancedPacket)
+        {
+            if (bodySize < 20)
+            {
+                return truncated("enhanced packet block");
+            }
+            interfaceId = read32(body);
+            const uint64_t ticks = (static_cast<uint64_t>(read32(body + 4)) << 32) | read32(body + 8);
+            captured = read32(body + 12);
+            frameOffset = body + 20;
+            if (interfaceId < interfaces_.size())
+            {
+                out.timeNs = ticksToNs(ticks, interfaces_[interfaceId].ticksPerSecond);
+            }
+        }
+        else
+        {
+            // Simple packet blocks have no timestamp; they keep the previous packet's.
+            if (bodySize < 4)
+            {
+                return truncated("simple packet block");
+            }
+            captured = bodySize - 4;
+            frameOffset = body + 4;
+        }
+        if (interfaceId >= interfaces_.size() || padTo4(captured) > bodySize - (frameOffset - body))
+        {
+            ++skipped_;
+            continue;
+        }
+        if (decodeFrame(interfaces_[interfaceId].linkType, data_ + frameOffset, captured, out))
+        {
+            return true;
+        }
+        ++skipped_;
+    }
+    return false;
+}
+
+bool CaptureReader::readSectionHeader(std::size_t offset, std::size_t available)
+{
+    if (available < 28)
+    {
+        return truncated("section header");
+    }
+    uint32_t magic;
+    std::memcpy(&magic, data_ + offset + 8, sizeof(magic));
+    if (magic != kPcapngByteOrderMagic && swap32(magic) != kPcapngByteOrderMagic)
+    {
+        error("Capture file ", path_, " has a section header with a bad byte-order magic");
+        return false;
+    }
+    swapped_ = magic != kPcapngByteOrderMagic;
+    interfaces_.clear(); // interface ids are per section
+    return true;
+}
+
+bool CaptureReader::readInterface(std::size_t body, std::size_t bodySize)
+{
+    if (bodySize < 8)
+    {
+        return truncated("interface block");
+    }
+    Interface iface;
+    iface.linkType = read16(body);
+    // Options follow the fixed part; only if_tsresol (9) matters here.
+    std::size_t option = body + 8;
+    const std::size_t end = body + bodySize;
+    while (option + 4 <= end)
+    {
+        const uint16_t code = read16(option);
+        const std::size_t length = read16(option + 2);
+        if (code == 0 || option + 4 + length > end)
+        {
+            break;
+        }
+        if (code == 9 && length >= 1)
+        {
+            const uint8_t resolution = data_[option + 4];
+            const unsigned exponent = resolution & 0x7Fu;
+            uint64_t ticks = 1;
+            for (unsigned i = 0; i < exponent && ticks <= UINT64_MAX / 10; ++i)
+            {
+                ticks = (resolution & 0x80u) != 0 ? ticks << 1 : ticks * 10;
+            }
+            iface.ticksPerSecond = ticks;
+        }
+        option += 4 + padTo4(length);
+    }
+    interfaces_.push_back(iface);
+    return true;
+}
+
+bool CaptureReader::decodeFrame(uint16_t linkType, const uint8_t *frame, std::size_t size, CapturedDatagram &out)
+{
+    std::size_t ip = 0;
+    uint16_t etherType = 0x0800;
+    switch (linkType)
+    {
+    case kLinkTypeEthernet:
+        ip = 14;
+        if (size < ip)
+        {
+            return false;
+        }
+        etherType = networkU16(frame + 12);
+        while ((etherType == 0x8100 || etherType == 0x88A8) && size >= ip + 4)
+        {
+            etherType = networkU16(frame + ip + 2);
+            ip += 4;
+        }
+        break;
+    case kLinkTypeLinuxCooked:
+        ip = 16;
+        if (size < ip)
+        {
+            return false;
+        }
+        etherType = networkU16(frame + 14);
+        break;
+    case kLinkTypeRaw:
+    case kLinkTypeIpv4:
+        break;
+    default:
+        return false;
+    }
+    if (etherType != 0x0800 || size < ip + 20 || (frame[ip] >> 4) != 4)
+    {
+        return false;
+    }
+
+    const uint8_t *header = frame + ip;
+    const std::size_t headerSize = (header[0] & 0x0Fu) * 4u;
+    const std::size_t totalSize = networkU16(header + 2);
+    const bool fragment = (networkU16(header + 6) & 0x3FFFu) != 0; // more-fragments flag or an offset
+    if (header[9] != 17 || fragment || headerSize < 20 || totalSize < headerSize + 8 || totalSize > size - ip)
+    {
+        return false;
+    }
+    const uint8_t *udp = header + headerSize;
+    const std::size_t udpSize = networkU16(udp + 4);
+    if (udpSize < 8 || udpSize > totalSize - headerSize)
+    {
+        return false;
+    }
+
+    out.address.sourceIp = networkU32(header + 12);
+    out.address.destinationIp = networkU32(header + 16);
+    out.address.tos = header[1];
+    out.address.ttl = header[8];
+    out.address.sourcePort = networkU16(udp);
+    out.address.destinationPort = networkU16(udp + 2);
+    out.payload = udp + 8;
+    out.size = udpSize - 8;
+    return true;
+}
+
+bool CaptureReader::truncated(const char *what)
+{
+    warn("Capture file ", path_, " ends in a truncated ", what, " at offset ", offset_);
+    offset_ = size_;
+    return false;
+}
+
+} // namespace trdp
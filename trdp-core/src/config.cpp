@@ -1,13 +1,27 @@
 #include "trdp/config.hpp"
 
+#include "trdp/config_cache.hpp"
 #include "trdp/logging.hpp"
 #include "trdp/tau.hpp"
 
 #include "tinyxml2.h"
 
 #include <algorithm>
+#include <arpa/inet.h>
 #include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <ifaddrs.h>
+#include <iterator>
+#include <mutex>
+#include <netinet/in.h>
 #include <optional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <unistd.h>
 
 namespace trdp
 {
@@ -87,7 +101,7 @@ TrdpType parseType(const std::string &type)
         return TrdpType::BYTES;
     }
 
-    warn("Unknown element type '" + type + "', defaulting to BYTES");
+    warn("Unknown element type '", type, "', defaulting to BYTES");
     return TrdpType::BYTES;
 }
 
@@ -107,6 +121,21 @@ std::optional<uint32_t> readUintAttribute(const tinyxml2::XMLElement &element, c
     return std::nullopt;
 }
 
+bool readFlagAttribute(const tinyxml2::XMLElement &element, const char *name, bool fallback)
+{
+    const auto value = readStringAttribute(element, name);
+    if (value.empty())
+    {
+        return fallback;
+    }
+    return value == "on" || value == "yes" || value == "true" || value == "1";
+}
+
+uint8_t readByteAttribute(const tinyxml2::XMLElement &element, const char *name, uint8_t fallback)
+{
+    return static_cast<uint8_t>(std::min<uint32_t>(readUintAttribute(element, name).value_or(fallback), 255u));
+}
+
 DatasetElementDef parseElement(const tinyxml2::XMLElement &element, std::size_t &currentOffset)
 {
     DatasetElementDef def;
@@ -145,7 +174,7 @@ std::optional<DatasetDef> parseDataset(const tinyxml2::XMLElement &datasetElemen
 
     if (dataset.elements.empty())
     {
-        warn("Dataset '" + dataset.name + "' has no elements defined");
+        warn("Dataset '", dataset.name, "' has no elements defined");
     }
 
     return dataset;
@@ -183,13 +212,390 @@ uint32_t toMilliseconds(uint32_t microseconds)
     return std::max(1u, microseconds / 1000u);
 }
 
-void parseTelegrams(const tinyxml2::XMLElement &device, TrdpConfig &config)
+ComDefaults parseComDefaults(const tinyxml2::XMLElement *element, const ComDefaults &fallback)
+{
+    ComDefaults defaults = fallback;
+    if (element != nullptr)
+    {
+        // <md-com-parameter> names its port udp-port and its timeouts reply-/confirm-timeout.
+        const auto port = readUintAttribute(*element, "port");
+        defaults.port = static_cast<uint16_t>(port.value_or(readUintAttribute(*element, "udp-port").value_or(fallback.port)));
+        defaults.qos = readByteAttribute(*element, "qos", fallback.qos);
+        defaults.ttl = readByteAttribute(*element, "ttl", fallback.ttl);
+        const auto timeout = readUintAttribute(*element, "timeout-value");
+        defaults.timeoutUs = timeout.value_or(readUintAttribute(*element, "reply-timeout").value_or(fallback.timeoutUs));
+        defaults.confirmTimeoutUs = readUintAttribute(*element, "confirm-timeout").value_or(fallback.confirmTimeoutUs);
+    }
+    return defaults;
+}
+
+ProcessSettings parseProcess(const tinyxml2::XMLElement *element)
+{
+    ProcessSettings process;
+    if (element != nullptr)
+    {
+        process.cycleTimeUs = readUintAttribute(*element, "cycle-time").value_or(process.cycleTimeUs);
+        process.priority = readUintAttribute(*element, "priority").value_or(process.priority);
+        process.blocking = readFlagAttribute(*element, "blocking", process.blocking);
+        process.trafficShaping = readFlagAttribute(*element, "traffic-shaping", process.trafficShaping);
+    }
+    return process;
+}
+
+std::vector<ComParameter> parseComParameters(const tinyxml2::XMLElement &device)
 {
+    std::vector<ComParameter> parameters;
+    const auto *list = device.FirstChildElement("com-parameter-list");
+    if (list == nullptr)
+    {
+        return parameters;
+    }
+    for (auto *entry = list->FirstChildElement("com-parameter"); entry != nullptr;
+         entry = entry->NextSiblingElement("com-parameter"))
+    {
+        const auto id = readUintAttribute(*entry, "id");
+        if (!id)
+        {
+            warn("Skipping com-parameter without id");
+            continue;
+        }
+        ComParameter parameter;
+        parameter.id = *id;
+        parameter.qos = readByteAttribute(*entry, "qos", parameter.qos);
+        parameter.ttl = readByteAttribute(*entry, "ttl", parameter.ttl);
+        parameters.push_back(parameter);
+    }
+    return parameters;
+}
+
+/**
+ * IPv4 addresses of the local interfaces. Together with each bus interface's host-ip they
+ * decide which side of a telegram this device is on.
+ */
+std::vector<std::string> localInterfaceAddresses()
+{
+    std::vector<std::string> addresses;
+    ifaddrs *interfaces = nullptr;
+    if (getifaddrs(&interfaces) != 0)
+    {
+        warn("Unable to enumerate local interfaces; telegram direction relies on host-ip only");
+        return addresses;
+    }
+    for (auto *entry = interfaces; entry != nullptr; entry = entry->ifa_next)
+    {
+        if (entry->ifa_addr == nullptr || entry->ifa_addr->sa_family != AF_INET)
+        {
+            continue;
+        }
+        char buffer[INET_ADDRSTRLEN];
+        const auto *address = reinterpret_cast<const sockaddr_in *>(entry->ifa_addr);
+        if (inet_ntop(AF_INET, &address->sin_addr, buffer, sizeof(buffer)) != nullptr)
+        {
+            addresses.emplace_back(buffer);
+        }
+    }
+    freeifaddrs(interfaces);
+    std::sort(addresses.begin(), addresses.end());
+    addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+    return addresses;
+}
+
+// The name gethostname() reports, lower-cased; empty if unavailable.
+std::string localHostName()
+{
+    char buffer[256] = {};
+    if (gethostname(buffer, sizeof(buffer) - 1) != 0)
+    {
+        return {};
+    }
+    std::string name(buffer);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+    return name;
+}
+
+enum class Locality
+{
+    None, // no URI given
+    Local,
+    Remote,
+    Unknown // a host name that is not this device's
+};
+
+enum class TelegramRole
+{
+    Publish,
+    Subscribe,
+    Both
+};
+
+struct TelegramBatch
+{
+    std::vector<PdPublishTelegram> publish;
+    std::vector<PdSubscribeTelegram> subscribe;
+    std::vector<MdTemplate> md;
+};
+
+/**
+ * Everything a telegram may inherit from: its bus interface's <pd-com-parameter> and the
+ * device-wide <com-parameter-list>. Read-only while telegrams are converted.
+ */
+struct TelegramContext
+{
+    const DatasetRegistry &registry;
+    std::unordered_map<uint32_t, ComParameter> comParameters;
+    std::unordered_map<const tinyxml2::XMLElement *, ComDefaults> busDefaults; // keyed by <bus-interface>
+    ComDefaults pdDefaults;
+    ComDefaults mdDefaults;
+    std::unordered_set<std::string> localAddresses;
+    std::unordered_set<std::string> localNames; // lower-case <device host-name> and this host's name
+
+    // Host names already reported as undecidable; telegrams are converted on several threads.
+    mutable std::mutex unknownHostsMutex;
+    mutable std::unordered_set<std::string> unknownHosts;
+
+    /**
+     * Whether a source or destination URI names this device. TRDP URIs are "host" or
+     * "user@host", where host is an IPv4 address or a name: addresses are compared against the
+     * local interfaces and host-ip, names against localNames. Other names cannot be decided
+     * without resolving them, which would make loading depend on DNS, so they are reported once
+     * and answered Unknown.
+     */
+    Locality locality(const std::string &uri) const
+    {
+        const auto at = uri.rfind('@');
+        auto host = at == std::string::npos ? uri : uri.substr(at + 1);
+        if (host.empty())
+        {
+            return Locality::None;
+        }
+        in_addr address{};
+        if (inet_pton(AF_INET, host.c_str(), &address) == 1)
+        {
+            return localAddresses.count(host) != 0 ? Locality::Local : Locality::Remote;
+        }
+        std::transform(host.begin(), host.end(), host.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (localNames.count(host) != 0)
+        {
+            return Locality::Local;
+        }
+        std::lock_guard<std::mutex> lock(unknownHostsMutex);
+        if (unknownHosts.insert(host).second)
+        {
+            warn("Cannot tell whether URI host '", host, "' is this device; its telegrams are kept in both engines");
+        }
+        return Locality::Unknown;
+    }
+
+    /**
+     * A telegram is published when this device is its source and subscribed when the device is
+     * its unicast destination or the source is some other device. Telegrams that name no
+     * source, or whose source cannot be decided, stay in both engines. The non-standard
+     * direction="publish|subscribe|both" attribute overrides the decision.
+     */
+    TelegramRole roleOf(const tinyxml2::XMLElement &telegram, const std::string &sourceIp, const std::string &destinationIp) const
+    {
+        const auto override = readStringAttribute(telegram, "direction");
+        if (override == "publish")
+        {
+            return TelegramRole::Publish;
+        }
+        if (override == "subscribe")
+        {
+            return TelegramRole::Subscribe;
+        }
+        if (override == "both")
+        {
+            return TelegramRole::Both;
+        }
+        if (!override.empty())
+        {
+            warn("Ignoring unknown telegram direction '", override, "'");
+        }
+
+        const auto source = locality(sourceIp);
+        const bool destinationLocal = locality(destinationIp) == Locality::Local;
+        if (source == Locality::Local)
+        {
+            return destinationLocal ? TelegramRole::Both : TelegramRole::Publish;
+        }
+        if (destinationLocal || source == Locality::Remote)
+        {
+            return TelegramRole::Subscribe;
+        }
+        return TelegramRole::Both;
+    }
+
+    const ComDefaults &defaultsFor(const tinyxml2::XMLElement &telegram) const
+    {
+        const auto *parent = telegram.Parent() != nullptr ? telegram.Parent()->ToElement() : nullptr;
+        const auto it = busDefaults.find(parent);
+        return it != busDefaults.end() ? it->second : pdDefaults;
+    }
+};
+
+/**
+ * A <telegram> carrying <md-parameter> describes a message exchange rather than cyclic data.
+ * Its direction follows the same source rule as PD (this device, or a source that names no or
+ * an undecidable host, sends requests, or notifications when no reply is expected; another
+ * device as source means this one replies) unless the telegram sets
+ * direction="request|reply|notify|confirm".
+ */
+MdTemplate parseMdTemplate(const tinyxml2::XMLElement &telegram,
+                           const tinyxml2::XMLElement &mdParams,
+                           uint32_t comId,
+                           const DatasetDef &dataset,
+                           const std::string &sourceIp,
+                           const std::string &destinationIp,
+                           const TelegramContext &context)
+{
+    MdTemplate tpl;
+    tpl.name = readStringAttribute(telegram, "name");
+    if (tpl.name.empty())
+    {
+        tpl.name = "md-" + std::to_string(comId);
+    }
+    tpl.comId = comId;
+    tpl.datasetId = dataset.datasetId;
+    tpl.sourceIp = sourceIp;
+    tpl.destinationIp = destinationIp;
+    tpl.destinationPort = context.mdDefaults.port;
+    tpl.replyTimeoutUs = readUintAttribute(mdParams, "reply-timeout").value_or(context.mdDefaults.timeoutUs);
+    tpl.confirmTimeoutUs = readUintAttribute(mdParams, "confirm-timeout").value_or(context.mdDefaults.confirmTimeoutUs);
+    tpl.comParameterId = readUintAttribute(telegram, "com-parameter-id").value_or(0u);
+    tpl.qos = context.mdDefaults.qos;
+    tpl.ttl = context.mdDefaults.ttl;
+    if (tpl.comParameterId != 0u)
+    {
+        const auto parameter = context.comParameters.find(tpl.comParameterId);
+        if (parameter != context.comParameters.end())
+        {
+            tpl.qos = parameter->second.qos;
+            tpl.ttl = parameter->second.ttl;
+        }
+        else
+        {
+            warn("Telegram ", comId, " references unknown com-parameter-id ", tpl.comParameterId);
+        }
+    }
+    tpl.values = defaultValues(dataset);
+
+    const auto direction = readStringAttribute(telegram, "direction");
+    if (direction == "request")
+    {
+        tpl.direction = MdDirection::Request;
+    }
+    else if (direction == "reply")
+    {
+        tpl.direction = MdDirection::Reply;
+    }
+    else if (direction == "notify")
+    {
+        tpl.direction = MdDirection::Notify;
+    }
+    else if (direction == "confirm")
+    {
+        tpl.direction = MdDirection::Confirm;
+    }
+    else
+    {
+        if (!direction.empty())
+        {
+            warn("Ignoring unknown MD direction '", direction, "' for ", tpl.name);
+        }
+        const bool sending = context.locality(sourceIp) != Locality::Remote;
+        tpl.direction = !sending ? MdDirection::Reply
+                                 : (tpl.replyTimeoutUs == 0 ? MdDirection::Notify : MdDirection::Request);
+    }
+    return tpl;
+}
+
+void parseTelegram(const tinyxml2::XMLElement &telegram, const TelegramContext &context, TelegramBatch &out)
+{
+    const auto &registry = context.registry;
+    const auto comId = readUintAttribute(telegram, "com-id");
+    const auto datasetId = readUintAttribute(telegram, "data-set-id");
+    if (!comId || !datasetId)
+    {
+        warn("Skipping telegram missing required com-id or data-set-id");
+        return;
+    }
+
+    const auto *dataset = registry.find(static_cast<uint16_t>(*datasetId));
+    if (dataset == nullptr)
+    {
+        warn("Telegram references unknown dataset id ", *datasetId);
+        return;
+    }
+
+    const auto destinationIp = parseUri(telegram.FirstChildElement("destination"));
+    const auto sourceIp = parseUri(telegram.FirstChildElement("source"));
+    if (const auto *mdParams = telegram.FirstChildElement("md-parameter"))
+    {
+        out.md.push_back(parseMdTemplate(telegram, *mdParams, *comId, *dataset, sourceIp, destinationIp, context));
+        return;
+    }
+
+    const auto &defaults = context.defaultsFor(telegram);
+    const auto *pdParams = telegram.FirstChildElement("pd-parameter");
+    const uint32_t cycleMicro = pdParams != nullptr ? readUintAttribute(*pdParams, "cycle").value_or(1000000u) : 1000000u;
+    const uint32_t timeoutMicro =
+        pdParams != nullptr ? readUintAttribute(*pdParams, "timeout").value_or(defaults.timeoutUs) : defaults.timeoutUs;
+
+    // com-parameter-id selects QoS/TTL from <com-parameter-list>; otherwise the bus defaults apply.
+    const uint32_t comParameterId = readUintAttribute(telegram, "com-parameter-id").value_or(0u);
+    uint8_t qos = defaults.qos;
+    uint8_t ttl = defaults.ttl;
+    if (comParameterId != 0u)
+    {
+        const auto parameter = context.comParameters.find(comParameterId);
+        if (parameter != context.comParameters.end())
+        {
+            qos = parameter->second.qos;
+            ttl = parameter->second.ttl;
+        }
+        else
+        {
+            warn("Telegram ", *comId, " references unknown com-parameter-id ", comParameterId);
+        }
+    }
+
+    const auto role = context.roleOf(telegram, sourceIp, destinationIp);
+
+    if (role != TelegramRole::Subscribe)
+    {
+        PdPublishTelegram pub{};
+        pub.comId = *comId;
+        pub.datasetId = static_cast<uint16_t>(*datasetId);
+        pub.destinationIp = destinationIp;
+        pub.cycleTimeMs = toMilliseconds(cycleMicro);
+        pub.priority = qos;
+        pub.ttl = ttl;
+        pub.comParameterId = comParameterId;
+        pub.values = defaultValues(*dataset);
+        out.publish.push_back(std::move(pub));
+    }
+
+    if (role != TelegramRole::Publish)
+    {
+        PdSubscribeTelegram sub{};
+        sub.comId = *comId;
+        sub.datasetId = static_cast<uint16_t>(*datasetId);
+        sub.sourceIp = sourceIp;
+        sub.destinationIp = destinationIp;
+        sub.timeoutMs = toMilliseconds(timeoutMicro);
+        sub.comParameterId = comParameterId;
+        out.subscribe.push_back(std::move(sub));
+    }
+}
+
+std::vector<const tinyxml2::XMLElement *> collectTelegrams(const tinyxml2::XMLElement &device)
+{
+    std::vector<const tinyxml2::XMLElement *> telegrams;
     const auto *busList = device.FirstChildElement("bus-interface-list");
     if (busList == nullptr)
     {
         warn("No <bus-interface-list> found in device configuration");
-        return;
+        return telegrams;
     }
 
     for (auto *bus = busList->FirstChildElement("bus-interface"); bus != nullptr;
@@ -198,70 +604,203 @@ void parseTelegrams(const tinyxml2::XMLElement &device, TrdpConfig &config)
         for (auto *telegram = bus->FirstChildElement("telegram"); telegram != nullptr;
              telegram = telegram->NextSiblingElement("telegram"))
         {
-            const auto comId = readUintAttribute(*telegram, "com-id");
-            const auto datasetId = readUintAttribute(*telegram, "data-set-id");
-            if (!comId || !datasetId)
-            {
-                warn("Skipping telegram missing required com-id or data-set-id");
-                continue;
-            }
+            telegrams.push_back(telegram);
+        }
+    }
+    return telegrams;
+}
 
-            const auto *dataset = config.datasetRegistry.find(static_cast<uint16_t>(*datasetId));
-            if (dataset == nullptr)
-            {
-                warn("Telegram references unknown dataset id " + std::to_string(*datasetId));
-                continue;
-            }
+std::vector<const tinyxml2::XMLElement *> collectDatasets(const tinyxml2::XMLElement &device)
+{
+    std::vector<const tinyxml2::XMLElement *> datasets;
+    const auto *datasetList = device.FirstChildElement("data-set-list");
+    if (datasetList == nullptr)
+    {
+        warn("Device XML does not contain a <data-set-list>");
+        return datasets;
+    }
 
-            const auto *pdParams = telegram->FirstChildElement("pd-parameter");
-            const uint32_t cycleMicro = pdParams != nullptr ? readUintAttribute(*pdParams, "cycle").value_or(1000000u) : 1000000u;
-            const uint32_t timeoutMicro = pdParams != nullptr ? readUintAttribute(*pdParams, "timeout").value_or(1000000u) : 1000000u;
-
-            const auto destinationIp = parseUri(telegram->FirstChildElement("destination"));
-            const auto sourceIp = parseUri(telegram->FirstChildElement("source"));
-
-            PdPublishTelegram pub{};
-            pub.comId = *comId;
-            pub.datasetId = static_cast<uint16_t>(*datasetId);
-            pub.destinationIp = destinationIp;
-            pub.cycleTimeMs = toMilliseconds(cycleMicro);
-            pub.values = defaultValues(*dataset);
-            config.pdPublish.push_back(std::move(pub));
-
-            PdSubscribeTelegram sub{};
-            sub.comId = *comId;
-            sub.datasetId = static_cast<uint16_t>(*datasetId);
-            sub.sourceIp = sourceIp;
-            sub.destinationIp = destinationIp;
-            sub.timeoutMs = toMilliseconds(timeoutMicro);
-            config.pdSubscribe.push_back(std::move(sub));
-        }
+    for (auto *dataset = datasetList->FirstChildElement("data-set"); dataset != nullptr;
+         dataset = dataset->NextSiblingElement("data-set"))
+    {
+        datasets.push_back(dataset);
     }
+    return datasets;
 }
 
-} // namespace
+std::size_t chunkCount(std::size_t count)
+{
+    constexpr std::size_t kItemsPerWorker = 256;
+    const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<std::size_t>(1, std::min(hardware, count / kItemsPerWorker));
+}
 
-std::optional<TrdpConfig> XmlConfigLoader::loadFromDeviceConfig(const std::string &deviceFile,
-                                                                const std::string &comIdFile,
-                                                                const std::string &pdFile,
-                                                                const std::string &mdFile) const
+/**
+ * Split [0, count) into contiguous chunks and run fn(begin, end, chunk) on worker threads.
+ * A single chunk runs inline.
+ *
+ * The tinyxml2 document is not read-only: Name(), Value() and Attribute() unescape their text
+ * lazily and write it back into the node on first access. Sharing it between workers is only
+ * safe because each chunk reads nothing but the elements it was given and their own subtrees,
+ * which no other chunk touches, and because collectDatasets()/collectTelegrams() walked the
+ * siblings (resolving their names) on this thread before the workers start. The parent
+ * <bus-interface> is only used as a map key; reading the text of it or of any other node shared
+ * between chunks from fn would be a data race.
+ */
+template <typename Fn>
+void forEachChunk(std::size_t count, std::size_t chunks, Fn &&fn)
 {
-    (void)comIdFile;
-    (void)pdFile;
-    (void)mdFile;
+    if (chunks <= 1)
+    {
+        fn(std::size_t{0}, count, std::size_t{0});
+        return;
+    }
+
+    const std::size_t perChunk = (count + chunks - 1) / chunks;
+    std::vector<std::thread> workers;
+    workers.reserve(chunks);
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        const auto begin = std::min(count, chunk * perChunk);
+        const auto end = std::min(count, begin + perChunk);
+        workers.emplace_back([&fn, begin, end, chunk]() { fn(begin, end, chunk); });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
 
+bool readFile(const std::string &path, std::string &out)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    const auto size = in.tellg();
+    if (size < 0)
+    {
+        return false;
+    }
+    out.resize(static_cast<std::size_t>(size));
+    in.seekg(0, std::ios::beg);
+    in.read(&out[0], size);
+    return static_cast<bool>(in);
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string formatMs(double ms)
+{
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.1f ms", ms);
+    return buffer;
+}
+
+#ifdef TRDP_AVAILABLE
+void bindTelegrams(TrdpConfig &config)
+{
+    for (auto &pub : config.pdPublish)
+    {
+        pub.tauBinding = config.tauMarshaller->binding(pub.comId);
+    }
+    for (auto &sub : config.pdSubscribe)
+    {
+        sub.tauBinding = config.tauMarshaller->binding(sub.comId);
+    }
+    for (auto &tpl : config.mdTemplates)
+    {
+        tpl.tauBinding = config.tauMarshaller->binding(tpl.comId);
+    }
+}
+#endif
+
+std::optional<TrdpConfig> loadDevice(const std::string &deviceFile, const std::string &cacheFile)
+{
     if (deviceFile.empty())
     {
         error("Device configuration path is empty");
         return std::nullopt;
     }
 
+    using Clock = std::chrono::steady_clock;
+    const auto loadStart = Clock::now();
+
+    // The file is read once; tinyxml2 and libtrdp both parse from this buffer.
+    std::string xml;
+    if (!readFile(deviceFile, xml))
+    {
+        error("Failed to read device XML: ", deviceFile);
+        return std::nullopt;
+    }
+    const double readMs = millisecondsSince(loadStart);
+
+#ifdef TRDP_AVAILABLE
+    // libtrdp builds its marshalling tables on another thread while the DOM is converted.
+    double tauMs = 0.0;
+    auto tauFuture = std::async(std::launch::async, [&xml, &tauMs]() {
+        const auto tauStart = Clock::now();
+        auto marshaller = TauMarshaller::createFromXmlBuffer(xml.data(), xml.size());
+        tauMs = millisecondsSince(tauStart);
+        return marshaller;
+    });
+#endif
+
+    // A cached image is keyed by the exact XML bytes and the local addresses and host name that
+    // decided each telegram's direction, so editing the file or moving to another host invalidates it.
+    const auto localAddresses = localInterfaceAddresses();
+    const auto hostName = localHostName();
+    uint64_t sourceHash = 0u;
+    if (!cacheFile.empty())
+    {
+        std::string addressKey = hostName + ';';
+        for (const auto &address : localAddresses)
+        {
+            addressKey += address + ';';
+        }
+        sourceHash = hashBytes(xml.data(), xml.size()) * 31u + hashBytes(addressKey.data(), addressKey.size());
+    }
+    if (!cacheFile.empty())
+    {
+        const auto cacheStart = Clock::now();
+        if (auto cached = ConfigCache::load(cacheFile, sourceHash))
+        {
+            const double cacheMs = millisecondsSince(cacheStart);
+            std::string tauSummary;
+#ifdef TRDP_AVAILABLE
+            cached->tauMarshaller = tauFuture.get();
+            tauSummary = ", tau " + formatMs(tauMs) + " (parallel)";
+            if (!cached->tauMarshaller)
+            {
+                warn("TRDP stack available but tau marshalling could not be initialised from XML.");
+            }
+            else
+            {
+                bindTelegrams(*cached);
+            }
+#endif
+            info("Loaded configuration from cache ", cacheFile, " for ", deviceFile);
+            info("Load time ", formatMs(millisecondsSince(loadStart)), ": read ", formatMs(readMs), ", cache ",
+                 formatMs(cacheMs), " (", cached->datasetRegistry.size(), " datasets, ",
+                 cached->pdPublish.size() + cached->pdSubscribe.size(), " telegrams, ", cached->mdTemplates.size(),
+                 " md)", tauSummary);
+            return cached;
+        }
+    }
+
+    auto phaseStart = Clock::now();
     tinyxml2::XMLDocument doc;
-    if (doc.LoadFile(deviceFile.c_str()) != tinyxml2::XML_SUCCESS)
+    if (doc.Parse(xml.data(), xml.size()) != tinyxml2::XML_SUCCESS)
     {
-        error("Failed to load device XML: " + std::string(doc.ErrorStr()));
+        error("Failed to load device XML: ", doc.ErrorStr());
         return std::nullopt;
     }
+    const double parseMs = millisecondsSince(phaseStart);
 
     const auto *device = doc.FirstChildElement("device");
     if (device == nullptr)
@@ -271,42 +810,160 @@ std::optional<TrdpConfig> XmlConfigLoader::loadFromDeviceConfig(const std::strin
     }
 
     TrdpConfig config;
-    const auto *datasetList = device->FirstChildElement("data-set-list");
-    if (datasetList != nullptr)
+
+    // Process and communication settings come from the first bus interface; telegrams
+    // inherit the <pd-com-parameter> of the interface they are declared in.
+    config.comParameters = parseComParameters(*device);
+    TelegramContext telegramContext{config.datasetRegistry, {}, {}, config.pdDefaults, config.mdDefaults, {}};
+    telegramContext.localAddresses.insert(localAddresses.begin(), localAddresses.end());
+    auto deviceName = readStringAttribute(*device, "host-name");
+    std::transform(deviceName.begin(), deviceName.end(), deviceName.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    for (const auto &name : {deviceName, hostName, std::string("localhost")})
+    {
+        if (!name.empty())
+        {
+            telegramContext.localNames.insert(name);
+        }
+    }
+    if (const auto *busList = device->FirstChildElement("bus-interface-list"))
     {
-        for (auto *dataset = datasetList->FirstChildElement("data-set"); dataset != nullptr;
-             dataset = dataset->NextSiblingElement("data-set"))
+        bool first = true;
+        for (auto *bus = busList->FirstChildElement("bus-interface"); bus != nullptr;
+             bus = bus->NextSiblingElement("bus-interface"))
         {
-            auto parsed = parseDataset(*dataset);
-            if (parsed)
+            const auto pdDefaults = parseComDefaults(bus->FirstChildElement("pd-com-parameter"), config.pdDefaults);
+            telegramContext.busDefaults.emplace(bus, pdDefaults);
+            const auto hostIp = readStringAttribute(*bus, "host-ip");
+            if (!hostIp.empty())
+            {
+                telegramContext.localAddresses.insert(hostIp);
+            }
+            if (first)
             {
-                config.datasetRegistry.add(*parsed);
+                config.process = parseProcess(bus->FirstChildElement("trdp-process"));
+                config.mdDefaults = parseComDefaults(bus->FirstChildElement("md-com-parameter"), config.mdDefaults);
+                telegramContext.mdDefaults = config.mdDefaults;
+                telegramContext.pdDefaults = pdDefaults;
+                first = false;
             }
         }
+        config.pdDefaults = telegramContext.pdDefaults;
     }
-    else
+    for (const auto &parameter : config.comParameters)
     {
-        warn("Device XML does not contain a <data-set-list>");
+        telegramContext.comParameters.emplace(parameter.id, parameter);
     }
 
-    parseTelegrams(*device, config);
+    phaseStart = Clock::now();
+    const auto datasetElements = collectDatasets(*device);
+    const auto datasetWorkers = chunkCount(datasetElements.size());
+    std::vector<std::vector<DatasetDef>> datasetChunks(datasetWorkers);
+    forEachChunk(datasetElements.size(), datasetWorkers, [&](std::size_t begin, std::size_t end, std::size_t chunk) {
+        auto &parsed = datasetChunks[chunk];
+        parsed.reserve(end - begin);
+        for (auto i = begin; i < end; ++i)
+        {
+            if (auto dataset = parseDataset(*datasetElements[i]))
+            {
+                parsed.push_back(std::move(*dataset));
+            }
+        }
+    });
+    config.datasetRegistry.reserve(datasetElements.size());
+    for (auto &chunk : datasetChunks)
+    {
+        for (auto &dataset : chunk)
+        {
+            config.datasetRegistry.add(std::move(dataset));
+        }
+    }
+    const double datasetMs = millisecondsSince(phaseStart);
+
+    phaseStart = Clock::now();
+    const auto telegramElements = collectTelegrams(*device);
+    const auto telegramWorkers = chunkCount(telegramElements.size());
+    std::vector<TelegramBatch> telegramChunks(telegramWorkers);
+    forEachChunk(telegramElements.size(), telegramWorkers, [&](std::size_t begin, std::size_t end, std::size_t chunk) {
+        auto &batch = telegramChunks[chunk];
+        batch.publish.reserve(end - begin);
+        batch.subscribe.reserve(end - begin);
+        for (auto i = begin; i < end; ++i)
+        {
+            parseTelegram(*telegramElements[i], telegramContext, batch);
+        }
+    });
+    std::size_t publishCount = 0;
+    std::size_t subscribeCount = 0;
+    std::size_t mdCount = 0;
+    for (const auto &batch : telegramChunks)
+    {
+        publishCount += batch.publish.size();
+        subscribeCount += batch.subscribe.size();
+        mdCount += batch.md.size();
+    }
+    config.pdPublish.reserve(publishCount);
+    config.pdSubscribe.reserve(subscribeCount);
+    config.mdTemplates.reserve(mdCount);
+    for (auto &batch : telegramChunks)
+    {
+        std::move(batch.publish.begin(), batch.publish.end(), std::back_inserter(config.pdPublish));
+        std::move(batch.subscribe.begin(), batch.subscribe.end(), std::back_inserter(config.pdSubscribe));
+        std::move(batch.md.begin(), batch.md.end(), std::back_inserter(config.mdTemplates));
+    }
+    const double telegramMs = millisecondsSince(phaseStart);
 
-    if (config.datasetRegistry.list().empty())
+    if (config.datasetRegistry.empty())
     {
         warn("No datasets loaded from XML");
     }
 
+    std::string tauSummary;
 #ifdef TRDP_AVAILABLE
-    config.tauMarshaller = TauMarshaller::createFromXml(deviceFile);
+    config.tauMarshaller = tauFuture.get();
+    tauSummary = ", tau " + formatMs(tauMs) + " (parallel)";
     if (!config.tauMarshaller)
     {
         warn("TRDP stack available but tau marshalling could not be initialised from XML.");
     }
+    else
+    {
+        bindTelegrams(config);
+    }
 #endif
 
-    info("Loaded configuration from standard TRDP device XML: " + deviceFile);
+    info("Loaded configuration from standard TRDP device XML: ", deviceFile);
+    info("Load time ", formatMs(millisecondsSince(loadStart)), ": read ", formatMs(readMs), " (", xml.size(),
+         " bytes), xml ", formatMs(parseMs), ", datasets ", formatMs(datasetMs), " (", config.datasetRegistry.size(),
+         " on ", datasetWorkers, " threads), telegrams ", formatMs(telegramMs), " (", telegramElements.size(), " on ",
+         telegramWorkers, " threads: ", publishCount, " publish, ", subscribeCount, " subscribe, ", mdCount, " md)",
+         tauSummary);
+
+    if (!cacheFile.empty())
+    {
+        ConfigCache::write(cacheFile, sourceHash, config);
+    }
     return config;
 }
 
-} // namespace trdp
+} // namespace
 
+std::optional<TrdpConfig> XmlConfigLoader::loadFromDeviceConfig(const std::string &deviceFile,
+                                                                const std::string &comIdFile,
+                                                                const std::string &pdFile,
+                                                                const std::string &mdFile) const
+{
+    (void)comIdFile;
+    (void)pdFile;
+    (void)mdFile;
+
+    return loadDevice(deviceFile, "");
+}
+
+std::optional<TrdpConfig> XmlConfigLoader::loadFromDeviceConfigCached(const std::string &deviceFile,
+                                                                      const std::string &cacheFile) const
+{
+    return loadDevice(deviceFile, cacheFile);
+}
+
+} // namespace trdp
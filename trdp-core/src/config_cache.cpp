@@ -0,0 +1,678 @@
+#include "trdp/config_cache.hpp"
+
+#include "trdp/logging.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace trdp
+{
+namespace
+{
+constexpr char kMagic[8] = {'T', 'R', 'D', 'P', 'C', 'F', 'G', '\0'};
+constexpr uint32_t kVersion = 4u;
+
+struct Section
+{
+    uint64_t offset;
+    uint64_t count; // records, or bytes for the string and value sections
+};
+
+struct StrRef
+{
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct ValueRange
+{
+    uint32_t first;
+    uint32_t count;
+};
+
+struct ComDefaultsRecord
+{
+    uint32_t timeoutUs;
+    uint16_t port;
+    uint8_t qos;
+    uint8_t ttl;
+    uint32_t confirmTimeoutUs;
+    uint32_t reserved;
+};
+
+struct SettingsRecord
+{
+    uint32_t cycleTimeUs;
+    uint32_t priority;
+    uint32_t flags; // bit 0 blocking, bit 1 traffic shaping
+    uint32_t reserved;
+    ComDefaultsRecord pd;
+    ComDefaultsRecord md;
+};
+
+struct ComParameterRecord
+{
+    uint32_t id;
+    uint8_t qos;
+    uint8_t ttl;
+    uint16_t reserved;
+};
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sourceHash;
+    SettingsRecord settings;
+    Section comParameters;
+    Section strings;
+    Section valueBytes;
+    Section elements;
+    Section datasets;
+    Section values;
+    Section publish;
+    Section subscribe;
+    Section md;
+};
+
+struct ElementRecord
+{
+    StrRef name;
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t length;
+    uint64_t arrayLength;
+    uint64_t bitOffset;
+};
+
+struct DatasetRecord
+{
+    uint32_t datasetId;
+    StrRef name;
+    uint32_t firstElement;
+    uint32_t elementCount;
+    uint32_t reserved;
+};
+
+struct ValueRecord
+{
+    uint32_t element;
+    uint32_t locked;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+struct PublishRecord
+{
+    uint32_t comId;
+    uint32_t datasetId;
+    StrRef destination;
+    uint32_t cycleTimeMs;
+    uint32_t priority;
+    uint32_t ttl;
+    uint32_t comParameterId;
+    ValueRange values;
+};
+
+struct SubscribeRecord
+{
+    uint32_t comId;
+    uint32_t datasetId;
+    StrRef source;
+    StrRef destination;
+    uint32_t timeoutMs;
+    uint32_t comParameterId;
+    ValueRange lastValues;
+};
+
+struct MdRecord
+{
+    StrRef name;
+    uint32_t direction;
+    uint32_t comId;
+    uint32_t datasetId;
+    uint32_t destinationPort;
+    StrRef source;
+    StrRef destination;
+    uint32_t replyTimeoutUs;
+    uint32_t confirmTimeoutUs;
+    uint32_t comParameterId;
+    uint32_t qos;
+    uint32_t ttl;
+    uint32_t reserved;
+    ValueRange values;
+};
+
+static_assert(std::is_trivially_copyable<Header>::value, "cache records must be trivially copyable");
+static_assert(sizeof(SettingsRecord) % 8 == 0 && sizeof(ComParameterRecord) % 8 == 0 &&
+                  sizeof(ElementRecord) % 8 == 0 && sizeof(DatasetRecord) % 8 == 0 && sizeof(ValueRecord) % 8 == 0 &&
+                  sizeof(PublishRecord) % 8 == 0 && sizeof(SubscribeRecord) % 8 == 0 && sizeof(MdRecord) % 8 == 0,
+              "cache records must keep 8 byte alignment");
+
+class ImageWriter
+{
+public:
+    StrRef intern(const std::string &value)
+    {
+        const auto it = interned_.find(value);
+        if (it != interned_.end())
+        {
+            return it->second;
+        }
+        const StrRef ref{static_cast<uint32_t>(strings_.size()), static_cast<uint32_t>(value.size())};
+        strings_.insert(strings_.end(), value.begin(), value.end());
+        interned_.emplace(value, ref);
+        return ref;
+    }
+
+    uint32_t addElement(const DatasetElementDef &def)
+    {
+        ElementRecord record{};
+        record.name = intern(def.name);
+        record.type = static_cast<uint32_t>(def.type);
+        record.offset = def.offset;
+        record.length = def.length;
+        record.arrayLength = def.arrayLength;
+        record.bitOffset = def.bitOffset;
+        elements_.push_back(record);
+        return static_cast<uint32_t>(elements_.size() - 1);
+    }
+
+    void addDataset(const DatasetDef &dataset)
+    {
+        DatasetRecord record{};
+        record.datasetId = dataset.datasetId;
+        record.name = intern(dataset.name);
+        record.firstElement = static_cast<uint32_t>(elements_.size());
+        record.elementCount = static_cast<uint32_t>(dataset.elements.size());
+        for (const auto &element : dataset.elements)
+        {
+            addElement(element);
+        }
+        datasetElements_[dataset.datasetId] = record;
+        datasets_.push_back(record);
+    }
+
+    ValueRange addValues(uint16_t datasetId, const ElementValues &values)
+    {
+        ValueRange range{static_cast<uint32_t>(values_.size()), static_cast<uint32_t>(values.size())};
+        const auto dataset = datasetElements_.find(datasetId);
+        for (const auto &value : values)
+        {
+            ValueRecord record{};
+            record.element = findElement(dataset != datasetElements_.end() ? &dataset->second : nullptr, value.element);
+            record.locked = value.locked ? 1u : 0u;
+            record.dataOffset = valueBytes_.size();
+            record.dataSize = value.rawValue.size();
+            valueBytes_.insert(valueBytes_.end(), value.rawValue.begin(), value.rawValue.end());
+            values_.push_back(record);
+        }
+        return range;
+    }
+
+    SettingsRecord settings{};
+    std::vector<ComParameterRecord> comParameters;
+    std::vector<PublishRecord> publish;
+    std::vector<SubscribeRecord> subscribe;
+    std::vector<MdRecord> md;
+
+    std::vector<uint8_t> finish(uint64_t sourceHash) const
+    {
+        std::vector<uint8_t> image(sizeof(Header), 0);
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.headerSize = sizeof(Header);
+        header.sourceHash = sourceHash;
+        header.settings = settings;
+        header.comParameters = append(image, comParameters.data(), comParameters.size() * sizeof(ComParameterRecord),
+                                      comParameters.size());
+        header.strings = append(image, strings_.data(), strings_.size(), strings_.size());
+        header.valueBytes = append(image, valueBytes_.data(), valueBytes_.size(), valueBytes_.size());
+        header.elements = append(image, elements_.data(), elements_.size() * sizeof(ElementRecord), elements_.size());
+        header.datasets = append(image, datasets_.data(), datasets_.size() * sizeof(DatasetRecord), datasets_.size());
+        header.values = append(image, values_.data(), values_.size() * sizeof(ValueRecord), values_.size());
+        header.publish = append(image, publish.data(), publish.size() * sizeof(PublishRecord), publish.size());
+        header.subscribe = append(image, subscribe.data(), subscribe.size() * sizeof(SubscribeRecord), subscribe.size());
+        header.md = append(image, md.data(), md.size() * sizeof(MdRecord), md.size());
+        std::memcpy(image.data(), &header, sizeof(header));
+        return image;
+    }
+
+private:
+    static Section append(std::vector<uint8_t> &image, const void *data, std::size_t bytes, std::size_t count)
+    {
+        image.resize((image.size() + 7u) & ~std::size_t{7u}, 0);
+        Section section{image.size(), count};
+        const auto *begin = static_cast<const uint8_t *>(data);
+        image.insert(image.end(), begin, begin + bytes);
+        return section;
+    }
+
+    uint32_t findElement(const DatasetRecord *dataset, const DatasetElementDef &def)
+    {
+        if (dataset != nullptr)
+        {
+            for (uint32_t i = dataset->firstElement; i < dataset->firstElement + dataset->elementCount; ++i)
+            {
+                const auto &record = elements_[i];
+                if (record.offset == def.offset && record.type == static_cast<uint32_t>(def.type) &&
+                    std::string(strings_.begin() + record.name.offset,
+                                strings_.begin() + record.name.offset + record.name.size) == def.name)
+                {
+                    return i;
+                }
+            }
+        }
+        return addElement(def);
+    }
+
+    std::vector<char> strings_;
+    std::unordered_map<std::string, StrRef> interned_;
+    std::vector<uint8_t> valueBytes_;
+    std::vector<ElementRecord> elements_;
+    std::vector<DatasetRecord> datasets_;
+    std::unordered_map<uint16_t, DatasetRecord> datasetElements_;
+    std::vector<ValueRecord> values_;
+};
+
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *mapped = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED)
+            {
+                data_ = static_cast<const uint8_t *>(mapped);
+                size_ = static_cast<std::size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (data_ != nullptr)
+        {
+            munmap(const_cast<uint8_t *>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const uint8_t *data_{nullptr};
+    std::size_t size_{0};
+};
+
+class ImageReader
+{
+public:
+    ImageReader(const uint8_t *data, std::size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    const T *records(const Section &section) const
+    {
+        if (section.offset % alignof(T) != 0 || section.offset > size_ ||
+            section.count > (size_ - section.offset) / sizeof(T))
+        {
+            ok_ = false;
+            return nullptr;
+        }
+        return reinterpret_cast<const T *>(data_ + section.offset);
+    }
+
+    bool setBlobs(const Header &header)
+    {
+        strings_ = records<char>(header.strings);
+        stringsSize_ = header.strings.count;
+        valueBytes_ = records<uint8_t>(header.valueBytes);
+        valueBytesSize_ = header.valueBytes.count;
+        return ok_;
+    }
+
+    std::string str(const StrRef &ref) const
+    {
+        if (static_cast<uint64_t>(ref.offset) + ref.size > stringsSize_)
+        {
+            ok_ = false;
+            return {};
+        }
+        return std::string(strings_ + ref.offset, ref.size);
+    }
+
+    // Element definitions are shared by every telegram on a dataset, so each record is
+    // decoded once and copied from then on.
+    bool decodeElements(const ElementRecord *elements, uint64_t count)
+    {
+        elements_.resize(count);
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            const auto &record = elements[i];
+            if (record.type > static_cast<uint32_t>(TrdpType::BYTES))
+            {
+                ok_ = false;
+                return false;
+            }
+            auto &def = elements_[i];
+            def.name = str(record.name);
+            def.type = static_cast<TrdpType>(record.type);
+            def.offset = record.offset;
+            def.length = record.length;
+            def.arrayLength = record.arrayLength;
+            def.bitOffset = record.bitOffset;
+        }
+        return ok_;
+    }
+
+    bool element(uint32_t index, DatasetElementDef &out) const
+    {
+        if (index >= elements_.size())
+        {
+            ok_ = false;
+            return false;
+        }
+        out = elements_[index];
+        return true;
+    }
+
+    ElementValues values(const ValueRange &range, const ValueRecord *values, uint64_t valueCount) const
+    {
+        ElementValues out;
+        if (static_cast<uint64_t>(range.first) + range.count > valueCount)
+        {
+            ok_ = false;
+            return out;
+        }
+        out.reserve(range.count);
+        for (uint32_t i = range.first; i < range.first + range.count; ++i)
+        {
+            const auto &record = values[i];
+            ElementValue value;
+            if (!element(record.element, value.element) ||
+                record.dataOffset > valueBytesSize_ || record.dataSize > valueBytesSize_ - record.dataOffset)
+            {
+                ok_ = false;
+                return out;
+            }
+            value.locked = record.locked != 0u;
+            value.rawValue.assign(valueBytes_ + record.dataOffset, valueBytes_ + record.dataOffset + record.dataSize);
+            out.push_back(std::move(value));
+        }
+        return out;
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    const uint8_t *data_;
+    std::size_t size_;
+    const char *strings_{nullptr};
+    uint64_t stringsSize_{0};
+    const uint8_t *valueBytes_{nullptr};
+    uint64_t valueBytesSize_{0};
+    std::vector<DatasetElementDef> elements_;
+    mutable bool ok_{true};
+};
+
+ComDefaultsRecord toRecord(const ComDefaults &defaults)
+{
+    return {defaults.timeoutUs, defaults.port, defaults.qos, defaults.ttl, defaults.confirmTimeoutUs, 0u};
+}
+
+ComDefaults fromRecord(const ComDefaultsRecord &record)
+{
+    ComDefaults defaults;
+    defaults.port = record.port;
+    defaults.qos = record.qos;
+    defaults.ttl = record.ttl;
+    defaults.timeoutUs = record.timeoutUs;
+    defaults.confirmTimeoutUs = record.confirmTimeoutUs;
+    return defaults;
+}
+
+} // namespace
+
+uint64_t hashBytes(const void *data, std::size_t size)
+{
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool ConfigCache::write(const std::string &path, uint64_t sourceHash, const TrdpConfig &config)
+{
+    ImageWriter writer;
+    writer.settings.cycleTimeUs = config.process.cycleTimeUs;
+    writer.settings.priority = config.process.priority;
+    writer.settings.flags = (config.process.blocking ? 1u : 0u) | (config.process.trafficShaping ? 2u : 0u);
+    writer.settings.pd = toRecord(config.pdDefaults);
+    writer.settings.md = toRecord(config.mdDefaults);
+    for (const auto &parameter : config.comParameters)
+    {
+        writer.comParameters.push_back({parameter.id, parameter.qos, parameter.ttl, 0u});
+    }
+    for (const auto &dataset : config.datasetRegistry.list())
+    {
+        writer.addDataset(dataset);
+    }
+    for (const auto &pub : config.pdPublish)
+    {
+        PublishRecord record{};
+        record.comId = pub.comId;
+        record.datasetId = pub.datasetId;
+        record.destination = writer.intern(pub.destinationIp);
+        record.cycleTimeMs = pub.cycleTimeMs;
+        record.priority = pub.priority;
+        record.ttl = pub.ttl;
+        record.comParameterId = pub.comParameterId;
+        record.values = writer.addValues(pub.datasetId, pub.values);
+        writer.publish.push_back(record);
+    }
+    for (const auto &sub : config.pdSubscribe)
+    {
+        SubscribeRecord record{};
+        record.comId = sub.comId;
+        record.datasetId = sub.datasetId;
+        record.source = writer.intern(sub.sourceIp);
+        record.destination = writer.intern(sub.destinationIp);
+        record.timeoutMs = sub.timeoutMs;
+        record.comParameterId = sub.comParameterId;
+        record.lastValues = writer.addValues(sub.datasetId, sub.lastValues);
+        writer.subscribe.push_back(record);
+    }
+    for (const auto &tpl : config.mdTemplates)
+    {
+        MdRecord record{};
+        record.name = writer.intern(tpl.name);
+        record.direction = static_cast<uint32_t>(tpl.direction);
+        record.comId = tpl.comId;
+        record.datasetId = tpl.datasetId;
+        record.destinationPort = tpl.destinationPort;
+        record.source = writer.intern(tpl.sourceIp);
+        record.destination = writer.intern(tpl.destinationIp);
+        record.replyTimeoutUs = tpl.replyTimeoutUs;
+        record.confirmTimeoutUs = tpl.confirmTimeoutUs;
+        record.comParameterId = tpl.comParameterId;
+        record.qos = tpl.qos;
+        record.ttl = tpl.ttl;
+        record.values = writer.addValues(tpl.datasetId, tpl.values);
+        writer.md.push_back(record);
+    }
+
+    const auto image = writer.finish(sourceHash);
+    const auto tempPath = path + ".tmp." + std::to_string(::getpid());
+    FILE *file = std::fopen(tempPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        warn("Unable to write configuration cache ", tempPath, ": ", std::strerror(errno));
+        return false;
+    }
+    const bool written = std::fwrite(image.data(), 1, image.size(), file) == image.size();
+    const bool closed = std::fclose(file) == 0;
+    if (!written || !closed || std::rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        warn("Unable to write configuration cache ", path);
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    info("Wrote configuration cache ", path, " (", image.size(), " bytes)");
+    return true;
+}
+
+std::optional<TrdpConfig> ConfigCache::load(const std::string &path, uint64_t sourceHash)
+{
+    MappedFile file(path);
+    if (file.data() == nullptr || file.size() < sizeof(Header))
+    {
+        return std::nullopt;
+    }
+
+    const auto *header = reinterpret_cast<const Header *>(file.data());
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+        header->headerSize != sizeof(Header))
+    {
+        info("Ignoring configuration cache ", path, " written by a different format version");
+        return std::nullopt;
+    }
+    if (header->sourceHash != sourceHash)
+    {
+        info("Configuration cache ", path, " is stale; rebuilding from XML");
+        return std::nullopt;
+    }
+
+    ImageReader reader(file.data(), file.size());
+    const auto *comParameters = reader.records<ComParameterRecord>(header->comParameters);
+    const auto *elements = reader.records<ElementRecord>(header->elements);
+    const auto *datasets = reader.records<DatasetRecord>(header->datasets);
+    const auto *values = reader.records<ValueRecord>(header->values);
+    const auto *publish = reader.records<PublishRecord>(header->publish);
+    const auto *subscribe = reader.records<SubscribeRecord>(header->subscribe);
+    const auto *md = reader.records<MdRecord>(header->md);
+    if (!reader.setBlobs(*header) || !reader.decodeElements(elements, header->elements.count))
+    {
+        warn("Configuration cache ", path, " is corrupt");
+        return std::nullopt;
+    }
+
+    TrdpConfig config;
+    config.process.cycleTimeUs = header->settings.cycleTimeUs;
+    config.process.priority = header->settings.priority;
+    config.process.blocking = (header->settings.flags & 1u) != 0u;
+    config.process.trafficShaping = (header->settings.flags & 2u) != 0u;
+    config.pdDefaults = fromRecord(header->settings.pd);
+    config.mdDefaults = fromRecord(header->settings.md);
+    for (uint64_t i = 0; i < header->comParameters.count; ++i)
+    {
+        config.comParameters.push_back({comParameters[i].id, comParameters[i].qos, comParameters[i].ttl});
+    }
+
+    config.datasetRegistry.reserve(header->datasets.count);
+    for (uint64_t i = 0; i < header->datasets.count && reader.ok(); ++i)
+    {
+        const auto &record = datasets[i];
+        DatasetDef dataset;
+        dataset.datasetId = static_cast<uint16_t>(record.datasetId);
+        dataset.name = reader.str(record.name);
+        dataset.elements.resize(record.elementCount);
+        for (uint32_t e = 0; e < record.elementCount && reader.ok(); ++e)
+        {
+            reader.element(record.firstElement + e, dataset.elements[e]);
+        }
+        config.datasetRegistry.add(std::move(dataset));
+    }
+
+    config.pdPublish.reserve(header->publish.count);
+    for (uint64_t i = 0; i < header->publish.count && reader.ok(); ++i)
+    {
+        const auto &record = publish[i];
+        PdPublishTelegram pub{};
+        pub.comId = record.comId;
+        pub.datasetId = static_cast<uint16_t>(record.datasetId);
+        pub.destinationIp = reader.str(record.destination);
+        pub.cycleTimeMs = record.cycleTimeMs;
+        pub.priority = record.priority;
+        pub.ttl = static_cast<uint8_t>(record.ttl);
+        pub.comParameterId = record.comParameterId;
+        pub.values = reader.values(record.values, values, header->values.count);
+        config.pdPublish.push_back(std::move(pub));
+    }
+
+    config.pdSubscribe.reserve(header->subscribe.count);
+    for (uint64_t i = 0; i < header->subscribe.count && reader.ok(); ++i)
+    {
+        const auto &record = subscribe[i];
+        PdSubscribeTelegram sub{};
+        sub.comId = record.comId;
+        sub.datasetId = static_cast<uint16_t>(record.datasetId);
+        sub.sourceIp = reader.str(record.source);
+        sub.destinationIp = reader.str(record.destination);
+        sub.timeoutMs = record.timeoutMs;
+        sub.comParameterId = record.comParameterId;
+        sub.lastValues = reader.values(record.lastValues, values, header->values.count);
+        config.pdSubscribe.push_back(std::move(sub));
+    }
+
+    config.mdTemplates.reserve(header->md.count);
+    for (uint64_t i = 0; i < header->md.count && reader.ok(); ++i)
+    {
+        const auto &record = md[i];
+        if (record.direction > static_cast<uint32_t>(MdDirection::Confirm))
+        {
+            warn("Configuration cache ", path, " is corrupt");
+            return std::nullopt;
+        }
+        MdTemplate tpl;
+        tpl.name = reader.str(record.name);
+        tpl.direction = static_cast<MdDirection>(record.direction);
+        tpl.comId = record.comId;
+        tpl.datasetId = static_cast<uint16_t>(record.datasetId);
+        tpl.destinationPort = static_cast<uint16_t>(record.destinationPort);
+        tpl.sourceIp = reader.str(record.source);
+        tpl.destinationIp = reader.str(record.destination);
+        tpl.replyTimeoutUs = record.replyTimeoutUs;
+        tpl.confirmTimeoutUs = record.confirmTimeoutUs;
+        tpl.qos = static_cast<uint8_t>(record.qos);
+        tpl.ttl = static_cast<uint8_t>(record.ttl);
+        tpl.comParameterId = record.comParameterId;
+        tpl.values = reader.values(record.values, values, header->values.count);
+        config.mdTemplates.push_back(std::move(tpl));
+    }
+
+    if (!reader.ok())
+    {
+        warn("Configuration cache ", path, " is corrupt");
+        return std::nullopt;
+    }
+    return config;
+}
+
+} // namespace trdp
@@ -0,0 +1,284 @@
+#include "trdp/config_reload.hpp"
+
+#include "trdp/logging.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+namespace trdp
+{
+
+namespace
+{
+bool sameElement(const DatasetElementDef &a, const DatasetElementDef &b)
+{
+    return a.name == b.name && a.type == b.type && a.offset == b.offset && a.length == b.length &&
+           a.arrayLength == b.arrayLength && a.bitOffset == b.bitOffset;
+}
+
+bool sameDataset(const DatasetDef *a, const DatasetDef *b)
+{
+    if (a == nullptr || b == nullptr)
+    {
+        return a == b;
+    }
+    if (a->name != b->name || a->elements.size() != b->elements.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < a->elements.size(); ++i)
+    {
+        if (!sameElement(a->elements[i], b->elements[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copy values and locks element by element; elements whose name, type, size or array length
+// changed keep the defaults of the new configuration.
+void carryValues(ElementValues &from, ElementValues &to)
+{
+    for (auto &target : to)
+    {
+        for (auto &source : from)
+        {
+            if (source.element.name == target.element.name && source.element.type == target.element.type &&
+                expectedSize(source.element) == expectedSize(target.element) &&
+                std::max<std::size_t>(1, source.element.arrayLength) ==
+                    std::max<std::size_t>(1, target.element.arrayLength))
+            {
+                target.rawValue = std::move(source.rawValue);
+                target.locked = source.locked;
+                break;
+            }
+        }
+    }
+}
+
+std::string publishKey(const PdPublishTelegram &pub)
+{
+    return std::to_string(pub.comId) + '>' + pub.destinationIp;
+}
+
+std::string subscribeKey(const PdSubscribeTelegram &sub)
+{
+    return std::to_string(sub.comId) + '<' + sub.sourceIp + '>' + sub.destinationIp;
+}
+
+std::string mdKey(const MdTemplate &tpl)
+{
+    return tpl.name;
+}
+
+// Pairs every telegram in next with the first unused telegram in live that has the same key,
+// and records in from which live telegram each unchanged one of next replaces.
+template <typename Live, typename Next, typename KeyFn, typename SameFn, typename MatchFn>
+ConfigDiff::Counts matchTelegrams(
+    Live &live, Next &next, KeyFn key, SameFn same, MatchFn onMatch, std::vector<std::size_t> &from)
+{
+    ConfigDiff::Counts counts;
+    std::unordered_multimap<std::string, std::size_t> byKey;
+    byKey.reserve(live.size());
+    for (std::size_t i = 0; i < live.size(); ++i)
+    {
+        byKey.emplace(key(live[i]), i);
+    }
+
+    from.assign(next.size(), ConfigDiff::kNoMatch);
+    for (std::size_t i = 0; i < next.size(); ++i)
+    {
+        auto &telegram = next[i];
+        const auto it = byKey.find(key(telegram));
+        if (it == byKey.end())
+        {
+            ++counts.added;
+            continue;
+        }
+        auto &previous = live[it->second];
+        const auto previousIndex = it->second;
+        byKey.erase(it);
+        if (same(previous, telegram))
+        {
+            ++counts.unchanged;
+            from[i] = previousIndex;
+        }
+        else
+        {
+            ++counts.changed;
+        }
+        onMatch(previous, telegram);
+    }
+    counts.removed = byKey.size();
+    return counts;
+}
+
+template <typename LiveConfig, typename NextConfig, typename CarryFn>
+ConfigDiff compare(LiveConfig &live, NextConfig &next, CarryFn carry)
+{
+    ConfigDiff diff;
+    for (const auto &dataset : next.datasetRegistry.list())
+    {
+        const auto *previous = live.datasetRegistry.find(dataset.datasetId);
+        if (previous == nullptr)
+        {
+            ++diff.datasets.added;
+        }
+        else if (sameDataset(previous, &dataset))
+        {
+            ++diff.datasets.unchanged;
+        }
+        else
+        {
+            ++diff.datasets.changed;
+        }
+    }
+    diff.datasets.removed = live.datasetRegistry.size() - diff.datasets.changed - diff.datasets.unchanged;
+
+    const auto sameLayout = [&](uint16_t liveId, uint16_t nextId) {
+        return sameDataset(live.datasetRegistry.find(liveId), next.datasetRegistry.find(nextId));
+    };
+
+    diff.publish = matchTelegrams(
+        live.pdPublish, next.pdPublish, publishKey,
+        [&](const PdPublishTelegram &a, const PdPublishTelegram &b) {
+            return a.datasetId == b.datasetId && a.cycleTimeMs == b.cycleTimeMs && a.priority == b.priority &&
+                   a.ttl == b.ttl && a.comParameterId == b.comParameterId && sameLayout(a.datasetId, b.datasetId);
+        },
+        [&](auto &previous, auto &telegram) { carry(previous.values, telegram.values); }, diff.publishFrom);
+
+    diff.subscribe = matchTelegrams(
+        live.pdSubscribe, next.pdSubscribe, subscribeKey,
+        [&](const PdSubscribeTelegram &a, const PdSubscribeTelegram &b) {
+            return a.datasetId == b.datasetId && a.timeoutMs == b.timeoutMs && a.comParameterId == b.comParameterId &&
+                   sameLayout(a.datasetId, b.datasetId);
+        },
+        [&](auto &previous, auto &telegram) { carry(previous.lastValues, telegram.lastValues); },
+        diff.subscribeFrom);
+
+    diff.md = matchTelegrams(
+        live.mdTemplates, next.mdTemplates, mdKey,
+        [&](const MdTemplate &a, const MdTemplate &b) {
+            return a.direction == b.direction && a.comId == b.comId && a.datasetId == b.datasetId &&
+                   a.sourceIp == b.sourceIp && a.destinationIp == b.destinationIp &&
+                   a.destinationPort == b.destinationPort && a.replyTimeoutUs == b.replyTimeoutUs &&
+                   a.confirmTimeoutUs == b.confirmTimeoutUs && a.comParameterId == b.comParameterId &&
+                   sameLayout(a.datasetId, b.datasetId);
+        },
+        [&](auto &previous, auto &telegram) { carry(previous.values, telegram.values); }, diff.mdFrom);
+
+    return diff;
+}
+
+std::string formatCounts(const ConfigDiff::Counts &counts)
+{
+    return "+" + std::to_string(counts.added) + " -" + std::to_string(counts.removed) + " ~" +
+           std::to_string(counts.changed) + " =" + std::to_string(counts.unchanged);
+}
+} // namespace
+
+std::string ConfigDiff::summary() const
+{
+    return "datasets " + formatCounts(datasets) + ", publish " + formatCounts(publish) + ", subscribe " +
+           formatCounts(subscribe) + ", md " + formatCounts(md);
+}
+
+ConfigDiff diffConfigs(const TrdpConfig &live, const TrdpConfig &next)
+{
+    return compare(live, next, [](const ElementValues &, const ElementValues &) {});
+}
+
+ConfigDiff applyConfig(TrdpConfig &live, TrdpConfig next)
+{
+    const auto diff = compare(live, next, carryValues);
+
+    // Indices may have shifted, so every telegram counts as changed for revision readers.
+    next.revision = live.revision + 1;
+    next.generation = live.generation + 1;
+    for (auto &pub : next.pdPublish)
+    {
+        pub.version = next.revision;
+    }
+    for (auto &sub : next.pdSubscribe)
+    {
+        sub.version = next.revision;
+    }
+    for (auto &tpl : next.mdTemplates)
+    {
+        tpl.version = next.revision;
+    }
+    live = std::move(next);
+    return diff;
+}
+
+ConfigReloader::ConfigReloader(std::string deviceFile, std::string cacheFile)
+    : cacheFile_(std::move(cacheFile)), deviceFile_(std::move(deviceFile))
+{
+}
+
+bool ConfigReloader::request(const std::string &deviceFile)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.valid())
+    {
+        return false;
+    }
+    pendingFile_ = deviceFile.empty() ? deviceFile_ : deviceFile;
+    info("Reloading configuration from ", pendingFile_);
+    pending_ = std::async(std::launch::async, [file = pendingFile_, cache = cacheFile_]() {
+        XmlConfigLoader loader;
+        return cache.empty() ? loader.loadFromDeviceConfig(file, "", "", "") : loader.loadFromDeviceConfigCached(file, cache);
+    });
+    return true;
+}
+
+bool ConfigReloader::ready() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.valid() && pending_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+std::optional<ConfigDiff> ConfigReloader::applyPending(TrdpConfig &live)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_.valid() || pending_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return std::nullopt;
+    }
+
+    auto next = pending_.get();
+    if (!next)
+    {
+        lastResult_ = "failed: " + pendingFile_;
+        error("Reload of ", pendingFile_, " failed; keeping the current configuration");
+        return std::nullopt;
+    }
+
+    const auto diff = applyConfig(live, std::move(*next));
+    deviceFile_ = pendingFile_;
+    lastResult_ = diff.summary();
+    info("Reloaded ", deviceFile_, ": ", lastResult_);
+    return diff;
+}
+
+bool ConfigReloader::busy() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.valid();
+}
+
+std::string ConfigReloader::deviceFile() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return deviceFile_;
+}
+
+std::string ConfigReloader::lastResult() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastResult_;
+}
+
+} // namespace trdp
@@ -40,7 +40,7 @@ bool assignValue(ElementValue &value, const std::string &input)
 {
     if (value.locked)
     {
-        warn("Element '" + value.element.name + "' is locked; skipping update.");
+        warn("Element '", value.element.name, "' is locked; skipping update.");
         return false;
     }
 
@@ -136,14 +136,14 @@ bool assignValue(ElementValue &value, const std::string &input)
     }
     catch (const std::exception &ex)
     {
-        error("Failed to parse value for element '" + value.element.name + "': " + ex.what());
+        error("Failed to parse value for element '", value.element.name, "': ", ex.what());
         return false;
     }
 
     if (size != 0 && buffer.size() != size)
     {
-        warn("Element '" + value.element.name + "' expected " + std::to_string(size) + " bytes but got " +
-             std::to_string(buffer.size()) + ". Padding/truncation applied.");
+        warn("Element '", value.element.name, "' expected ", size, " bytes but got ", buffer.size(),
+             ". Padding/truncation applied.");
         buffer.resize(size, 0);
     }
 
@@ -151,49 +151,97 @@ bool assignValue(ElementValue &value, const std::string &input)
     return true;
 }
 
+bool applyUpdates(ElementValues &values, const std::vector<ElementUpdate> &updates, std::string &reason)
+{
+    for (const auto &update : updates)
+    {
+        const auto it = std::find_if(values.begin(), values.end(),
+                                     [&](const ElementValue &val) { return val.element.name == update.element; });
+        if (it == values.end())
+        {
+            reason = "Unknown element '" + update.element + "'";
+            return false;
+        }
+        const bool wasLocked = it->locked;
+        if (update.locked && !*update.locked)
+        {
+            it->locked = false;
+        }
+        if (update.value && !assignValue(*it, *update.value))
+        {
+            reason = it->locked ? "Element '" + update.element + "' is locked"
+                                : "Invalid value for element '" + update.element + "'";
+            it->locked = wasLocked;
+            return false;
+        }
+        if (update.locked && *update.locked)
+        {
+            it->locked = true;
+        }
+    }
+    return true;
+}
+
 bool packDatasetToPayload(const DatasetDef &dataset, const ElementValues &values, std::vector<uint8_t> &outBuffer)
+{
+    outBuffer.resize(dataset.payloadSize());
+    return packDatasetToPayload(dataset, values, outBuffer.data(), outBuffer.size());
+}
+
+bool packDatasetToPayload(const DatasetDef &dataset, const ElementValues &values, uint8_t *out, std::size_t outSize)
 {
     const auto size = dataset.payloadSize();
-    outBuffer.assign(size, 0);
+    if (outSize < size)
+    {
+        static LogSite bufferSite("dataset.pack-buffer");
+        warn(bufferSite, "Payload buffer of ", outSize, " bytes is too small for dataset '", dataset.name, "' (", size,
+             " bytes).");
+        return false;
+    }
+    std::fill_n(out, size, 0);
 
     for (const auto &value : values)
     {
         const std::size_t expected = expectedSize(value.element) * std::max<std::size_t>(1, value.element.arrayLength);
         if (value.rawValue.size() < expected)
         {
-            warn("Value for element '" + value.element.name + "' is smaller than expected size, padding with zeros.");
+            static LogSite paddingSite("dataset.pad");
+            warn(paddingSite, "Value for element '", value.element.name,
+                 "' is smaller than expected size, padding with zeros.");
         }
         const auto copySize = std::min(expected, value.rawValue.size());
-        if (value.element.offset + expected > outBuffer.size())
+        if (value.element.offset + expected > size)
         {
-            warn("Skipping element '" + value.element.name + "' because it does not fit in payload buffer.");
+            static LogSite overflowSite("dataset.pack-overflow");
+            warn(overflowSite, "Skipping element '", value.element.name,
+                 "' because it does not fit in payload buffer.");
             continue;
         }
-        std::copy_n(value.rawValue.begin(), copySize, outBuffer.begin() + value.element.offset);
-        if (copySize < expected)
-        {
-            std::fill(outBuffer.begin() + value.element.offset + copySize,
-                      outBuffer.begin() + value.element.offset + expected, 0);
-        }
+        std::copy_n(value.rawValue.begin(), copySize, out + value.element.offset);
     }
 
     return true;
 }
 
 bool unpackPayloadToDataset(const DatasetDef &dataset, const std::vector<uint8_t> &payload, ElementValues &outValues)
+{
+    return unpackPayloadToDataset(dataset, payload.data(), payload.size(), outValues);
+}
+
+bool unpackPayloadToDataset(const DatasetDef &dataset, const uint8_t *payload, std::size_t payloadSize, ElementValues &outValues)
 {
     outValues.clear();
     for (const auto &element : dataset.elements)
     {
         const auto size = expectedSize(element) * std::max<std::size_t>(1, element.arrayLength);
-        if (element.offset + size > payload.size())
+        if (element.offset + size > payloadSize)
         {
-            warn("Payload too small to decode element '" + element.name + "'.");
+            static LogSite shortSite("dataset.unpack-short");
+            warn(shortSite, "Payload too small to decode element '", element.name, "'.");
             continue;
         }
         ElementValue decoded{element, {}};
-        decoded.rawValue.resize(size);
-        std::copy_n(payload.begin() + element.offset, size, decoded.rawValue.begin());
+        decoded.rawValue.assign(payload + element.offset, payload + element.offset + size);
         outValues.push_back(std::move(decoded));
     }
     return true;
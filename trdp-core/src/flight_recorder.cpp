@@ -0,0 +1,263 @@
+#include "trdp/flight_recorder.hpp"
+
+#include "trdp/logging.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <ostream>
+
+namespace trdp
+{
+
+namespace
+{
+constexpr char kDumpMagic[8] = {'T', 'R', 'D', 'P', 'F', 'L', 'T', '1'};
+
+std::size_t roundUpToPowerOfTwo(std::size_t value)
+{
+    std::size_t result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+/** Plain copy of a slot, with the stamp replaced by the event's position. */
+struct DumpRecord
+{
+    uint64_t position;
+    int64_t timeNs;
+    uint32_t comId;
+    uint32_t sequence;
+    uint8_t kind;
+    uint8_t failed;
+    uint16_t payloadSize;
+    uint32_t payloadHash;
+    uint8_t payload[FlightEvent::kPayloadPrefix];
+};
+
+static_assert(sizeof(DumpRecord) == sizeof(FlightEvent), "dump records mirror FlightEvent");
+
+struct DumpHeader
+{
+    char magic[8];
+    uint32_t recordSize;
+    uint32_t count;
+    uint64_t firstPosition;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(DumpHeader) == 32, "dump header is 32 bytes");
+
+/**
+ * Copy the event at position out of its slot. False if the slot no longer (or not yet) holds
+ * that event, including when it was overwritten during the copy.
+ */
+bool readSlot(const FlightEvent &slot, uint64_t position, DumpRecord &out)
+{
+    if (slot.stamp.load(std::memory_order_acquire) != position + 1)
+    {
+        return false;
+    }
+    out.position = position;
+    out.timeNs = slot.timeNs;
+    out.comId = slot.comId;
+    out.sequence = slot.sequence;
+    out.kind = static_cast<uint8_t>(slot.kind);
+    out.failed = slot.failed;
+    out.payloadSize = slot.payloadSize;
+    out.payloadHash = slot.payloadHash;
+    std::memcpy(out.payload, slot.payload, sizeof(out.payload));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.stamp.load(std::memory_order_relaxed) == position + 1;
+}
+} // namespace
+
+const char *toString(FlightEventKind kind)
+{
+    switch (kind)
+    {
+    case FlightEventKind::PdSend:
+        return "pd-send";
+    case FlightEventKind::PdReceive:
+        return "pd-receive";
+    case FlightEventKind::PdTimeout:
+        return "pd-timeout";
+    case FlightEventKind::MdSend:
+        return "md-send";
+    case FlightEventKind::MdReceive:
+        return "md-receive";
+    }
+    return "unknown";
+}
+
+uint32_t flightPayloadHash(const uint8_t *data, std::size_t size)
+{
+    // Word-at-a-time multiply/xor-shift mixing in four independent lanes, so hashing a full
+    // PD payload costs a few hundred cycles rather than one dependent multiply per byte.
+    constexpr uint64_t kMul = 0x9E3779B97F4A7C15ull;
+    const auto load = [](const uint8_t *p) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+    };
+    const auto mix = [](uint64_t h, uint64_t word) {
+        h = (h ^ word) * kMul;
+        return h ^ (h >> 29);
+    };
+
+    uint64_t a = size;
+    uint64_t b = size ^ kMul;
+    uint64_t c = ~size;
+    uint64_t d = size * kMul;
+    std::size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32)
+    {
+        a = mix(a, load(data + offset));
+        b = mix(b, load(data + offset + 8));
+        c = mix(c, load(data + offset + 16));
+        d = mix(d, load(data + offset + 24));
+    }
+    for (; offset + 8 <= size; offset += 8)
+    {
+        a = mix(a, load(data + offset));
+    }
+    uint64_t tail = 0;
+    if (offset < size)
+    {
+        std::memcpy(&tail, data + offset, size - offset);
+    }
+    uint64_t hash = mix(a, tail);
+    hash = mix(hash, b);
+    hash = mix(hash, c);
+    hash = mix(hash, d);
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+FlightRecorder::FlightRecorder(std::size_t capacity)
+    : events_(new FlightEvent[roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 1))]),
+      mask_(roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 1)) - 1)
+{
+}
+
+void FlightRecorder::record(FlightEventKind kind,
+                            uint32_t comId,
+                            uint32_t sequence,
+                            const uint8_t *payload,
+                            std::size_t size,
+                            bool failed)
+{
+    const auto position = next_.fetch_add(1, std::memory_order_relaxed);
+    auto &slot = events_[position & mask_];
+    slot.stamp.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+    slot.comId = comId;
+    slot.sequence = sequence;
+    slot.kind = kind;
+    slot.failed = failed ? 1 : 0;
+    slot.payloadSize = static_cast<uint16_t>(std::min<std::size_t>(size, UINT16_MAX));
+    slot.payloadHash = payload != nullptr ? flightPayloadHash(payload, size) : 0;
+    const auto prefix = payload != nullptr ? std::min(size, FlightEvent::kPayloadPrefix) : 0;
+    if (prefix > 0)
+    {
+        std::memcpy(slot.payload, payload, prefix);
+    }
+    std::memset(slot.payload + prefix, 0, FlightEvent::kPayloadPrefix - prefix);
+
+    slot.stamp.store(position + 1, std::memory_order_release);
+}
+
+std::string FlightRecorder::dump() const
+{
+    const auto end = next_.load(std::memory_order_acquire);
+    const auto begin = end > capacity() ? end - capacity() : 0;
+
+    std::string out(sizeof(DumpHeader), '\0');
+    out.reserve(sizeof(DumpHeader) + (end - begin) * sizeof(DumpRecord));
+    uint32_t count = 0;
+    uint64_t first = end;
+    for (auto position = begin; position < end; ++position)
+    {
+        DumpRecord record;
+        if (!readSlot(events_[position & mask_], position, record))
+        {
+            continue;
+        }
+        first = std::min(first, position);
+        out.append(reinterpret_cast<const char *>(&record), sizeof(record));
+        ++count;
+    }
+
+    DumpHeader header{};
+    std::memcpy(header.magic, kDumpMagic, sizeof(kDumpMagic));
+    header.recordSize = sizeof(DumpRecord);
+    header.count = count;
+    header.firstPosition = first;
+    std::memcpy(&out[0], &header, sizeof(header));
+    return out;
+}
+
+bool FlightRecorder::dumpToFile(const std::string &path) const
+{
+    const auto data = dump();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(data.data(), static_cast<std::streamsize>(data.size())))
+    {
+        error("Failed to write flight recorder dump to ", path);
+        return false;
+    }
+    info("Wrote ", (data.size() - sizeof(DumpHeader)) / sizeof(DumpRecord), " flight recorder events to ", path);
+    return true;
+}
+
+void FlightRecorder::print(std::ostream &os, std::size_t newest) const
+{
+    const auto end = next_.load(std::memory_order_acquire);
+    const auto retained = std::min<uint64_t>(end, capacity());
+    const auto begin = end - std::min<uint64_t>(retained, newest);
+    for (auto position = begin; position < end; ++position)
+    {
+        DumpRecord record;
+        if (!readSlot(events_[position & mask_], position, record))
+        {
+            continue;
+        }
+        const auto seconds = static_cast<std::time_t>(record.timeNs / 1000000000);
+        std::tm local{};
+        localtime_r(&seconds, &local);
+        char time[32];
+        const auto length = std::strftime(time, sizeof(time), "%H:%M:%S", &local);
+        std::snprintf(time + length, sizeof(time) - length, ".%06lld",
+                      static_cast<long long>(record.timeNs % 1000000000 / 1000));
+
+        char line[96];
+        std::snprintf(line, sizeof(line), "%s %-10s COMID=%u seq=%u bytes=%u hash=%08x%s", time,
+                      toString(static_cast<FlightEventKind>(record.kind)), record.comId, record.sequence,
+                      record.payloadSize, record.payloadHash, record.failed != 0 ? " FAILED" : "");
+        os << line;
+        const auto shown = std::min<std::size_t>(record.payloadSize, FlightEvent::kPayloadPrefix);
+        if (shown > 0)
+        {
+            os << " ";
+            for (std::size_t i = 0; i < shown; ++i)
+            {
+                char hex[3];
+                std::snprintf(hex, sizeof(hex), "%02x", record.payload[i]);
+                os << hex;
+            }
+            os << (record.payloadSize > shown ? "..." : "");
+        }
+        os << std::endl;
+    }
+}
+
+} // namespace trdp
@@ -0,0 +1,509 @@
+#include "trdp/logging.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace trdp
+{
+
+namespace detail
+{
+std::atomic<uint8_t> runtimeLogLevel{static_cast<uint8_t>(LogLevel::Info)};
+}
+
+namespace
+{
+constexpr std::size_t kRingBytes = 64 * 1024; // per logging thread
+constexpr std::size_t kAlign = 16;            // records start on this boundary, as does the ring
+constexpr uint32_t kWrapMarker = UINT32_MAX;
+constexpr auto kIdleWait = std::chrono::milliseconds(200);
+
+struct RecordHeader
+{
+    int64_t timeNs;
+    uint32_t size; // text bytes, or kWrapMarker: the rest of the ring up to its end is unused
+    uint8_t level;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(RecordHeader) == kAlign, "record header must fill one alignment unit");
+
+constexpr std::size_t recordBytes(std::size_t textSize)
+{
+    return (sizeof(RecordHeader) + textSize + kAlign - 1) / kAlign * kAlign;
+}
+
+/**
+ * Single-producer single-consumer byte ring. The owning thread appends records and only ever
+ * moves tail; the log thread reads them and only ever moves head. Positions grow without
+ * bound and are reduced modulo the ring size on access.
+ */
+struct LogRing
+{
+    alignas(64) std::atomic<uint64_t> tail{0};
+    alignas(64) std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> orphaned{false}; // owning thread has exited
+    std::unique_ptr<unsigned char[]> bytes{new unsigned char[kRingBytes]};
+
+    bool push(int64_t timeNs, LogLevel level, const char *text, std::size_t size)
+    {
+        size = std::min(size, kRingBytes / 4);
+        const std::size_t total = recordBytes(size);
+        uint64_t position = tail.load(std::memory_order_relaxed);
+        const std::size_t toEnd = kRingBytes - position % kRingBytes;
+        const std::size_t needed = total + (toEnd < total ? toEnd : 0);
+        if (position + needed - head.load(std::memory_order_acquire) > kRingBytes)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        RecordHeader header{};
+        if (toEnd < total)
+        {
+            header.size = kWrapMarker;
+            std::memcpy(bytes.get() + position % kRingBytes, &header, sizeof(header));
+            position += toEnd;
+        }
+        header.timeNs = timeNs;
+        header.size = static_cast<uint32_t>(size);
+        header.level = static_cast<uint8_t>(level);
+        unsigned char *slot = bytes.get() + position % kRingBytes;
+        std::memcpy(slot, &header, sizeof(header));
+        std::memcpy(slot + sizeof(header), text, size);
+        tail.store(position + total, std::memory_order_release);
+        return true;
+    }
+};
+
+constexpr std::size_t kMaxSiteMessages = 32;
+
+/** Every live LogSite, so the log thread can write due summaries. Never destroyed. */
+struct SiteRegistry
+{
+    std::mutex mutex;
+    std::vector<LogSite *> sites;
+};
+
+SiteRegistry &siteRegistry()
+{
+    static SiteRegistry *registry = new SiteRegistry();
+    return *registry;
+}
+
+void flushDueSummaries()
+{
+    const auto now = std::chrono::steady_clock::now();
+    auto &registry = siteRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto *site : registry.sites)
+    {
+        site->flushSummaries(now);
+    }
+}
+
+uint64_t hashText(const std::string &text)
+{
+    uint64_t hash = 1469598103934665603ull;
+    for (const char c : text)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+struct PendingLine
+{
+    int64_t timeNs;
+    LogLevel level;
+    std::size_t offset; // into the batch text
+    std::size_t size;
+};
+
+/**
+ * Owns the rings and the thread that writes them to stdout. Lines from different threads are
+ * merged by timestamp within each pass. After shutdown (at exit) lines are written directly.
+ */
+class LogBackend
+{
+public:
+    LogBackend()
+    {
+        thread_ = std::thread([this]() { run(); });
+        std::atexit([]() { instance().shutdown(); });
+    }
+
+    static LogBackend &instance()
+    {
+        // Never destroyed, so objects torn down at exit can still log.
+        static LogBackend *backend = new LogBackend();
+        return *backend;
+    }
+
+    void submit(LogLevel level, const char *text, std::size_t size)
+    {
+        const auto timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+        if (stopped_.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(drainMutex_);
+            std::string out;
+            appendLine(out, timeNs, level, text, size);
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            std::fflush(stdout);
+            return;
+        }
+        if (localRing().push(timeNs, level, text, size) && !signalled_.exchange(true, std::memory_order_acq_rel))
+        {
+            wake_.notify_one();
+        }
+    }
+
+    void flush()
+    {
+        if (!stopped_.load(std::memory_order_acquire))
+        {
+            drain();
+        }
+    }
+
+private:
+    struct RingHandle
+    {
+        std::shared_ptr<LogRing> ring;
+        ~RingHandle()
+        {
+            if (ring)
+            {
+                ring->orphaned.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    LogRing &localRing()
+    {
+        thread_local RingHandle handle;
+        if (!handle.ring)
+        {
+            handle.ring = std::make_shared<LogRing>();
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            rings_.push_back(handle.ring);
+        }
+        return *handle.ring;
+    }
+
+    void run()
+    {
+        while (!stopping_.load(std::memory_order_acquire))
+        {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                wake_.wait_for(lock, kIdleWait, [this]() {
+                    return signalled_.load(std::memory_order_acquire) || stopping_.load(std::memory_order_acquire);
+                });
+            }
+            signalled_.store(false, std::memory_order_release);
+            flushDueSummaries();
+            drain();
+        }
+        drain();
+    }
+
+    void shutdown()
+    {
+        stopping_.store(true, std::memory_order_release);
+        wake_.notify_one();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+        stopped_.store(true, std::memory_order_release);
+        drain();
+    }
+
+    /** Move everything queued so far to stdout. Serialised, since each ring has one reader. */
+    void drain()
+    {
+        std::lock_guard<std::mutex> drainLock(drainMutex_);
+        std::vector<std::shared_ptr<LogRing>> rings;
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            rings = rings_;
+        }
+
+        batchText_.clear();
+        batch_.clear();
+        uint64_t dropped = 0;
+        for (const auto &ring : rings)
+        {
+            uint64_t head = ring->head.load(std::memory_order_relaxed);
+            const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+            while (head < tail)
+            {
+                RecordHeader header;
+                const unsigned char *slot = ring->bytes.get() + head % kRingBytes;
+                std::memcpy(&header, slot, sizeof(header));
+                if (header.size == kWrapMarker)
+                {
+                    head += kRingBytes - head % kRingBytes;
+                    continue;
+                }
+                batch_.push_back({header.timeNs, static_cast<LogLevel>(header.level), batchText_.size(), header.size});
+                batchText_.append(reinterpret_cast<const char *>(slot + sizeof(header)), header.size);
+                head += recordBytes(header.size);
+            }
+            ring->head.store(head, std::memory_order_release);
+            dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                        [](const std::shared_ptr<LogRing> &ring) {
+                                            return ring->orphaned.load(std::memory_order_acquire) &&
+                                                   ring->head.load(std::memory_order_relaxed) ==
+                                                       ring->tail.load(std::memory_order_acquire);
+                                        }),
+                         rings_.end());
+        }
+
+        if (batch_.empty() && dropped == 0)
+        {
+            return;
+        }
+        std::stable_sort(batch_.begin(), batch_.end(),
+                         [](const PendingLine &a, const PendingLine &b) { return a.timeNs < b.timeNs; });
+        out_.clear();
+        for (const auto &line : batch_)
+        {
+            appendLine(out_, line.timeNs, line.level, batchText_.data() + line.offset, line.size);
+        }
+        if (dropped != 0)
+        {
+            const std::string note = "Log buffer full; dropped " + std::to_string(dropped) + " messages";
+            appendLine(out_, batch_.empty() ? 0 : batch_.back().timeNs, LogLevel::Warn, note.data(), note.size());
+        }
+        std::fwrite(out_.data(), 1, out_.size(), stdout);
+        std::fflush(stdout);
+    }
+
+    /** "[YYYY-MM-DD HH:MM:SS] LEVEL: text\n"; the date part is formatted once per second. */
+    void appendLine(std::string &out, int64_t timeNs, LogLevel level, const char *text, std::size_t size)
+    {
+        const std::time_t second = timeNs != 0 ? static_cast<std::time_t>(timeNs / 1000000000) : std::time(nullptr);
+        if (second != cachedSecond_)
+        {
+            std::tm tm{};
+#ifdef _WIN32
+            localtime_s(&tm, &second);
+#else
+            localtime_r(&second, &tm);
+#endif
+            char stamp[32];
+            const std::size_t length = std::strftime(stamp, sizeof(stamp), "[%Y-%m-%d %H:%M:%S] ", &tm);
+            cachedStamp_.assign(stamp, length);
+            cachedSecond_ = second;
+        }
+        out += cachedStamp_;
+        out += toString(level);
+        out += ": ";
+        out.append(text, size);
+        out += '\n';
+    }
+
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+
+    std::mutex drainMutex_; // one reader at a time; guards everything below it
+    std::vector<PendingLine> batch_;
+    std::string batchText_;
+    std::string out_;
+    std::time_t cachedSecond_{-1};
+    std::string cachedStamp_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> signalled_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> stopped_{false};
+    std::thread thread_;
+};
+} // namespace
+
+void setLogLevel(LogLevel level)
+{
+    detail::runtimeLogLevel.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+LogLevel logLevel()
+{
+    return static_cast<LogLevel>(detail::runtimeLogLevel.load(std::memory_order_relaxed));
+}
+
+std::optional<LogLevel> parseLogLevel(const std::string &name)
+{
+    for (const auto level : {LogLevel::Debug, LogLevel::Info, LogLevel::Warn, LogLevel::Error, LogLevel::Off})
+    {
+        std::string lower = toString(level);
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (name == lower)
+        {
+            return level;
+        }
+    }
+    return std::nullopt;
+}
+
+const char *toString(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::Debug:
+        return "DEBUG";
+    case LogLevel::Info:
+        return "INFO";
+    case LogLevel::Warn:
+        return "WARN";
+    case LogLevel::Error:
+        return "ERROR";
+    case LogLevel::Off:
+        return "OFF";
+    }
+    return "?";
+}
+
+void flushLog()
+{
+    LogBackend::instance().flush();
+}
+
+LogSite::LogSite(const char *name, std::chrono::milliseconds interval) : name_(name), interval_(interval)
+{
+    auto &registry = siteRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.sites.push_back(this);
+}
+
+LogSite::~LogSite()
+{
+    {
+        auto &registry = siteRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.sites.erase(std::remove(registry.sites.begin(), registry.sites.end(), this), registry.sites.end());
+    }
+    flushSummaries(std::chrono::steady_clock::now(), true);
+}
+
+bool LogSite::admit(LogLevel level, const std::string &text)
+{
+    const auto hash = hashText(text);
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&](const Entry &entry) { return entry.hash == hash && entry.text == text; });
+    if (it == entries_.end() && entries_.size() < kMaxSiteMessages)
+    {
+        Entry entry;
+        entry.hash = hash;
+        entry.text = text;
+        entry.level = level;
+        entry.occurrences = 1;
+        entry.lastWrite = now;
+        entries_.push_back(std::move(entry));
+        return true;
+    }
+    if (it == entries_.end())
+    {
+        // Overflow: every further distinct message shares one slot, which keeps the latest text.
+        if (entries_.size() == kMaxSiteMessages)
+        {
+            entries_.emplace_back();
+        }
+        it = entries_.end() - 1;
+        it->text = text;
+        it->level = level;
+    }
+
+    ++it->occurrences;
+    if (it->pending == 0 && now - it->lastWrite >= interval_)
+    {
+        it->lastWrite = now;
+        return true;
+    }
+    ++it->pending;
+    ++it->suppressed;
+    return false;
+}
+
+void LogSite::flushSummaries(std::chrono::steady_clock::time_point now, bool force)
+{
+    std::vector<std::pair<LogLevel, std::string>> lines;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &entry : entries_)
+        {
+            if (entry.pending == 0 || (!force && now - entry.lastWrite < interval_))
+            {
+                continue;
+            }
+            const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now - entry.lastWrite).count();
+            const char *what = entry.hash == 0 ? " other messages from this site" : " times";
+            lines.emplace_back(entry.level, entry.text + " [repeated " + std::to_string(entry.pending) + what +
+                                                " in the last " + std::to_string(seconds) + " s]");
+            entry.pending = 0;
+            entry.lastWrite = now;
+        }
+    }
+    for (const auto &line : lines)
+    {
+        if (logEnabled(line.first))
+        {
+            detail::submitLog(line.first, line.second.data(), line.second.size());
+        }
+    }
+}
+
+std::vector<LogSite::MessageStats> LogSite::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<MessageStats> out;
+    out.reserve(entries_.size());
+    for (const auto &entry : entries_)
+    {
+        out.push_back({entry.text, entry.occurrences, entry.suppressed});
+    }
+    return out;
+}
+
+std::vector<LogSiteStats> logSiteStats()
+{
+    auto &registry = siteRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<LogSiteStats> out;
+    out.reserve(registry.sites.size());
+    for (const auto *site : registry.sites)
+    {
+        out.push_back({site->name(), site->stats()});
+    }
+    return out;
+}
+
+namespace detail
+{
+void submitLog(LogLevel level, const char *text, std::size_t size)
+{
+    LogBackend::instance().submit(level, text, size);
+}
+} // namespace detail
+
+} // namespace trdp
@@ -1,5 +1,6 @@
 #include "trdp/md.hpp"
 
+#include "trdp/config_reload.hpp"
 #include "trdp/dataset.hpp"
 #include "trdp/logging.hpp"
 #include "trdp/tau.hpp"
@@ -10,7 +11,129 @@
 namespace trdp
 {
 
-MdEngine::MdEngine(TrdpConfig &config) : config_(config) {}
+namespace
+{
+MdMessageType messageTypeFor(MdDirection direction)
+{
+    switch (direction)
+    {
+    case MdDirection::Request:
+        return MdMessageType::Request;
+    case MdDirection::Reply:
+        return MdMessageType::ReplyNoConfirm;
+    case MdDirection::Notify:
+        return MdMessageType::Notify;
+    case MdDirection::Confirm:
+        return MdMessageType::Confirm;
+    }
+    return MdMessageType::Request;
+}
+
+/**
+ * Whether a template that sends direction is the one to receive a message of type: requests and
+ * notifies from other devices land in the template that answers them, replies in the one that
+ * confirms them. Templates never take a frame of the kind they send themselves.
+ */
+bool receives(MdDirection direction, MdMessageType type)
+{
+    switch (type)
+    {
+    case MdMessageType::Request:
+    case MdMessageType::Notify:
+        return direction == MdDirection::Reply;
+    case MdMessageType::ReplyNoConfirm:
+    case MdMessageType::ReplyConfirm:
+        return direction == MdDirection::Confirm;
+    case MdMessageType::Confirm:
+    case MdMessageType::Error:
+        return false;
+    }
+    return false;
+}
+} // namespace
+
+MdEngine::MdEngine(TrdpConfig &config) : config_(config), pool_(std::make_shared<MdBufferPool>())
+{
+    resetStats();
+    preparePayloads();
+}
+
+void MdEngine::resetStats()
+{
+    templateStats_.assign(config_.mdTemplates.size(), TelegramStats{});
+}
+
+void MdEngine::carryStats(const ConfigDiff &diff)
+{
+    templateStats_ = trdp::carryStats(templateStats_, diff.mdFrom);
+    templateStats_.resize(config_.mdTemplates.size());
+}
+
+TelegramStats &MdEngine::statsFor(const MdTemplate &tpl)
+{
+    return templateStats_[static_cast<std::size_t>(&tpl - config_.mdTemplates.data())];
+}
+
+void MdEngine::preparePayloads()
+{
+    for (auto &tpl : config_.mdTemplates)
+    {
+        wirePayload(tpl);
+    }
+}
+
+const std::vector<uint8_t> &MdEngine::wirePayload(MdTemplate &tpl)
+{
+    if (tpl.wirePayloadValid)
+    {
+        return tpl.wirePayload;
+    }
+
+    // Without a marshaller the host layout is the wire layout, so pack in place; otherwise
+    // pack into a pooled buffer and marshall into the template's payload.
+    const DatasetDef *dataset = config_.datasetRegistry.find(tpl.datasetId);
+    const bool marshall = config_.tauMarshaller && config_.tauMarshaller->valid();
+    tpl.wirePayload.clear();
+    if (!marshall)
+    {
+        if (dataset)
+        {
+            packDatasetToPayload(*dataset, tpl.values, tpl.wirePayload);
+        }
+        tpl.wirePayloadValid = true;
+        return tpl.wirePayload;
+    }
+
+    auto hostPayload = pool_->acquire();
+    hostPayload->clear();
+    if (dataset)
+    {
+        packDatasetToPayload(*dataset, tpl.values, *hostPayload);
+    }
+    const bool ok = tpl.tauBinding != nullptr ? config_.tauMarshaller->marshall(*tpl.tauBinding, *hostPayload, tpl.wirePayload)
+                                              : config_.tauMarshaller->marshall(tpl.comId, *hostPayload, tpl.wirePayload);
+    if (!ok)
+    {
+        ++statsFor(tpl).marshallFailures;
+        static LogSite marshallSite("md.marshall");
+        warn(marshallSite, "tau_marshall failed for MD template '", tpl.name, "', using host payload");
+        tpl.wirePayload.assign(hostPayload->begin(), hostPayload->end());
+    }
+    tpl.wirePayloadValid = true;
+    return tpl.wirePayload;
+}
+
+bool MdEngine::templatePayload(const std::string &name, std::vector<uint8_t> &out)
+{
+    const auto it = std::find_if(config_.mdTemplates.begin(), config_.mdTemplates.end(),
+                                 [&](const auto &tpl) { return tpl.name == name; });
+    if (it == config_.mdTemplates.end())
+    {
+        return false;
+    }
+    out = wirePayload(*it);
+    return true;
+}
 
 void MdEngine::listTemplates(std::ostream &os) const
 {
@@ -21,6 +144,23 @@ void MdEngine::listTemplates(std::ostream &os) const
     }
 }
 
+void MdEngine::listStats(std::ostream &os, std::chrono::steady_clock::time_point now) const
+{
+    for (std::size_t i = 0; i < config_.mdTemplates.size(); ++i)
+    {
+        const auto &tpl = config_.mdTemplates[i];
+        const auto &stats = templateStats_[i];
+        os << "md " << tpl.name << " COMID=" << tpl.comId << " sent=" << stats.sent << " received=" << stats.received
+           << " marshallFailures=" << stats.marshallFailures;
+        if (stats.lastReceive != std::chrono::steady_clock::time_point{})
+        {
+            os << " lastReceive=" << formatDuration(now - stats.lastReceive) << " ago";
+        }
+        os << std::endl;
+        printDistribution(os, "inter-arrival", stats.interArrival.snapshot(), stats.interArrival.maxUs());
+    }
+}
+
 bool MdEngine::setTemplateValue(const std::string &name, const std::string &element, const std::string &value)
 {
     const auto it = std::find_if(config_.mdTemplates.begin(), config_.mdTemplates.end(),
@@ -33,7 +173,13 @@ bool MdEngine::setTemplateValue(const std::string &name, const std::string &elem
     {
         if (val.element.name == element)
         {
-            return assignValue(val, value);
+            if (!assignValue(val, value))
+            {
+                return false;
+            }
+            it->wirePayloadValid = false;
+            markChanged(config_, *it);
+            return true;
         }
     }
     return false;
@@ -51,11 +197,13 @@ bool MdEngine::clearTemplate(const std::string &name)
     {
         if (val.locked)
         {
-            warn("Skipping clear for locked element '" + val.element.name + "'");
+            warn("Skipping clear for locked element '", val.element.name, "'");
             continue;
         }
         val.rawValue.assign(val.rawValue.size(), 0);
     }
+    it->wirePayloadValid = false;
+    markChanged(config_, *it);
     return true;
 }
 
@@ -72,13 +220,36 @@ bool MdEngine::setTemplateLock(const std::string &name, const std::string &eleme
         if (val.element.name == element)
         {
             val.locked = locked;
+            markChanged(config_, *it);
             return true;
         }
     }
     return false;
 }
 
-bool MdEngine::sendTemplate(const std::string &name, std::ostream &os) const
+bool MdEngine::replaceTemplateValues(const std::string &name, ElementValues values)
+{
+    const auto it = std::find_if(config_.mdTemplates.begin(), config_.mdTemplates.end(),
+                                 [&](const auto &tpl) { return tpl.name == name; });
+    if (it == config_.mdTemplates.end() || values.size() != it->values.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        if (values[i].element.name != it->values[i].element.name ||
+            values[i].rawValue.size() != it->values[i].rawValue.size())
+        {
+            return false;
+        }
+    }
+    it->values = std::move(values);
+    it->wirePayloadValid = false;
+    markChanged(config_, *it);
+    return true;
+}
+
+bool MdEngine::sendTemplate(const std::string &name, std::ostream &os)
 {
     const auto it = std::find_if(config_.mdTemplates.begin(), config_.mdTemplates.end(),
                                  [&](const auto &tpl) { return tpl.name == name; });
@@ -87,28 +258,150 @@ bool MdEngine::sendTemplate(const std::string &name, std::ostream &os) const
         return false;
     }
 
-    std::vector<uint8_t> payload;
-    const DatasetDef *dataset = config_.datasetRegistry.find(it->datasetId);
-    if (dataset)
+    const auto &networkPayload = wirePayload(*it);
+
+    if (transport_ && transport_->isOpen())
     {
-        packDatasetToPayload(*dataset, it->values, payload);
+        MdHeader header;
+        header.sequenceCounter = sequenceCounter_.fetch_add(1u, std::memory_order_relaxed);
+        header.msgType = messageTypeFor(it->direction);
+        header.comId = it->comId;
+        header.replyTimeoutUs = it->direction == MdDirection::Request ? it->replyTimeoutUs : 0u;
+        header.sourceUri = it->sourceIp;
+        header.destinationUri = it->destinationIp;
+        transport_->setTrafficClass(it->qos, it->ttl);
+        const bool sent = transport_->send(header, networkPayload.data(), networkPayload.size(), it->destinationIp,
+                                           it->destinationPort);
+        if (recorder_)
+        {
+            recorder_->record(FlightEventKind::MdSend, it->comId, header.sequenceCounter, networkPayload.data(),
+                              networkPayload.size(), !sent);
+        }
+        if (!sent)
+        {
+            os << "MD send failed: " << it->name << std::endl;
+            return false;
+        }
+        auto &stats = statsFor(*it);
+        ++stats.sent;
+        stats.lastSend = std::chrono::steady_clock::now();
     }
 
-    std::vector<uint8_t> networkPayload;
-    if (config_.tauMarshaller && config_.tauMarshaller->valid())
+    os << "MD send: " << it->name << " COMID=" << it->comId << " bytes=" << networkPayload.size() << std::endl;
+    return true;
+}
+
+bool MdEngine::handleFrame(MdFrame &frame)
+{
+    const auto it = std::find_if(config_.mdTemplates.begin(), config_.mdTemplates.end(), [&](const auto &tpl) {
+        return tpl.comId == frame.header.comId && receives(tpl.direction, frame.header.msgType);
+    });
+    if (it == config_.mdTemplates.end())
     {
-        if (!config_.tauMarshaller->marshall(it->comId, payload, networkPayload))
+        if (recorder_)
+        {
+            recorder_->record(FlightEventKind::MdReceive, frame.header.comId, frame.header.sequenceCounter,
+                              frame.body->data(), frame.datasetSize, true);
+        }
+        const bool knownComId =
+            std::any_of(config_.mdTemplates.begin(), config_.mdTemplates.end(),
+                        [&](const auto &tpl) { return tpl.comId == frame.header.comId; });
+        if (knownComId)
+        {
+            static LogSite directionSite("md.unmatched-direction");
+            const auto type = static_cast<uint16_t>(frame.header.msgType);
+            warn(directionSite, "Ignoring '", static_cast<char>(type >> 8), static_cast<char>(type & 0xFFu),
+                 "' MD frame for ComId ", frame.header.comId, ": no template receives it");
+        }
+        else
         {
-            warn("tau_marshall failed for MD template '" + it->name + "', using host payload");
-            networkPayload = payload;
+            static LogSite unknownSite("md.unknown-comid");
+            warn(unknownSite, "Received MD frame for unknown ComId ", frame.header.comId);
         }
+        return false;
     }
-    else
+    auto &stats = statsFor(*it);
+    const auto now = std::chrono::steady_clock::now();
+    if (stats.lastReceive != std::chrono::steady_clock::time_point{})
     {
-        networkPayload = payload;
+        stats.interArrival.observe(now - stats.lastReceive);
     }
+    ++stats.received;
+    stats.lastReceive = now;
+    const bool applied = decodePayload(*it, frame.body->data(), frame.datasetSize);
+    if (recorder_)
+    {
+        recorder_->record(FlightEventKind::MdReceive, it->comId, frame.header.sequenceCounter, frame.body->data(),
+                          frame.datasetSize, !applied);
+    }
+    return applied;
+}
 
-    os << "MD send: " << it->name << " COMID=" << it->comId << " bytes=" << networkPayload.size() << std::endl;
+bool MdEngine::setTemplatePayload(const std::string &name, const uint8_t *networkPayload, std::size_t size)
+{
+    const auto it = std::find_if(config_.mdTemplates.begin(), config_.mdTemplates.end(),
+                                 [&](const auto &tpl) { return tpl.name == name; });
+    if (it == config_.mdTemplates.end())
+    {
+        return false;
+    }
+    const auto expected = wirePayload(*it).size();
+    if (size != expected)
+    {
+        warn("Raw payload for MD template '", name, "' has ", size, " bytes, expected ", expected);
+        return false;
+    }
+    return decodePayload(*it, networkPayload, size);
+}
+
+bool MdEngine::decodePayload(MdTemplate &tpl, const uint8_t *networkPayload, std::size_t size)
+{
+    const DatasetDef *dataset = config_.datasetRegistry.find(tpl.datasetId);
+    if (dataset == nullptr)
+    {
+        warn("Unknown dataset for MD template '", tpl.name, "': ", tpl.datasetId);
+        return false;
+    }
+
+    const uint8_t *hostData = networkPayload;
+    std::size_t hostSize = size;
+    MdBufferPool::Lease unmarshalled;
+    if (config_.tauMarshaller && config_.tauMarshaller->valid())
+    {
+        // The pointer variant leaves the received buffer at full size for the next datagram.
+        const auto *binding =
+            tpl.tauBinding != nullptr ? tpl.tauBinding : config_.tauMarshaller->binding(tpl.comId);
+        unmarshalled = pool_->acquire();
+        unmarshalled->resize(std::max(size, binding != nullptr ? binding->hostSize : 0u));
+        hostSize = unmarshalled->size();
+        if (binding == nullptr ||
+            !config_.tauMarshaller->unmarshall(*binding, networkPayload, size, unmarshalled->data(), hostSize))
+        {
+            ++statsFor(tpl).marshallFailures;
+            static LogSite unmarshallSite("md.unmarshall");
+            warn(unmarshallSite, "Failed to apply tau_unmarshall for MD template '", tpl.name, "'");
+            return false;
+        }
+        hostData = unmarshalled->data();
+    }
+
+    for (auto &val : tpl.values)
+    {
+        if (val.locked)
+        {
+            continue;
+        }
+        const auto elementSize = expectedSize(val.element) * std::max<std::size_t>(1, val.element.arrayLength);
+        if (val.element.offset + elementSize > hostSize)
+        {
+            static LogSite shortSite("md.decode-short");
+            warn(shortSite, "MD payload too small to decode element '", val.element.name, "'.");
+            continue;
+        }
+        val.rawValue.assign(hostData + val.element.offset, hostData + val.element.offset + elementSize);
+    }
+    tpl.wirePayloadValid = false;
+    markChanged(config_, tpl);
     return true;
 }
 
@@ -0,0 +1,332 @@
+#include "trdp/md_transport.hpp"
+
+#include "trdp/logging.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace trdp
+{
+namespace
+{
+constexpr int kSocketBufferBytes = 256 * 1024;
+const uint8_t kZeroPadding[4] = {0, 0, 0, 0};
+} // namespace
+
+MdBufferPool::Lease::Lease(MdBufferPool *pool, std::unique_ptr<std::vector<uint8_t>> buffer)
+    : pool_(pool), buffer_(std::move(buffer))
+{
+}
+
+MdBufferPool::Lease::~Lease()
+{
+    release();
+}
+
+MdBufferPool::Lease::Lease(Lease &&other) noexcept : pool_(other.pool_), buffer_(std::move(other.buffer_))
+{
+    other.pool_ = nullptr;
+}
+
+MdBufferPool::Lease &MdBufferPool::Lease::operator=(Lease &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        pool_ = other.pool_;
+        buffer_ = std::move(other.buffer_);
+        other.pool_ = nullptr;
+    }
+    return *this;
+}
+
+void MdBufferPool::Lease::release()
+{
+    if (pool_ != nullptr && buffer_)
+    {
+        pool_->giveBack(std::move(buffer_));
+    }
+    pool_ = nullptr;
+}
+
+MdBufferPool::MdBufferPool(std::size_t bufferCapacity) : bufferCapacity_(bufferCapacity) {}
+
+MdBufferPool::Lease MdBufferPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty())
+        {
+            auto buffer = std::move(idle_.back());
+            idle_.pop_back();
+            return Lease(this, std::move(buffer));
+        }
+    }
+
+    auto buffer = std::make_unique<std::vector<uint8_t>>();
+    buffer->reserve(bufferCapacity_);
+    return Lease(this, std::move(buffer));
+}
+
+std::size_t MdBufferPool::idleCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+void MdBufferPool::giveBack(std::unique_ptr<std::vector<uint8_t>> buffer)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(std::move(buffer));
+}
+
+MdTransport::MdTransport(std::shared_ptr<MdBufferPool> pool) : pool_(std::move(pool)) {}
+
+MdTransport::~MdTransport()
+{
+    close();
+}
+
+bool MdTransport::open(const std::string &localIp, uint16_t port)
+{
+    close();
+
+    fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0)
+    {
+        error("Failed to create MD socket: ", std::strerror(errno));
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+    setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, localIp.c_str(), &addr.sin_addr) != 1)
+    {
+        error("Invalid MD bind address '", localIp, "'");
+        close();
+        return false;
+    }
+
+    if (bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        error("Failed to bind MD socket to ", localIp, ":", port, ": ", std::strerror(errno));
+        close();
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+    localPort_ = ntohs(addr.sin_port);
+    info("MD transport bound to ", localIp, ":", localPort_);
+    return true;
+}
+
+bool MdTransport::setTrafficClass(uint8_t qos, uint8_t ttl)
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    // TRDP maps its 3 bit QoS onto the IP precedence bits, i.e. DSCP class selector CSn.
+    const int tos = (qos & 0x07) << 5;
+    if (trafficClassSet_ && tos == tos_ && ttl == ttl_)
+    {
+        return true;
+    }
+    const int hops = ttl;
+    const unsigned char multicastHops = ttl;
+    bool ok = setsockopt(fd_, IPPROTO_IP, IP_TOS, &tos, sizeof(tos)) == 0;
+    ok = setsockopt(fd_, IPPROTO_IP, IP_TTL, &hops, sizeof(hops)) == 0 && ok;
+    ok = setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &multicastHops, sizeof(multicastHops)) == 0 && ok;
+    if (!ok)
+    {
+        warn("Failed to apply QoS ", qos, " / TTL ", ttl, " to MD socket: ", std::strerror(errno));
+    }
+    tos_ = static_cast<uint8_t>(tos);
+    ttl_ = ttl;
+    trafficClassSet_ = ok;
+    return ok;
+}
+
+void MdTransport::close()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    localPort_ = 0;
+    trafficClassSet_ = false;
+}
+
+bool MdTransport::send(const MdHeader &header,
+                       const uint8_t *dataset,
+                       std::size_t datasetSize,
+                       const std::string &destinationIp,
+                       uint16_t destinationPort)
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    if (datasetSize > kMdMaxDataSize)
+    {
+        warn("MD dataset of ", datasetSize, " bytes exceeds the TRDP limit of ", kMdMaxDataSize);
+        return false;
+    }
+
+    sockaddr_in dest{};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(destinationPort != 0u ? destinationPort : kDefaultMdPort);
+    if (inet_pton(AF_INET, destinationIp.c_str(), &dest.sin_addr) != 1)
+    {
+        warn("Invalid MD destination '", destinationIp, "'");
+        return false;
+    }
+
+    MdHeader wireHeader = header;
+    wireHeader.datasetLength = static_cast<uint32_t>(datasetSize);
+    std::array<uint8_t, kMdHeaderSize> headerBytes{};
+    encodeMdHeader(wireHeader, headerBytes);
+
+    iovec iov[3];
+    std::size_t iovCount = 0;
+    iov[iovCount++] = {headerBytes.data(), headerBytes.size()};
+    if (datasetSize > 0)
+    {
+        iov[iovCount++] = {const_cast<uint8_t *>(dataset), datasetSize};
+    }
+    const auto padding = paddingFor(datasetSize);
+    if (padding > 0)
+    {
+        iov[iovCount++] = {const_cast<uint8_t *>(kZeroPadding), padding};
+    }
+
+    msghdr msg{};
+    msg.msg_name = &dest;
+    msg.msg_namelen = sizeof(dest);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovCount;
+
+    const auto expected = kMdHeaderSize + datasetSize + padding;
+    const ssize_t sent = sendmsg(fd_, &msg, 0);
+    if (sent < 0 || static_cast<std::size_t>(sent) != expected)
+    {
+        warn("MD sendmsg to ", destinationIp, " failed: ", std::strerror(errno));
+        return false;
+    }
+    if (capture_)
+    {
+        CaptureAddress address;
+        if (!parseIpv4(header.sourceUri, address.sourceIp))
+        {
+            address.sourceIp = capture_->localIp();
+        }
+        address.sourcePort = localPort_;
+        address.destinationIp = ntohl(dest.sin_addr.s_addr);
+        address.destinationPort = ntohs(dest.sin_port);
+        address.tos = tos_;
+        address.ttl = ttl_;
+        const CaptureSegment segments[3] = {
+            {headerBytes.data(), headerBytes.size()}, {dataset, datasetSize}, {kZeroPadding, padding}};
+        capture_->capture(address, segments, 3);
+    }
+    return true;
+}
+
+bool MdTransport::receive(MdFrame &frame, int timeoutMs)
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+
+    pollfd pfd{fd_, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) <= 0 || (pfd.revents & POLLIN) == 0)
+    {
+        return false;
+    }
+
+    std::array<uint8_t, kMdHeaderSize> headerBytes{};
+    auto body = pool_->acquire();
+    if (body->size() < kMdMaxDataSize + 4u)
+    {
+        body->resize(kMdMaxDataSize + 4u);
+    }
+
+    iovec iov[2];
+    iov[0] = {headerBytes.data(), headerBytes.size()};
+    iov[1] = {body->data(), body->size()};
+
+    sockaddr_in source{};
+    msghdr msg{};
+    msg.msg_name = &source;
+    msg.msg_namelen = sizeof(source);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    const ssize_t received = recvmsg(fd_, &msg, 0);
+    if (received < 0)
+    {
+        static LogSite recvSite("md_transport.recv");
+        warn(recvSite, "MD recvmsg failed: ", std::strerror(errno));
+        return false;
+    }
+    if ((msg.msg_flags & MSG_TRUNC) != 0)
+    {
+        static LogSite truncatedSite("md_transport.truncated");
+        warn(truncatedSite, "Dropping truncated MD datagram");
+        return false;
+    }
+    if (capture_)
+    {
+        // Captured before validation, so rejected frames show up too.
+        const auto size = static_cast<std::size_t>(received);
+        CaptureAddress address;
+        address.sourceIp = ntohl(source.sin_addr.s_addr);
+        address.sourcePort = ntohs(source.sin_port);
+        address.destinationIp = capture_->localIp();
+        address.destinationPort = localPort_;
+        const CaptureSegment segments[2] = {{headerBytes.data(), std::min(size, kMdHeaderSize)},
+                                            {body->data(), size > kMdHeaderSize ? size - kMdHeaderSize : 0}};
+        capture_->capture(address, segments, 2);
+    }
+    if (!decodeMdHeader(headerBytes.data(), static_cast<std::size_t>(received), frame.header))
+    {
+        static LogSite headerSite("md_transport.header");
+        warn(headerSite, "Dropping MD datagram with invalid header");
+        return false;
+    }
+
+    const auto bodyBytes = static_cast<std::size_t>(received) - kMdHeaderSize;
+    if (frame.header.datasetLength > bodyBytes)
+    {
+        static LogSite shortSite("md_transport.short");
+        warn(shortSite, "Dropping MD datagram shorter than its dataset length (", bodyBytes, " < ",
+             frame.header.datasetLength, ")");
+        return false;
+    }
+
+    char sourceIp[INET_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &source.sin_addr, sourceIp, sizeof(sourceIp));
+    frame.sourceIp = sourceIp;
+    frame.sourcePort = ntohs(source.sin_port);
+    frame.body = std::move(body);
+    frame.datasetSize = frame.header.datasetLength;
+    return true;
+}
+
+} // namespace trdp
@@ -0,0 +1,71 @@
+#include "trdp/metrics.hpp"
+
+#include <algorithm>
+
+namespace trdp
+{
+
+uint64_t Counter::value() const
+{
+    uint64_t total = 0;
+    for (const auto &slot : slots_)
+    {
+        total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram::Histogram(std::vector<uint64_t> upperBoundsUs) : bounds_(std::move(upperBoundsUs))
+{
+    std::sort(bounds_.begin(), bounds_.end());
+    bounds_.erase(std::unique(bounds_.begin(), bounds_.end()), bounds_.end());
+    // bounds + 1 buckets, then the sum
+    linesPerSlot_ = (bounds_.size() + 2 + kCellsPerLine - 1) / kCellsPerLine;
+    lines_ = std::vector<Line>(kMetricSlots * linesPerSlot_);
+}
+
+std::atomic<uint64_t> &Histogram::cell(std::size_t slot, std::size_t index)
+{
+    return lines_[slot * linesPerSlot_ + index / kCellsPerLine].cells[index % kCellsPerLine];
+}
+
+const std::atomic<uint64_t> &Histogram::cell(std::size_t slot, std::size_t index) const
+{
+    return lines_[slot * linesPerSlot_ + index / kCellsPerLine].cells[index % kCellsPerLine];
+}
+
+void Histogram::observe(uint64_t us)
+{
+    const auto bucket = static_cast<std::size_t>(std::lower_bound(bounds_.begin(), bounds_.end(), us) - bounds_.begin());
+    const auto slot = metricSlot();
+    cell(slot, bucket).fetch_add(1, std::memory_order_relaxed);
+    cell(slot, bounds_.size() + 1).fetch_add(us, std::memory_order_relaxed);
+}
+
+void Histogram::observe(std::chrono::steady_clock::duration duration)
+{
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    observe(static_cast<uint64_t>(std::max<int64_t>(us, 0)));
+}
+
+Histogram::Snapshot Histogram::snapshot() const
+{
+    Snapshot snap;
+    snap.upperBoundsUs = bounds_;
+    snap.buckets.assign(bounds_.size() + 1, 0);
+    for (std::size_t slot = 0; slot < kMetricSlots; ++slot)
+    {
+        for (std::size_t i = 0; i < snap.buckets.size(); ++i)
+        {
+            snap.buckets[i] += cell(slot, i).load(std::memory_order_relaxed);
+        }
+        snap.sumUs += cell(slot, bounds_.size() + 1).load(std::memory_order_relaxed);
+    }
+    for (const auto bucket : snap.buckets)
+    {
+        snap.count += bucket;
+    }
+    return snap;
+}
+
+} // namespace trdp
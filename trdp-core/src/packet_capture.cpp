@@ -0,0 +1,303 @@
+#include "trdp/packet_capture.hpp"
+
+#include "trdp/logging.hpp"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace trdp
+{
+
+namespace
+{
+constexpr std::size_t kEthernetHeaderSize = 14;
+constexpr std::size_t kIpv4HeaderSize = 20;
+constexpr std::size_t kUdpHeaderSize = 8;
+constexpr std::size_t kFrameHeaderSize = kEthernetHeaderSize + kIpv4HeaderSize + kUdpHeaderSize;
+constexpr std::size_t kEnhancedPacketOverhead = 32; // block header, timestamp, lengths, trailer
+constexpr uint16_t kLinkTypeEthernet = 1;
+
+void putU16(uint8_t *out, uint16_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+}
+
+void putU32(uint8_t *out, uint32_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+/** pcapng block fields are written in host order; the section header's magic tells readers which. */
+void putHost32(uint8_t *out, uint32_t value)
+{
+    std::memcpy(out, &value, sizeof(value));
+}
+
+void putMac(uint8_t *out, uint32_t ip)
+{
+    if ((ip >> 28) == 0xEu)
+    {
+        // IPv4 multicast: 01:00:5e followed by the low 23 bits of the group address.
+        out[0] = 0x01;
+        out[1] = 0x00;
+        out[2] = 0x5E;
+        out[3] = static_cast<uint8_t>((ip >> 16) & 0x7Fu);
+        out[4] = static_cast<uint8_t>(ip >> 8);
+        out[5] = static_cast<uint8_t>(ip);
+        return;
+    }
+    if (ip == 0xFFFFFFFFu)
+    {
+        std::memset(out, 0xFF, 6);
+        return;
+    }
+    out[0] = 0x02; // locally administered
+    out[1] = 0x00;
+    putU32(out + 2, ip);
+}
+
+uint16_t ipv4Checksum(const uint8_t *header)
+{
+    uint32_t sum = 0;
+    for (std::size_t i = 0; i < kIpv4HeaderSize; i += 2)
+    {
+        sum += static_cast<uint32_t>((header[i] << 8) | header[i + 1]);
+    }
+    while ((sum >> 16) != 0)
+    {
+        sum = (sum & 0xFFFFu) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+std::size_t padTo4(std::size_t size)
+{
+    return (size + 3u) & ~std::size_t{3};
+}
+} // namespace
+
+bool parseIpv4(const std::string &text, uint32_t &out)
+{
+    in_addr addr{};
+    if (inet_pton(AF_INET, text.c_str(), &addr) != 1)
+    {
+        return false;
+    }
+    out = ntohl(addr.s_addr);
+    return true;
+}
+
+PacketCapture::PacketCapture(std::size_t bufferBytes) : capacity_(bufferBytes) {}
+
+PacketCapture::~PacketCapture()
+{
+    close();
+}
+
+bool PacketCapture::open(const std::string &path)
+{
+    close();
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        error("Failed to open capture file ", path, ": ", std::strerror(errno));
+        return false;
+    }
+
+    // Section header block, then one Ethernet interface with nanosecond timestamps.
+    uint8_t header[28 + 32] = {};
+    putHost32(header + 0, 0x0A0D0D0Au);
+    putHost32(header + 4, 28);
+    putHost32(header + 8, 0x1A2B3C4Du);
+    const uint16_t version[2] = {1, 0};
+    std::memcpy(header + 12, version, sizeof(version));
+    std::memset(header + 16, 0xFF, 8); // section length unknown
+    putHost32(header + 24, 28);
+
+    uint8_t *idb = header + 28;
+    putHost32(idb + 0, 1);
+    putHost32(idb + 4, 32);
+    const uint16_t linkType[2] = {kLinkTypeEthernet, 0}; // link type, reserved
+    std::memcpy(idb + 8, linkType, sizeof(linkType));
+    putHost32(idb + 12, 0);             // no snap length limit
+    const uint16_t tsresol[2] = {9, 1}; // option if_tsresol, length 1
+    std::memcpy(idb + 16, tsresol, sizeof(tsresol));
+    idb[20] = 9; // 10^-9 s
+    putHost32(idb + 24, 0); // opt_endofopt
+    putHost32(idb + 28, 32);
+
+    if (std::fwrite(header, 1, sizeof(header), file) != sizeof(header))
+    {
+        error("Failed to write capture file ", path, ": ", std::strerror(errno));
+        std::fclose(file);
+        return false;
+    }
+
+    {
+        // capture() may already run on the MD receive thread.
+        std::lock_guard<std::mutex> lock(mutex_);
+        file_ = file;
+        path_ = path;
+        active_.data.reset(new uint8_t[capacity_]);
+        writing_.data.reset(new uint8_t[capacity_]);
+        active_.used = 0;
+        writing_.used = 0;
+        pendingWrite_ = false;
+        stopping_ = false;
+    }
+    writer_ = std::thread([this]() { run(); });
+    info("Capturing TRDP traffic to ", path);
+    return true;
+}
+
+void PacketCapture::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_ == nullptr || stopping_)
+        {
+            return;
+        }
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    info("Captured ", packets(), " datagrams to ", path_, " (", dropped(), " dropped)");
+}
+
+bool PacketCapture::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_ != nullptr && !stopping_;
+}
+
+void PacketCapture::capture(const CaptureAddress &address, const CaptureSegment *segments, std::size_t count)
+{
+    std::size_t payloadSize = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        payloadSize += segments[i].size;
+    }
+    const std::size_t frameSize = kFrameHeaderSize + payloadSize;
+    const std::size_t blockSize = kEnhancedPacketOverhead + padTo4(frameSize);
+    const auto timeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                  std::chrono::system_clock::now().time_since_epoch())
+                                                  .count());
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (file_ == nullptr || stopping_ || blockSize > capacity_)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (active_.used + blockSize > capacity_)
+    {
+        if (pendingWrite_)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::swap(active_, writing_);
+        pendingWrite_ = true;
+        wake_.notify_one();
+    }
+
+    uint8_t *block = active_.data.get() + active_.used;
+    putHost32(block + 0, 6); // enhanced packet block
+    putHost32(block + 4, static_cast<uint32_t>(blockSize));
+    putHost32(block + 8, 0); // interface
+    putHost32(block + 12, static_cast<uint32_t>(timeNs >> 32));
+    putHost32(block + 16, static_cast<uint32_t>(timeNs));
+    putHost32(block + 20, static_cast<uint32_t>(frameSize));
+    putHost32(block + 24, static_cast<uint32_t>(frameSize));
+
+    uint8_t *frame = block + 28;
+    putMac(frame + 0, address.destinationIp);
+    putMac(frame + 6, address.sourceIp);
+    putU16(frame + 12, 0x0800);
+
+    uint8_t *ip = frame + kEthernetHeaderSize;
+    ip[0] = 0x45;
+    ip[1] = address.tos;
+    // Datagrams above 64 KiB cannot occur: MD datasets are limited to 65388 bytes.
+    putU16(ip + 2, static_cast<uint16_t>(kIpv4HeaderSize + kUdpHeaderSize + payloadSize));
+    putU16(ip + 4, ipIdentification_++);
+    putU16(ip + 6, 0);
+    ip[8] = address.ttl;
+    ip[9] = 17; // UDP
+    putU16(ip + 10, 0);
+    putU32(ip + 12, address.sourceIp);
+    putU32(ip + 16, address.destinationIp);
+    putU16(ip + 10, ipv4Checksum(ip));
+
+    uint8_t *udp = ip + kIpv4HeaderSize;
+    putU16(udp + 0, address.sourcePort);
+    putU16(udp + 2, address.destinationPort);
+    putU16(udp + 4, static_cast<uint16_t>(kUdpHeaderSize + payloadSize));
+    putU16(udp + 6, 0); // no checksum, allowed over IPv4
+
+    uint8_t *payload = udp + kUdpHeaderSize;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (segments[i].size > 0)
+        {
+            std::memcpy(payload, segments[i].data, segments[i].size);
+            payload += segments[i].size;
+        }
+    }
+    std::memset(payload, 0, padTo4(frameSize) - frameSize);
+    putHost32(block + blockSize - 4, static_cast<uint32_t>(blockSize));
+
+    active_.used += blockSize;
+    packets_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PacketCapture::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        wake_.wait_for(lock, std::chrono::milliseconds(200), [this]() { return pendingWrite_ || stopping_; });
+        if (!pendingWrite_ && active_.used > 0)
+        {
+            std::swap(active_, writing_);
+            pendingWrite_ = true;
+        }
+        if (pendingWrite_)
+        {
+            lock.unlock();
+            writeBuffer(writing_);
+            lock.lock();
+            writing_.used = 0;
+            pendingWrite_ = false;
+            continue; // the active buffer may have filled meanwhile
+        }
+        if (stopping_)
+        {
+            return;
+        }
+    }
+}
+
+void PacketCapture::writeBuffer(const Buffer &buffer)
+{
+    if (std::fwrite(buffer.data.get(), 1, buffer.used, file_) != buffer.used)
+    {
+        static LogSite writeSite("packet_capture.write");
+        error(writeSite, "Failed to write capture file ", path_, ": ", std::strerror(errno));
+    }
+    std::fflush(file_);
+}
+
+} // namespace trdp
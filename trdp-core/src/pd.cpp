@@ -1,15 +1,46 @@
 #include "trdp/pd.hpp"
 
+#include "trdp/config_reload.hpp"
 #include "trdp/dataset.hpp"
 #include "trdp/logging.hpp"
 #include "trdp/tau.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 namespace trdp
 {
 
-PdEngine::PdEngine(TrdpConfig &config) : config_(config) {}
+namespace
+{
+template <typename Telegram>
+const TauBinding *resolveBinding(const TauMarshaller &marshaller, const Telegram &telegram)
+{
+    return telegram.tauBinding != nullptr ? telegram.tauBinding : marshaller.binding(telegram.comId);
+}
+
+// Per-thread host-order staging buffer used between packing and marshalling. It only grows,
+// so steady-state cycles do not allocate.
+std::vector<uint8_t> &scratchBuffer(std::size_t size)
+{
+    thread_local std::vector<uint8_t> buffer;
+    if (buffer.size() < size)
+    {
+        buffer.resize(size);
+    }
+    return buffer;
+}
+} // namespace
+
+PdEngine::PdEngine(TrdpConfig &config) : config_(config)
+{
+    resetStats();
+}
+
+bool PdEngine::marshallingEnabled() const
+{
+    return config_.tauMarshaller && config_.tauMarshaller->valid();
+}
 
 void PdEngine::listPublish(std::ostream &os) const
 {
@@ -17,7 +48,7 @@ void PdEngine::listPublish(std::ostream &os) const
     {
         const auto &pub = config_.pdPublish[i];
         os << "#" << i << " COMID=" << pub.comId << " dataset=" << pub.datasetId << " dest=" << pub.destinationIp
-           << " cycle=" << pub.cycleTimeMs << "ms" << std::endl;
+           << " cycle=" << pub.cycleTimeMs << "ms qos=" << pub.priority << " ttl=" << static_cast<int>(pub.ttl) << std::endl;
         for (const auto &val : pub.values)
         {
             os << "    " << val.element.name << " (" << toString(val.element.type) << ") len="
@@ -36,6 +67,29 @@ void PdEngine::listSubscribe(std::ostream &os) const
     }
 }
 
+void PdEngine::listStats(std::ostream &os, std::chrono::steady_clock::time_point now) const
+{
+    for (std::size_t i = 0; i < config_.pdPublish.size(); ++i)
+    {
+        const auto &stats = publishStats_[i];
+        os << "publish #" << i << " COMID=" << config_.pdPublish[i].comId << " sent=" << stats.sent
+           << " marshallFailures=" << stats.marshallFailures << std::endl;
+        printDistribution(os, "send jitter", stats.sendJitter.snapshot(), stats.sendJitter.maxUs());
+    }
+    for (std::size_t i = 0; i < config_.pdSubscribe.size(); ++i)
+    {
+        const auto &stats = subscribeStats_[i];
+        os << "subscribe #" << i << " COMID=" << config_.pdSubscribe[i].comId << " received=" << stats.received
+           << " timeouts=" << stats.timeouts << " marshallFailures=" << stats.marshallFailures;
+        if (stats.lastReceive != std::chrono::steady_clock::time_point{})
+        {
+            os << " lastReceive=" << formatDuration(now - stats.lastReceive) << " ago";
+        }
+        os << (stats.timedOut ? " TIMED OUT" : "") << std::endl;
+        printDistribution(os, "inter-arrival", stats.interArrival.snapshot(), stats.interArrival.maxUs());
+    }
+}
+
 bool PdEngine::setPublishValue(std::size_t index, const std::string &element, const std::string &value)
 {
     if (index >= config_.pdPublish.size())
@@ -48,10 +102,15 @@ bool PdEngine::setPublishValue(std::size_t index, const std::string &element, co
     {
         if (val.element.name == element)
         {
-            return assignValue(val, value);
+            if (!assignValue(val, value))
+            {
+                return false;
+            }
+            markChanged(config_, pub);
+            return true;
         }
     }
-    warn("Element '" + element + "' not found in publish dataset.");
+    warn("Element '", element, "' not found in publish dataset.");
     return false;
 }
 
@@ -66,11 +125,12 @@ bool PdEngine::clearPublish(std::size_t index)
     {
         if (val.locked)
         {
-            warn("Skipping clear for locked element '" + val.element.name + "'");
+            warn("Skipping clear for locked element '", val.element.name, "'");
             continue;
         }
         val.rawValue.assign(val.rawValue.size(), 0);
     }
+    markChanged(config_, pub);
     return true;
 }
 
@@ -86,75 +146,318 @@ bool PdEngine::setPublishLock(std::size_t index, const std::string &element, boo
         if (val.element.name == element)
         {
             val.locked = locked;
+            markChanged(config_, pub);
             return true;
         }
     }
     return false;
 }
 
-bool PdEngine::buildPublishPayload(std::size_t index, std::vector<uint8_t> &networkPayload) const
+bool PdEngine::replacePublishValues(std::size_t index, ElementValues values)
 {
     if (index >= config_.pdPublish.size())
     {
         return false;
     }
+    auto &pub = config_.pdPublish[index];
+    if (values.size() != pub.values.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        if (values[i].element.name != pub.values[i].element.name ||
+            values[i].rawValue.size() != pub.values[i].rawValue.size())
+        {
+            return false;
+        }
+    }
+    pub.values = std::move(values);
+    markChanged(config_, pub);
+    return true;
+}
+
+bool PdEngine::buildPublishPayload(std::size_t index, std::vector<uint8_t> &networkPayload)
+{
+    if (index >= config_.pdPublish.size())
+    {
+        return false;
+    }
+    const auto *dataset = config_.datasetRegistry.find(config_.pdPublish[index].datasetId);
+    const auto hostSize = dataset != nullptr ? dataset->payloadSize() : 0u;
+
+    std::size_t written = 0;
+    networkPayload.resize(std::max(publishPayloadSize(index), hostSize));
+    if (!buildPublishPayload(index, networkPayload.data(), networkPayload.size(), written))
+    {
+        return false;
+    }
+    networkPayload.resize(written);
+    return true;
+}
+
+std::size_t PdEngine::publishPayloadSize(std::size_t index) const
+{
+    if (index >= config_.pdPublish.size())
+    {
+        return 0u;
+    }
 
     const auto &pub = config_.pdPublish[index];
+    if (marshallingEnabled())
+    {
+        const auto *binding = resolveBinding(*config_.tauMarshaller, pub);
+        if (binding != nullptr && binding->networkSize != 0u)
+        {
+            return binding->networkSize;
+        }
+    }
     const auto *dataset = config_.datasetRegistry.find(pub.datasetId);
-    if (dataset == nullptr)
+    return dataset != nullptr ? dataset->payloadSize() : 0u;
+}
+
+bool PdEngine::buildPublishPayload(std::size_t index, uint8_t *out, std::size_t capacity, std::size_t &written)
+{
+    if (index >= config_.pdPublish.size())
     {
-        warn("Unknown dataset for publish payload: " + std::to_string(pub.datasetId));
         return false;
     }
 
-    std::vector<uint8_t> hostPayload;
-    packDatasetToPayload(*dataset, pub.values, hostPayload);
+    auto &pub = config_.pdPublish[index];
+    const auto *dataset = config_.datasetRegistry.find(pub.datasetId);
+    if (dataset == nullptr)
+    {
+        static LogSite datasetSite("pd.publish-dataset");
+        warn(datasetSite, "Unknown dataset for publish payload: ", pub.datasetId);
+        return false;
+    }
 
-    if (config_.tauMarshaller && config_.tauMarshaller->valid())
+    const auto hostSize = dataset->payloadSize();
+    if (marshallingEnabled())
     {
-        std::vector<uint8_t> marshalled;
-        if (config_.tauMarshaller->marshall(pub.comId, hostPayload, marshalled))
+        auto &hostPayload = scratchBuffer(hostSize);
+        packDatasetToPayload(*dataset, pub.values, hostPayload.data(), hostSize);
+
+        const auto *binding = resolveBinding(*config_.tauMarshaller, pub);
+        std::size_t networkSize = capacity;
+        if (binding != nullptr &&
+            config_.tauMarshaller->marshall(*binding, hostPayload.data(), hostSize, out, networkSize))
         {
-            networkPayload = std::move(marshalled);
+            written = networkSize;
             return true;
         }
-        warn("Falling back to raw payload after failed tau_marshall for ComId " + std::to_string(pub.comId));
+        ++publishStats_[index].marshallFailures;
+        static LogSite fallbackSite("pd.marshall-fallback");
+        warn(fallbackSite, "Falling back to raw payload after failed tau_marshall for ComId ", pub.comId);
+        if (capacity < hostSize)
+        {
+            return false;
+        }
+        std::copy_n(hostPayload.data(), hostSize, out);
+        written = hostSize;
+        return true;
     }
 
-    networkPayload = std::move(hostPayload);
+    if (!packDatasetToPayload(*dataset, pub.values, out, capacity))
+    {
+        return false;
+    }
+    written = hostSize;
+    return true;
+}
+
+bool PdEngine::setPublishPayload(std::size_t index, const uint8_t *networkPayload, std::size_t size)
+{
+    if (index >= config_.pdPublish.size())
+    {
+        return false;
+    }
+
+    auto &pub = config_.pdPublish[index];
+    const auto expected = publishPayloadSize(index);
+    if (size != expected)
+    {
+        warn("Raw payload for publish ComId ", pub.comId, " has ", size, " bytes, expected ", expected);
+        return false;
+    }
+
+    const uint8_t *hostData = networkPayload;
+    std::size_t hostSize = size;
+    if (marshallingEnabled())
+    {
+        const auto *binding = resolveBinding(*config_.tauMarshaller, pub);
+        const auto *dataset = config_.datasetRegistry.find(pub.datasetId);
+        auto &hostPayload = scratchBuffer(std::max({size, dataset != nullptr ? dataset->payloadSize() : 0u,
+                                                    binding != nullptr ? binding->hostSize : 0u}));
+        hostSize = hostPayload.size();
+        if (binding == nullptr ||
+            !config_.tauMarshaller->unmarshall(*binding, networkPayload, size, hostPayload.data(), hostSize))
+        {
+            ++publishStats_[index].marshallFailures;
+            warn("Failed to apply tau_unmarshall for publish ComId ", pub.comId);
+            return false;
+        }
+        hostData = hostPayload.data();
+    }
+
+    for (auto &val : pub.values)
+    {
+        if (val.locked)
+        {
+            continue;
+        }
+        const auto elementSize = expectedSize(val.element) * std::max<std::size_t>(1, val.element.arrayLength);
+        if (val.element.offset + elementSize > hostSize)
+        {
+            warn("Publish payload too small to decode element '", val.element.name, "'.");
+            continue;
+        }
+        val.rawValue.assign(hostData + val.element.offset, hostData + val.element.offset + elementSize);
+    }
+    markChanged(config_, pub);
     return true;
 }
 
 bool PdEngine::updateSubscribeValues(std::size_t index, const std::vector<uint8_t> &networkPayload)
+{
+    return updateSubscribeValues(index, networkPayload.data(), networkPayload.size());
+}
+
+bool PdEngine::updateSubscribeValues(std::size_t index, const uint8_t *networkPayload, std::size_t size)
 {
     if (index >= config_.pdSubscribe.size())
     {
         return false;
     }
+    const bool applied = applySubscribePayload(index, networkPayload, size);
+    if (recorder_)
+    {
+        recorder_->record(FlightEventKind::PdReceive, config_.pdSubscribe[index].comId,
+                          static_cast<uint32_t>(subscribeStats_[index].received), networkPayload, size, !applied);
+    }
+    return applied;
+}
 
+bool PdEngine::applySubscribePayload(std::size_t index, const uint8_t *networkPayload, std::size_t size)
+{
     auto &sub = config_.pdSubscribe[index];
     const auto *dataset = config_.datasetRegistry.find(sub.datasetId);
     if (dataset == nullptr)
     {
-        warn("Unknown dataset for subscribe payload: " + std::to_string(sub.datasetId));
+        static LogSite datasetSite("pd.subscribe-dataset");
+        warn(datasetSite, "Unknown dataset for subscribe payload: ", sub.datasetId);
         return false;
     }
 
-    std::vector<uint8_t> hostPayload;
-    if (config_.tauMarshaller && config_.tauMarshaller->valid())
+    if (marshallingEnabled())
     {
-        if (!config_.tauMarshaller->unmarshall(sub.comId, networkPayload, hostPayload))
+        const auto *binding = resolveBinding(*config_.tauMarshaller, sub);
+        auto &hostPayload = scratchBuffer(std::max({size, dataset->payloadSize(), binding != nullptr ? binding->hostSize : 0u}));
+        std::size_t hostSize = hostPayload.size();
+        if (binding == nullptr ||
+            !config_.tauMarshaller->unmarshall(*binding, networkPayload, size, hostPayload.data(), hostSize))
+        {
+            ++subscribeStats_[index].marshallFailures;
+            static LogSite unmarshallSite("pd.subscribe-unmarshall");
+            warn(unmarshallSite, "Failed to apply tau_unmarshall for subscribe ComId ", sub.comId);
+            return false;
+        }
+        if (!unpackPayloadToDataset(*dataset, hostPayload.data(), hostSize, sub.lastValues))
         {
-            warn("Failed to apply tau_unmarshall for subscribe ComId " + std::to_string(sub.comId));
             return false;
         }
+        markReceived(index);
+        return true;
+    }
+
+    if (!unpackPayloadToDataset(*dataset, networkPayload, size, sub.lastValues))
+    {
+        return false;
+    }
+    markReceived(index);
+    return true;
+}
+
+void PdEngine::markReceived(std::size_t index)
+{
+    auto &stats = subscribeStats_[index];
+    const auto now = std::chrono::steady_clock::now();
+    if (stats.lastReceive != std::chrono::steady_clock::time_point{})
+    {
+        stats.interArrival.observe(now - stats.lastReceive);
+    }
+    ++stats.received;
+    stats.lastReceive = now;
+    stats.timedOut = false;
+    markChanged(config_, config_.pdSubscribe[index]);
+}
+
+std::size_t PdEngine::checkTimeouts(std::chrono::steady_clock::time_point now)
+{
+    std::size_t expired = 0;
+    for (std::size_t i = 0; i < config_.pdSubscribe.size(); ++i)
+    {
+        const auto &sub = config_.pdSubscribe[i];
+        auto &stats = subscribeStats_[i];
+        if (stats.supervisedSince == std::chrono::steady_clock::time_point{})
+        {
+            stats.supervisedSince = now;
+            continue;
+        }
+        if (stats.timedOut || sub.timeoutMs == 0 ||
+            now - stats.silentSince() < std::chrono::milliseconds(sub.timeoutMs))
+        {
+            continue;
+        }
+        stats.timedOut = true;
+        ++stats.timeouts;
+        ++expired;
+        if (recorder_)
+        {
+            recorder_->record(FlightEventKind::PdTimeout, sub.comId, static_cast<uint32_t>(stats.timeouts), nullptr, 0);
+        }
     }
-    else
+    return expired;
+}
+
+void PdEngine::recordSent(std::size_t index,
+                          std::chrono::steady_clock::time_point now,
+                          const uint8_t *networkPayload,
+                          std::size_t size)
+{
+    if (index >= publishStats_.size())
     {
-        hostPayload = networkPayload;
+        return;
     }
+    auto &stats = publishStats_[index];
+    if (stats.lastSend != std::chrono::steady_clock::time_point{})
+    {
+        const auto period = now - stats.lastSend;
+        const auto cycle = std::chrono::milliseconds(config_.pdPublish[index].cycleTimeMs);
+        stats.sendJitter.observe(period > cycle ? period - cycle : cycle - period);
+    }
+    ++stats.sent;
+    stats.lastSend = now;
+    if (recorder_)
+    {
+        recorder_->record(FlightEventKind::PdSend, config_.pdPublish[index].comId, static_cast<uint32_t>(stats.sent),
+                          networkPayload, size);
+    }
+}
 
-    return unpackPayloadToDataset(*dataset, hostPayload, sub.lastValues);
+void PdEngine::resetStats()
+{
+    publishStats_.assign(config_.pdPublish.size(), TelegramStats{});
+    subscribeStats_.assign(config_.pdSubscribe.size(), TelegramStats{});
+}
+
+void PdEngine::carryStats(const ConfigDiff &diff)
+{
+    publishStats_ = trdp::carryStats(publishStats_, diff.publishFrom);
+    subscribeStats_ = trdp::carryStats(subscribeStats_, diff.subscribeFrom);
+    // A diff that does not describe the current telegrams must not leave the vectors short.
+    publishStats_.resize(config_.pdPublish.size());
+    subscribeStats_.resize(config_.pdSubscribe.size());
 }
 
 void PdEngine::forEachPublish(const std::function<void(PdPublishTelegram &)> &fn)
@@ -162,6 +465,7 @@ void PdEngine::forEachPublish(const std::function<void(PdPublishTelegram &)> &fn
     for (auto &pub : config_.pdPublish)
     {
         fn(pub);
+        markChanged(config_, pub);
     }
 }
 
@@ -170,6 +474,7 @@ void PdEngine::forEachSubscribe(const std::function<void(PdSubscribeTelegram &)>
     for (auto &sub : config_.pdSubscribe)
     {
         fn(sub);
+        markChanged(config_, sub);
     }
 }
 
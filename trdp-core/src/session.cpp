@@ -2,7 +2,9 @@
 
 #include "trdp/logging.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <thread>
 
 #ifdef TRDP_AVAILABLE
@@ -15,6 +17,21 @@ extern "C" {
 namespace trdp
 {
 
+SessionConfig SessionConfig::fromDeviceConfig(const TrdpConfig &config)
+{
+    SessionConfig cfg;
+    cfg.pdPort = config.pdDefaults.port;
+    cfg.mdPort = config.mdDefaults.port;
+    cfg.timeoutUs = config.pdDefaults.timeoutUs;
+    cfg.cycleTimeUs = config.process.cycleTimeUs;
+    cfg.processPriority = config.process.priority;
+    cfg.pdQos = config.pdDefaults.qos;
+    cfg.pdTtl = config.pdDefaults.ttl;
+    cfg.mdQos = config.mdDefaults.qos;
+    cfg.mdTtl = config.mdDefaults.ttl;
+    return cfg;
+}
+
 TrdpSession::TrdpSession(SessionConfig cfg) : config_(std::move(cfg)) {}
 
 TrdpSession::~TrdpSession()
@@ -29,7 +46,7 @@ bool TrdpSession::init()
     TRDP_ERR_T err = tlc_init(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
     if (err != TRDP_NO_ERR)
     {
-        error("tlc_init failed with error code " + std::to_string(err));
+        error("tlc_init failed with error code ", err);
         return false;
     }
     appHandle_ = appHandle;
@@ -50,14 +67,33 @@ bool TrdpSession::open()
         return false;
     }
 #ifdef TRDP_AVAILABLE
-    TRDP_ERR_T err = tlc_openSession(&appHandle_, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+    TRDP_PD_CONFIG_T pdConfig{};
+    pdConfig.sendParam.qos = config_.pdQos;
+    pdConfig.sendParam.ttl = config_.pdTtl;
+    pdConfig.timeout = config_.timeoutUs;
+    pdConfig.toBehavior = TRDP_TO_SET_TO_ZERO;
+    pdConfig.port = config_.pdPort;
+
+    TRDP_MD_CONFIG_T mdConfig{};
+    mdConfig.sendParam.qos = config_.mdQos;
+    mdConfig.sendParam.ttl = config_.mdTtl;
+    mdConfig.udpPort = config_.mdPort;
+    mdConfig.tcpPort = config_.mdPort;
+
+    TRDP_PROCESS_CONFIG_T processConfig{};
+    std::snprintf(processConfig.hostName, sizeof(processConfig.hostName), "%s", config_.processName.c_str());
+    processConfig.cycleTime = config_.cycleTimeUs;
+    processConfig.priority = config_.processPriority;
+
+    TRDP_ERR_T err =
+        tlc_openSession(&appHandle_, vos_dottedIP(config_.localIp.c_str()), 0u, nullptr, &pdConfig, &mdConfig, &processConfig);
     if (err != TRDP_NO_ERR)
     {
-        error("tlc_openSession failed with error code " + std::to_string(err));
+        error("tlc_openSession failed with error code ", err);
         return false;
     }
-    info("TRDP session opened on PD port " + std::to_string(config_.pdPort) + " and MD port " +
-         std::to_string(config_.mdPort));
+    info("TRDP session opened on PD port ", config_.pdPort, " and MD port ", config_.mdPort, ", cycle ",
+         config_.cycleTimeUs, " us");
 #endif
     opened_ = true;
     return true;
@@ -89,13 +125,28 @@ void TrdpSession::runOnce()
     {
         return;
     }
-    UINT32 intervalUs{0};
-    tlc_getInterval(appHandle_, &intervalUs);
     tlc_process(appHandle_);
-#else
-    // In stub mode we simply wait a little to simulate activity.
-    std::this_thread::sleep_for(std::chrono::milliseconds(50));
 #endif
+
+    // Pace the loop at the configured process cycle. After an overrun the schedule restarts
+    // from now rather than bursting through the missed cycles.
+    const auto now = std::chrono::steady_clock::now();
+    const auto period = std::chrono::microseconds(std::max<uint32_t>(config_.cycleTimeUs, 1000u));
+    if (nextCycle_ == std::chrono::steady_clock::time_point{})
+    {
+        nextCycle_ = now;
+        return;
+    }
+    nextCycle_ += period;
+    if (nextCycle_ < now)
+    {
+        cycleLateness_.observe(now - nextCycle_);
+        cycleOverruns_.add();
+        nextCycle_ = now;
+        return;
+    }
+    std::this_thread::sleep_until(nextCycle_);
+    cycleLateness_.observe(std::chrono::steady_clock::now() - nextCycle_);
 }
 
 void TrdpSession::runLoop(std::atomic_bool &runningFlag)
@@ -106,5 +157,14 @@ void TrdpSession::runLoop(std::atomic_bool &runningFlag)
     }
 }
 
+void TrdpSession::runLoop(std::atomic_bool &runningFlag, const std::function<void()> &afterCycle)
+{
+    while (runningFlag.load())
+    {
+        runOnce();
+        afterCycle();
+    }
+}
+
 } // namespace trdp
 
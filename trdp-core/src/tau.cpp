@@ -6,6 +6,98 @@
 
 namespace trdp
 {
+#ifdef TRDP_AVAILABLE
+namespace
+{
+using DatasetIndex = std::unordered_map<uint32_t, TRDP_DATASET_T *>;
+
+std::size_t wireTypeSize(UINT32 type)
+{
+    switch (type)
+    {
+    case TRDP_BITSET8:
+    case TRDP_CHAR8:
+    case TRDP_INT8:
+    case TRDP_UINT8:
+        return 1;
+    case TRDP_UTF16:
+    case TRDP_INT16:
+    case TRDP_UINT16:
+        return 2;
+    case TRDP_INT32:
+    case TRDP_UINT32:
+    case TRDP_REAL32:
+    case TRDP_TIMEDATE32:
+        return 4;
+    case TRDP_TIMEDATE48:
+        return 6;
+    case TRDP_INT64:
+    case TRDP_UINT64:
+    case TRDP_REAL64:
+    case TRDP_TIMEDATE64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+// Packed wire size of a dataset, following nested datasets. Returns 0 for variable-length
+// datasets (element size 0) since their size depends on the payload.
+std::size_t wireDatasetSize(const TRDP_DATASET_T *dataset, const DatasetIndex &index, int depth = 0)
+{
+    if (dataset == nullptr || depth > 16)
+    {
+        return 0u;
+    }
+
+    std::size_t total = 0;
+    for (UINT16 i = 0; i < dataset->numElement; ++i)
+    {
+        const auto &element = dataset->pElement[i];
+        if (element.size == 0u)
+        {
+            return 0u;
+        }
+
+        std::size_t elementSize = 0;
+        if (element.type <= TRDP_TYPE_MAX)
+        {
+            elementSize = wireTypeSize(element.type);
+        }
+        else
+        {
+            const auto nested = index.find(element.type);
+            elementSize = nested != index.end() ? wireDatasetSize(nested->second, index, depth + 1) : 0u;
+        }
+        if (elementSize == 0u)
+        {
+            return 0u;
+        }
+        total += elementSize * element.size;
+    }
+    return total;
+}
+
+// True if every nested dataset, at any depth, was resolved into pCachedDS. libtrdp looks
+// unresolved ones up in its global tables, which may belong to another marshaller.
+bool fullyResolved(const TRDP_DATASET_T *dataset, int depth = 0)
+{
+    if (dataset == nullptr || depth > 16)
+    {
+        return false;
+    }
+    for (UINT16 i = 0; i < dataset->numElement; ++i)
+    {
+        const auto &element = dataset->pElement[i];
+        if (element.type > TRDP_TYPE_MAX && !fullyResolved(element.pCachedDS, depth + 1))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+#endif
 
 TauMarshaller::TauMarshaller() = default;
 TauMarshaller::~TauMarshaller()
@@ -23,7 +115,7 @@ TauMarshaller::TauMarshaller(TauMarshaller &&other) noexcept
     numDatasets_ = other.numDatasets_;
     comIdMapRaw_ = other.comIdMapRaw_;
     datasetsRaw_ = other.datasetsRaw_;
-    comIdMap_ = std::move(other.comIdMap_);
+    bindings_ = std::move(other.bindings_);
 
     other.context_ = nullptr;
     other.comIdMapRaw_ = nullptr;
@@ -49,7 +141,7 @@ TauMarshaller &TauMarshaller::operator=(TauMarshaller &&other) noexcept
     numDatasets_ = other.numDatasets_;
     comIdMapRaw_ = other.comIdMapRaw_;
     datasetsRaw_ = other.datasetsRaw_;
-    comIdMap_ = std::move(other.comIdMap_);
+    bindings_ = std::move(other.bindings_);
 
     other.context_ = nullptr;
     other.comIdMapRaw_ = nullptr;
@@ -69,10 +161,37 @@ std::unique_ptr<TauMarshaller> TauMarshaller::createFromXml(const std::string &d
     const auto prepErr = tau_prepareXmlDoc(deviceFile.c_str(), &doc);
     if (prepErr != TRDP_NO_ERR)
     {
-        warn("tau_prepareXmlDoc failed for " + deviceFile + " (" + std::to_string(prepErr) + ")");
+        warn("tau_prepareXmlDoc failed for ", deviceFile, " (", prepErr, ")");
+        return nullptr;
+    }
+    return createFromDoc(doc);
+#else
+    (void)deviceFile;
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<TauMarshaller> TauMarshaller::createFromXmlBuffer(const char *xml, std::size_t size)
+{
+#ifdef TRDP_AVAILABLE
+    TRDP_XML_DOC_HANDLE_T doc{};
+    const auto prepErr = tau_prepareXmlMem(xml, size, &doc);
+    if (prepErr != TRDP_NO_ERR)
+    {
+        warn("tau_prepareXmlMem failed (", prepErr, ")");
         return nullptr;
     }
+    return createFromDoc(doc);
+#else
+    (void)xml;
+    (void)size;
+    return nullptr;
+#endif
+}
 
+#ifdef TRDP_AVAILABLE
+std::unique_ptr<TauMarshaller> TauMarshaller::createFromDoc(TRDP_XML_DOC_HANDLE_T &doc)
+{
     auto marshaller = std::unique_ptr<TauMarshaller>(new TauMarshaller());
     TRDP_COMID_DSID_MAP_T *comIdMap = nullptr;
     apTRDP_DATASET_T datasets = nullptr;
@@ -81,7 +200,7 @@ std::unique_ptr<TauMarshaller> TauMarshaller::createFromXml(const std::string &d
     tau_freeXmlDoc(&doc);
     if (readErr != TRDP_NO_ERR)
     {
-        warn("tau_readXmlDatasetConfig failed (" + std::to_string(readErr) + ")");
+        warn("tau_readXmlDatasetConfig failed (", readErr, ")");
         return nullptr;
     }
 
@@ -89,7 +208,7 @@ std::unique_ptr<TauMarshaller> TauMarshaller::createFromXml(const std::string &d
     const auto initErr = tau_initMarshall(&context, marshaller->numComIds_, comIdMap, marshaller->numDatasets_, datasets);
     if (initErr != TRDP_NO_ERR)
     {
-        warn("tau_initMarshall failed (" + std::to_string(initErr) + ")");
+        warn("tau_initMarshall failed (", initErr, ")");
         tau_freeXmlDatasetConfig(marshaller->numComIds_, comIdMap, marshaller->numDatasets_, datasets);
         return nullptr;
     }
@@ -97,15 +216,12 @@ std::unique_ptr<TauMarshaller> TauMarshaller::createFromXml(const std::string &d
     marshaller->context_ = context;
     marshaller->comIdMapRaw_ = comIdMap;
     marshaller->datasetsRaw_ = datasets;
-    marshaller->comIdMap_.assign(comIdMap, comIdMap + marshaller->numComIds_);
+    marshaller->buildBindings();
 
-    info("tau_marshall initialised for " + std::to_string(marshaller->numComIds_) + " ComIds from XML");
+    info("tau_marshall initialised for ", marshaller->numComIds_, " ComIds from XML");
     return marshaller;
-#else
-    (void)deviceFile;
-    return nullptr;
-#endif
 }
+#endif
 
 bool TauMarshaller::valid() const
 {
@@ -117,6 +233,44 @@ bool TauMarshaller::valid() const
 }
 
 bool TauMarshaller::marshall(uint32_t comId, const std::vector<uint8_t> &hostPayload, std::vector<uint8_t> &networkPayload) const
+{
+    const auto *resolved = binding(comId);
+    if (resolved == nullptr)
+    {
+#ifdef TRDP_AVAILABLE
+        static LogSite unknownSite("tau.marshall-comid");
+        warn(unknownSite, "tau_marshall: unknown ComId ", comId);
+#else
+        networkPayload = hostPayload;
+#endif
+        return false;
+    }
+    return marshall(*resolved, hostPayload, networkPayload);
+}
+
+bool TauMarshaller::marshall(const TauBinding &binding, const std::vector<uint8_t> &hostPayload, std::vector<uint8_t> &networkPayload) const
+{
+#ifdef TRDP_AVAILABLE
+    std::size_t written = std::max(binding.networkSize, hostPayload.size());
+    networkPayload.resize(written);
+    if (!marshall(binding, hostPayload.data(), hostPayload.size(), networkPayload.data(), written))
+    {
+        return false;
+    }
+    networkPayload.resize(written);
+    return true;
+#else
+    (void)binding;
+    networkPayload = hostPayload;
+    return false;
+#endif
+}
+
+bool TauMarshaller::marshall(const TauBinding &binding,
+                             const uint8_t *hostPayload,
+                             std::size_t hostSize,
+                             uint8_t *networkPayload,
+                             std::size_t &networkSize) const
 {
 #ifdef TRDP_AVAILABLE
     if (!valid())
@@ -125,32 +279,76 @@ bool TauMarshaller::marshall(uint32_t comId, const std::vector<uint8_t> &hostPay
         return false;
     }
 
-    if (datasetForComId(comId) == 0u)
+    if (binding.dataset == nullptr)
     {
-        warn("tau_marshall: unknown ComId " + std::to_string(comId));
+        // Without a resolved dataset libtrdp would search its global tables; see TauMarshaller.
+        static LogSite unresolvedSite("tau.marshall-unresolved");
+        warn(unresolvedSite, "tau_marshall: dataset of ComId ", binding.comId, " is not resolved");
         return false;
     }
 
-    UINT32 destSize = static_cast<UINT32>(hostPayload.size());
-    networkPayload.resize(hostPayload.size());
-    TRDP_DATASET_T *cached = nullptr;
-    const auto err = tau_marshall(context_, comId, hostPayload.data(), static_cast<UINT32>(hostPayload.size()),
-                                  networkPayload.data(), &destSize, &cached);
+    UINT32 destSize = static_cast<UINT32>(networkSize);
+    // Passing the pre-resolved dataset lets tau_marshall skip its own ComId search.
+    TRDP_DATASET_T *cached = binding.dataset;
+    const auto err = tau_marshall(context_, binding.comId, hostPayload, static_cast<UINT32>(hostSize), networkPayload,
+                                  &destSize, &cached);
     if (err != TRDP_NO_ERR)
     {
-        warn("tau_marshall failed for ComId " + std::to_string(comId) + " (" + std::to_string(err) + ")");
+        static LogSite failedSite("tau.marshall");
+        warn(failedSite, "tau_marshall failed for ComId ", binding.comId, " (", err, ")");
         return false;
     }
-    networkPayload.resize(destSize);
+    networkSize = destSize;
     return true;
 #else
-    (void)comId;
-    networkPayload = hostPayload;
+    (void)binding;
+    (void)hostPayload;
+    (void)hostSize;
+    (void)networkPayload;
+    (void)networkSize;
     return false;
 #endif
 }
 
 bool TauMarshaller::unmarshall(uint32_t comId, const std::vector<uint8_t> &networkPayload, std::vector<uint8_t> &hostPayload) const
+{
+    const auto *resolved = binding(comId);
+    if (resolved == nullptr)
+    {
+#ifdef TRDP_AVAILABLE
+        static LogSite unknownSite("tau.unmarshall-comid");
+        warn(unknownSite, "tau_unmarshall: unknown ComId ", comId);
+#else
+        hostPayload = networkPayload;
+#endif
+        return false;
+    }
+    return unmarshall(*resolved, networkPayload, hostPayload);
+}
+
+bool TauMarshaller::unmarshall(const TauBinding &binding, const std::vector<uint8_t> &networkPayload, std::vector<uint8_t> &hostPayload) const
+{
+#ifdef TRDP_AVAILABLE
+    std::size_t written = std::max(binding.hostSize, networkPayload.size());
+    hostPayload.resize(written);
+    if (!unmarshall(binding, networkPayload.data(), networkPayload.size(), hostPayload.data(), written))
+    {
+        return false;
+    }
+    hostPayload.resize(written);
+    return true;
+#else
+    (void)binding;
+    hostPayload = networkPayload;
+    return false;
+#endif
+}
+
+bool TauMarshaller::unmarshall(const TauBinding &binding,
+                               const uint8_t *networkPayload,
+                               std::size_t networkSize,
+                               uint8_t *hostPayload,
+                               std::size_t &hostSize) const
 {
 #ifdef TRDP_AVAILABLE
     if (!valid())
@@ -159,42 +357,142 @@ bool TauMarshaller::unmarshall(uint32_t comId, const std::vector<uint8_t> &netwo
         return false;
     }
 
-    UINT32 destSize = static_cast<UINT32>(networkPayload.size());
-    hostPayload.resize(networkPayload.size());
-    TRDP_DATASET_T *cached = nullptr;
-    const auto err = tau_unmarshall(context_, comId, const_cast<uint8_t *>(networkPayload.data()),
-                                    static_cast<UINT32>(networkPayload.size()), hostPayload.data(), &destSize, &cached);
+    if (binding.dataset == nullptr)
+    {
+        static LogSite unresolvedSite("tau.unmarshall-unresolved");
+        warn(unresolvedSite, "tau_unmarshall: dataset of ComId ", binding.comId, " is not resolved");
+        return false;
+    }
+
+    UINT32 destSize = static_cast<UINT32>(hostSize);
+    TRDP_DATASET_T *cached = binding.dataset;
+    const auto err = tau_unmarshall(context_, binding.comId, const_cast<uint8_t *>(networkPayload),
+                                    static_cast<UINT32>(networkSize), hostPayload, &destSize, &cached);
     if (err != TRDP_NO_ERR)
     {
-        warn("tau_unmarshall failed for ComId " + std::to_string(comId) + " (" + std::to_string(err) + ")");
+        static LogSite failedSite("tau.unmarshall");
+        warn(failedSite, "tau_unmarshall failed for ComId ", binding.comId, " (", err, ")");
         return false;
     }
-    hostPayload.resize(destSize);
+    hostSize = destSize;
     return true;
 #else
-    (void)comId;
-    hostPayload = networkPayload;
+    (void)binding;
+    (void)networkPayload;
+    (void)networkSize;
+    (void)hostPayload;
+    (void)hostSize;
     return false;
 #endif
 }
 
-uint16_t TauMarshaller::datasetForComId(uint32_t comId) const
+std::size_t TauMarshaller::marshalledSize(uint32_t comId) const
+{
+    const auto *resolved = binding(comId);
+    return resolved != nullptr ? resolved->networkSize : 0u;
+}
+
+const TauBinding *TauMarshaller::binding(uint32_t comId) const
 {
 #ifdef TRDP_AVAILABLE
-    const auto it = std::find_if(comIdMap_.begin(), comIdMap_.end(),
-                                 [&](const auto &entry) { return entry.comId == comId; });
-    if (it == comIdMap_.end())
+    const auto it = bindings_.find(comId);
+    if (it == bindings_.end())
     {
-        return 0u;
+        return nullptr;
     }
-    return static_cast<uint16_t>(it->datasetId);
+    return &it->second;
 #else
     (void)comId;
-    return 0u;
+    return nullptr;
 #endif
 }
 
+uint16_t TauMarshaller::datasetForComId(uint32_t comId) const
+{
+    const auto *resolved = binding(comId);
+    return resolved != nullptr ? resolved->datasetId : 0u;
+}
+
 #ifdef TRDP_AVAILABLE
+void TauMarshaller::buildBindings()
+{
+    DatasetIndex datasetsById;
+    datasetsById.reserve(numDatasets_);
+    for (uint32_t i = 0; i < numDatasets_; ++i)
+    {
+        if (datasetsRaw_[i] != nullptr)
+        {
+            datasetsById.emplace(datasetsRaw_[i]->id, datasetsRaw_[i]);
+        }
+    }
+
+    // tau_marshall resolves nested datasets lazily through libtrdp's global tables and caches
+    // them in the element table, which would make concurrent calls write to shared memory and
+    // read tables another marshaller may own. Resolve them all now instead.
+    for (uint32_t i = 0; i < numDatasets_; ++i)
+    {
+        auto *dataset = datasetsRaw_[i];
+        if (dataset == nullptr)
+        {
+            continue;
+        }
+        for (UINT16 e = 0; e < dataset->numElement; ++e)
+        {
+            auto &element = dataset->pElement[e];
+            if (element.type > TRDP_TYPE_MAX && element.pCachedDS == nullptr)
+            {
+                const auto nested = datasetsById.find(element.type);
+                if (nested != datasetsById.end())
+                {
+                    element.pCachedDS = nested->second;
+                }
+                else
+                {
+                    warn("Dataset ", dataset->id, " element ", e, " references unknown dataset ", element.type);
+                }
+            }
+        }
+    }
+
+    bindings_.clear();
+    bindings_.reserve(numComIds_);
+    for (uint32_t i = 0; i < numComIds_; ++i)
+    {
+        const auto &entry = comIdMapRaw_[i];
+        TauBinding binding;
+        binding.comId = entry.comId;
+        binding.datasetId = static_cast<uint16_t>(entry.datasetId);
+        const auto ds = datasetsById.find(entry.datasetId);
+        if (ds == datasetsById.end())
+        {
+            warn("ComId ", entry.comId, " references unknown dataset ", entry.datasetId);
+        }
+        else if (!fullyResolved(ds->second))
+        {
+            warn("ComId ", entry.comId, " uses dataset ", entry.datasetId,
+                 " with unresolved nested datasets; it will not be marshalled");
+        }
+        else
+        {
+            binding.dataset = ds->second;
+            binding.networkSize = wireDatasetSize(binding.dataset, datasetsById);
+        }
+
+        if (binding.networkSize != 0u)
+        {
+            std::vector<uint8_t> zeroPayload(binding.networkSize, 0u);
+            UINT32 hostSize = 0;
+            TRDP_DATASET_T *cached = binding.dataset;
+            if (tau_calcDatasetSizeByComId(context_, binding.comId, zeroPayload.data(),
+                                           static_cast<UINT32>(zeroPayload.size()), &hostSize, &cached) == TRDP_NO_ERR)
+            {
+                binding.hostSize = hostSize;
+            }
+        }
+        bindings_.emplace(binding.comId, binding);
+    }
+}
+
 void TauMarshaller::release()
 {
     if (comIdMapRaw_ != nullptr || datasetsRaw_ != nullptr)
@@ -207,7 +505,7 @@ void TauMarshaller::release()
     numDatasets_ = 0u;
     comIdMapRaw_ = nullptr;
     datasetsRaw_ = nullptr;
-    comIdMap_.clear();
+    bindings_.clear();
 }
 #endif
 
@@ -0,0 +1,73 @@
+#include "trdp/telegram_stats.hpp"
+
+#include <cstdio>
+#include <ostream>
+
+namespace trdp
+{
+
+std::string formatDuration(uint64_t us)
+{
+    char text[32];
+    if (us < 1000)
+    {
+        std::snprintf(text, sizeof(text), "%lluus", static_cast<unsigned long long>(us));
+    }
+    else if (us < 1000000)
+    {
+        std::snprintf(text, sizeof(text), "%.4gms", static_cast<double>(us) / 1e3);
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "%.4gs", static_cast<double>(us) / 1e6);
+    }
+    return text;
+}
+
+std::string formatDuration(std::chrono::steady_clock::duration duration)
+{
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    return formatDuration(static_cast<uint64_t>(us < 0 ? 0 : us));
+}
+
+std::vector<TelegramStats> carryStats(std::vector<TelegramStats> &previous, const std::vector<std::size_t> &from)
+{
+    std::vector<TelegramStats> next(from.size());
+    for (std::size_t i = 0; i < from.size(); ++i)
+    {
+        if (from[i] < previous.size())
+        {
+            next[i] = previous[from[i]];
+        }
+    }
+    return next;
+}
+
+void printDistribution(std::ostream &os, const char *label, const Histogram::Snapshot &snapshot, uint64_t maxUs)
+{
+    if (snapshot.count == 0)
+    {
+        return;
+    }
+    os << "    " << label << " n=" << snapshot.count << " mean=" << formatDuration(snapshot.sumUs / snapshot.count)
+       << " max=" << formatDuration(maxUs);
+    for (std::size_t i = 0; i < snapshot.buckets.size(); ++i)
+    {
+        if (snapshot.buckets[i] == 0)
+        {
+            continue;
+        }
+        if (i < snapshot.upperBoundsUs.size())
+        {
+            os << " <=" << formatDuration(snapshot.upperBoundsUs[i]);
+        }
+        else
+        {
+            os << " >" << formatDuration(snapshot.upperBoundsUs.back());
+        }
+        os << ":" << snapshot.buckets[i];
+    }
+    os << std::endl;
+}
+
+} // namespace trdp
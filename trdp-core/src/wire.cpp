@@ -0,0 +1,183 @@
+#include "trdp/wire.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace trdp
+{
+namespace
+{
+struct Crc32Table
+{
+    std::array<uint32_t, 256> entries{};
+
+    Crc32Table()
+    {
+        for (uint32_t i = 0; i < entries.size(); ++i)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 1u) != 0u ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+void putU16(uint8_t *out, uint16_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+}
+
+void putU32(uint8_t *out, uint32_t value)
+{
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+uint16_t getU16(const uint8_t *in)
+{
+    return static_cast<uint16_t>((in[0] << 8) | in[1]);
+}
+
+uint32_t getU32(const uint8_t *in)
+{
+    return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | static_cast<uint32_t>(in[3]);
+}
+
+void putUri(uint8_t *out, const std::string &uri)
+{
+    std::memset(out, 0, kMdUriSize);
+    std::memcpy(out, uri.data(), std::min(uri.size(), kMdUriSize));
+}
+
+std::string getUri(const uint8_t *in)
+{
+    const auto *end = std::find(in, in + kMdUriSize, uint8_t{0});
+    return std::string(in, end);
+}
+
+// The FCS is transmitted little-endian, matching the TRDP reference stack.
+void putFcs(uint8_t *out, uint32_t fcs)
+{
+    out[0] = static_cast<uint8_t>(fcs);
+    out[1] = static_cast<uint8_t>(fcs >> 8);
+    out[2] = static_cast<uint8_t>(fcs >> 16);
+    out[3] = static_cast<uint8_t>(fcs >> 24);
+}
+
+uint32_t getFcs(const uint8_t *in)
+{
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) | (static_cast<uint32_t>(in[2]) << 16) |
+           (static_cast<uint32_t>(in[3]) << 24);
+}
+
+} // namespace
+
+uint32_t crc32(const uint8_t *data, std::size_t size, uint32_t seed)
+{
+    static const Crc32Table table;
+    uint32_t crc = seed;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        crc = table.entries[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void encodeMdHeader(const MdHeader &header, std::array<uint8_t, kMdHeaderSize> &out)
+{
+    uint8_t *p = out.data();
+    putU32(p + 0, header.sequenceCounter);
+    putU16(p + 4, header.protocolVersion);
+    putU16(p + 6, static_cast<uint16_t>(header.msgType));
+    putU32(p + 8, header.comId);
+    putU32(p + 12, header.etbTopoCnt);
+    putU32(p + 16, header.opTrnTopoCnt);
+    putU32(p + 20, header.datasetLength);
+    putU32(p + 24, static_cast<uint32_t>(header.replyStatus));
+    std::memcpy(p + 28, header.sessionId.data(), header.sessionId.size());
+    putU32(p + 44, header.replyTimeoutUs);
+    putUri(p + 48, header.sourceUri);
+    putUri(p + 80, header.destinationUri);
+
+    putFcs(p + 112, crc32(p, kMdHeaderSize - 4u));
+}
+
+bool decodeMdHeader(const uint8_t *data, std::size_t size, MdHeader &out)
+{
+    if (size < kMdHeaderSize)
+    {
+        return false;
+    }
+
+    if (crc32(data, kMdHeaderSize - 4u) != getFcs(data + 112))
+    {
+        return false;
+    }
+
+    out.sequenceCounter = getU32(data + 0);
+    out.protocolVersion = getU16(data + 4);
+    if ((out.protocolVersion & 0xFF00u) != (kTrdpProtocolVersion & 0xFF00u))
+    {
+        return false;
+    }
+    out.msgType = static_cast<MdMessageType>(getU16(data + 6));
+    out.comId = getU32(data + 8);
+    out.etbTopoCnt = getU32(data + 12);
+    out.opTrnTopoCnt = getU32(data + 16);
+    out.datasetLength = getU32(data + 20);
+    out.replyStatus = static_cast<int32_t>(getU32(data + 24));
+    std::memcpy(out.sessionId.data(), data + 28, out.sessionId.size());
+    out.replyTimeoutUs = getU32(data + 44);
+    out.sourceUri = getUri(data + 48);
+    out.destinationUri = getUri(data + 80);
+    return true;
+}
+
+void encodePdHeader(const PdHeader &header, std::array<uint8_t, kPdHeaderSize> &out)
+{
+    uint8_t *p = out.data();
+    putU32(p + 0, header.sequenceCounter);
+    putU16(p + 4, header.protocolVersion);
+    putU16(p + 6, static_cast<uint16_t>(header.msgType));
+    putU32(p + 8, header.comId);
+    putU32(p + 12, header.etbTopoCnt);
+    putU32(p + 16, header.opTrnTopoCnt);
+    putU32(p + 20, header.datasetLength);
+    putU32(p + 24, header.reserved);
+    putU32(p + 28, header.replyComId);
+    putU32(p + 32, header.replyIpAddress);
+    putFcs(p + 36, crc32(p, kPdHeaderSize - 4u));
+}
+
+bool decodePdHeader(const uint8_t *data, std::size_t size, PdHeader &out)
+{
+    if (size < kPdHeaderSize || crc32(data, kPdHeaderSize - 4u) != getFcs(data + 36))
+    {
+        return false;
+    }
+
+    out.sequenceCounter = getU32(data + 0);
+    out.protocolVersion = getU16(data + 4);
+    if ((out.protocolVersion & 0xFF00u) != (kTrdpProtocolVersion & 0xFF00u))
+    {
+        return false;
+    }
+    out.msgType = static_cast<PdMessageType>(getU16(data + 6));
+    out.comId = getU32(data + 8);
+    out.etbTopoCnt = getU32(data + 12);
+    out.opTrnTopoCnt = getU32(data + 16);
+    out.datasetLength = getU32(data + 20);
+    out.reserved = getU32(data + 24);
+    out.replyComId = getU32(data + 28);
+    out.replyIpAddress = getU32(data + 32);
+    return true;
+}
+
+} // namespace trdp